@@ -38,6 +38,8 @@
 
 #include "face/null-face.hpp"
 
+#include "ns3/ndnSIM/utils/ndn-wq-traffic-class.hpp"
+
 namespace nfd {
 
 NFD_LOG_INIT(Forwarder);
@@ -78,10 +80,15 @@ Forwarder::Forwarder(FaceTable& faceTable)
       [this, &face] (const Interest& interest) {
         this->onDroppedInterest(interest, const_cast<Face&>(face));
       });
+    face.afterStateChange.connect(
+      [this, &face] (face::FaceState oldState, face::FaceState newState) {
+        this->afterFaceStateChange(face, oldState, newState);
+      });
   });
 
   m_faceTable.beforeRemove.connect([this] (const Face& face) {
     cleanupOnFaceRemoval(m_nameTree, m_fib, m_pit, face);
+    m_egressQueues.erase(face.getId());
   });
 
   m_fib.afterNewNextHop.connect([this] (const Name& prefix, const fib::NextHop& nextHop) {
@@ -93,6 +100,39 @@ Forwarder::Forwarder(FaceTable& faceTable)
 
 Forwarder::~Forwarder() = default;
 
+std::vector<Forwarder::Neighbour>
+Forwarder::getNeighbours() const
+{
+  std::vector<Neighbour> neighbours;
+  for (const fib::Entry& entry : m_fib) {
+    const fib::NextHopList& nextHops = entry.getNextHops();
+    if (nextHops.empty() || nextHops.front().getCost() != 1) {
+      continue;
+    }
+    neighbours.push_back({entry.getPrefix().toUri(), nextHops.front().getFace().getId(),
+                          nextHops.front().getCost()});
+  }
+  return neighbours;
+}
+
+std::vector<Forwarder::Introspection>
+Forwarder::introspect(const std::vector<Interest>& interests) const
+{
+  std::vector<Introspection> result(interests.size());
+  for (size_t i = 0; i < interests.size(); ++i) {
+    shared_ptr<pit::Entry> pitEntry = m_pit.find(interests[i]);
+    if (pitEntry != nullptr) {
+      for (const pit::InRecord& inRecord : pitEntry->getInRecords()) {
+        result[i].pitInFaces.push_back(inRecord.getFace().getId());
+      }
+    }
+    for (const fib::NextHop& nextHop : m_fib.findLongestPrefixMatch(interests[i].getName()).getNextHops()) {
+      result[i].fibNextHops.push_back(nextHop.getFace().getId());
+    }
+  }
+  return result;
+}
+
 void
 Forwarder::onIncomingInterest(const Interest& interest, const FaceEndpoint& ingress)
 {
@@ -130,6 +170,8 @@ Forwarder::onIncomingInterest(const Interest& interest, const FaceEndpoint& ingr
       neiData->setContent(buffer);
       ingress.face.sendData(cref(*neiData));
       // ingress.face.sendData(cref(*neiData), ingress.endpoint);
+      // answered here, a PIT entry for the probe would only wait to expire
+      return;
     }
     else if (gotInterest[1] == 'f')
     {
@@ -164,6 +206,7 @@ Forwarder::onIncomingInterest(const Interest& interest, const FaceEndpoint& ingr
       fibData->setContent(buffer);
       ingress.face.sendData(cref(*fibData));
       //std::cout<< "receive Fib" <<std::endl;
+      return;
 
     }
     else if (gotInterest[1] == 'p' && gotInterest[2] == '-')
@@ -180,11 +223,13 @@ Forwarder::onIncomingInterest(const Interest& interest, const FaceEndpoint& ingr
       shared_ptr<pit::Entry> searchPit = m_pit.find(cref(*checkPitInterest));
       // std::cout << "pit find flag: " << searchPit->getName() << std::endl;
       uint64_t searchPitFaceId = 0;
-      for (const pit::InRecord& searchInRecord : searchPit->getInRecords()) 
-      {
-        Face* searchPitFace = &searchInRecord.getFace();
-        searchPitFaceId = searchPitFace->getId();
-        // std::cout << "pit find face: " << searchPitFaceId << std::endl;
+      if (searchPit != nullptr) {
+        for (const pit::InRecord& searchInRecord : searchPit->getInRecords()) 
+        {
+          Face* searchPitFace = &searchInRecord.getFace();
+          searchPitFaceId = searchPitFace->getId();
+          // std::cout << "pit find face: " << searchPitFaceId << std::endl;
+        }
       }
       Name pitDataName(interest.getName());
       auto pitData = make_shared<Data>();
@@ -194,7 +239,7 @@ Forwarder::onIncomingInterest(const Interest& interest, const FaceEndpoint& ingr
       auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
       pitData->setContent(buffer);
       ingress.face.sendData(cref(*pitData));
-
+      return;
     };
   };
 
@@ -377,8 +422,13 @@ Forwarder::onOutgoingInterest(const Interest& interest, Face& egress,
   auto it = pitEntry->insertOrUpdateOutRecord(egress, interest);
   BOOST_ASSERT(it != pitEntry->out_end());
 
-  // send Interest
-  egress.sendInterest(interest);
+  // send Interest, local app faces are not paced
+  if (m_config.dataEgressRate > 0 && egress.getScope() == ndn::nfd::FACE_SCOPE_NON_LOCAL) {
+    sendWithPriority(egress, make_shared<Interest>(interest), nullptr);
+  }
+  else {
+    egress.sendInterest(interest);
+  }
   ++m_counters.nOutInterests;
   return &*it;
 }
@@ -537,10 +587,13 @@ Forwarder::onOutgoingData(const Data& data, Face& egress)
     return false;
   }
 
-  // TODO traffic manager
-
-  // send Data
-  egress.sendData(data);
+  // send Data, local app faces are not paced
+  if (m_config.dataEgressRate > 0 && egress.getScope() == ndn::nfd::FACE_SCOPE_NON_LOCAL) {
+    sendWithPriority(egress, nullptr, make_shared<Data>(data));
+  }
+  else {
+    egress.sendData(data);
+  }
   ++m_counters.nOutData;
 
   return true;
@@ -649,6 +702,76 @@ Forwarder::onOutgoingNack(const lp::NackHeader& nack, Face& egress,
   return true;
 }
 
+void
+Forwarder::sendWithPriority(Face& egress, shared_ptr<const Interest> interest, shared_ptr<const Data> data)
+{
+  const Name& name = interest != nullptr ? interest->getName() : data->getName();
+  EgressQueue& queue = m_egressQueues[egress.getId()];
+  auto now = time::steady_clock::now();
+  auto slot = time::duration_cast<time::nanoseconds>(time::duration<double>(1.0 / m_config.dataEgressRate));
+
+  // the message keyword starts a component, match component prefixes instead of scanning the URI
+  bool isControl = false;
+  for (size_t i = 0; i < name.size() && !isControl; ++i) {
+    isControl = ::ns3::ndn::WqTrafficClass::IsControlComponent(
+                  std::string(reinterpret_cast<const char*>(name[i].value()), name[i].value_size()));
+  }
+
+  if (isControl) {
+    // overtake queued data, which then waits one more slot
+    NFD_LOG_DEBUG("sendWithPriority out=" << egress.getId() << " control=" << name
+                  << " queued=" << queue.packets.size());
+    if (interest != nullptr) {
+      egress.sendInterest(*interest);
+    }
+    else {
+      egress.sendData(*data);
+    }
+    queue.nextSlot = std::max(queue.nextSlot, now) + slot;
+    return;
+  }
+
+  queue.packets.emplace_back(interest, data);
+  if (!queue.isDraining) {
+    drainEgressQueue(egress.getId());
+  }
+}
+
+void
+Forwarder::drainEgressQueue(FaceId faceId)
+{
+  auto it = m_egressQueues.find(faceId);
+  if (it == m_egressQueues.end()) {
+    return;
+  }
+  EgressQueue& queue = it->second;
+  queue.isDraining = false;
+  Face* egress = m_faceTable.get(faceId);
+  if (egress == nullptr || queue.packets.empty()) {
+    return;
+  }
+
+  auto now = time::steady_clock::now();
+  if (queue.nextSlot <= now) {
+    auto packet = queue.packets.front();
+    queue.packets.pop_front();
+    if (packet.first != nullptr) {
+      egress->sendInterest(*packet.first);
+    }
+    else {
+      egress->sendData(*packet.second);
+    }
+    auto slot = time::duration_cast<time::nanoseconds>(time::duration<double>(1.0 / m_config.dataEgressRate));
+    queue.nextSlot = now + slot;
+    if (queue.packets.empty()) {
+      return;
+    }
+  }
+
+  queue.isDraining = true;
+  queue.drainEvent = getScheduler().schedule(queue.nextSlot - now, [this, faceId] { drainEgressQueue(faceId); });
+}
+
 void
 Forwarder::onDroppedInterest(const Interest& interest, Face& egress)
 {
@@ -738,6 +861,9 @@ Forwarder::processConfig(const ConfigSection& configSection, bool isDryRun, cons
     if (key == "default_hop_limit") {
       config.defaultHopLimit = ConfigFile::parseNumber<uint8_t>(pair, CFG_FORWARDER);
     }
+    else if (key == "data_egress_rate") {
+      config.dataEgressRate = ConfigFile::parseNumber<double>(pair, CFG_FORWARDER);
+    }
     else {
       NDN_THROW(ConfigFile::Error("Unrecognized option " + CFG_FORWARDER + "." + key));
     }
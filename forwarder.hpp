@@ -39,6 +39,8 @@
 #include "table/dead-nonce-list.hpp"
 #include "table/network-region-table.hpp"
 
+#include <deque>
+
 namespace nfd {
 
 namespace fw {
@@ -131,6 +133,48 @@ public:
   void
   setConfigFile(ConfigFile& configFile);
 
+  /** \brief pace data-class packets on every non-local face at \p rate packets/s, so that
+   *         control-class (recovery) packets overtake them; 0 disables the priority egress
+   */
+  void
+  setDataEgressRate(double rate)
+  {
+    m_config.dataEgressRate = rate;
+  }
+
+  /** \brief a directly connected node, as seen from the FIB
+   */
+  struct Neighbour
+  {
+    std::string name;
+    FaceId faceId;
+    uint64_t cost;
+  };
+
+  /** \brief one-hop neighbours of this node in a single FIB walk
+   *
+   *  A prefix counts as a neighbour when its best next hop (the front of its next hop list)
+   *  has cost 1; faceId and cost are those of that next hop.
+   */
+  std::vector<Neighbour>
+  getNeighbours() const;
+
+  /** \brief local PIT and FIB state of one name, as the "/p-" and "/f-" probes report it
+   */
+  struct Introspection
+  {
+    std::vector<FaceId> pitInFaces;  ///< in-records of the pending Interest, oldest first; empty when none
+    std::vector<FaceId> fibNextHops; ///< next hops of the longest FIB match, best first
+  };
+
+  /** \brief PIT in-record faces and FIB next hops of many Interests in one call
+   *
+   *  Apps share the node with the forwarder, so this replaces a probe Interest per name and
+   *  the synthetic Data answering it. Nothing is inserted into the PIT.
+   */
+  std::vector<Introspection>
+  introspect(const std::vector<Interest>& interests) const;
+
 public:
   /** \brief trigger before PIT entry is satisfied
    *  \sa Strategy::beforeSatisfyInterest
@@ -150,6 +194,13 @@ public:
    */
   signal::Signal<Forwarder, Interest> afterCsMiss;
 
+  /** \brief state change of any face of the face table (old state, new state)
+   *
+   *  Lets apps on the node follow link up/down as the link layer reports it, without
+   *  connecting to every face themselves.
+   */
+  signal::Signal<Forwarder, Face, face::FaceState, face::FaceState> afterFaceStateChange;
+
 NFD_PUBLIC_WITH_TESTS_ELSE_PRIVATE: // pipelines
   /** \brief incoming Interest pipeline
    *  \param interest the incoming Interest, must be well-formed and created with make_shared
@@ -242,6 +293,17 @@ private:
   processConfig(const ConfigSection& configSection, bool isDryRun,
                 const std::string& filename);
 
+  /** \brief strict-priority egress: control-class packets leave at once and take a slot,
+   *         data-class packets wait in the face queue for the next free slot
+   *  \param interest the Interest to send, or null
+   *  \param data the Data to send, or null
+   */
+  void
+  sendWithPriority(Face& egress, shared_ptr<const Interest> interest, shared_ptr<const Data> data);
+
+  void
+  drainEgressQueue(FaceId faceId);
+
 NFD_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   /**
    * \brief Configuration options from "forwarder" section
@@ -251,6 +313,10 @@ NFD_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
     /// Initial value of HopLimit that should be added to Interests that don't have one.
     /// A value of zero disables the feature.
     uint8_t defaultHopLimit = 0;
+
+    /// Data-class packets per second per face under priority egress.
+    /// A value of zero sends every packet at once.
+    double dataEgressRate = 0;
   };
   Config m_config;
 
@@ -270,6 +336,15 @@ private:
   NetworkRegionTable m_networkRegionTable;
   shared_ptr<Face>   m_csFace;
 
+  struct EgressQueue
+  {
+    std::deque<std::pair<shared_ptr<const Interest>, shared_ptr<const Data>>> packets;
+    time::steady_clock::TimePoint nextSlot;
+    scheduler::ScopedEventId drainEvent;
+    bool isDraining = false;
+  };
+  std::map<FaceId, EgressQueue> m_egressQueues;
+
   // allow Strategy (base class) to enter pipelines
   friend class fw::Strategy;
 };
@@ -21,10 +21,21 @@
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+
+#include "utils/ndn-wq-traffic-class.hpp"
+#include "ndn-wq-node-registry.hpp"
+#include "ndn-wq-tree-cache.hpp"
 
 #include "model/ndn-l3-protocol.hpp"
 #include "model/ndn-app-link-service.hpp"
 #include "model/null-transport.hpp"
+#include "NFD/daemon/fw/forwarder.hpp"
+
+#include <algorithm>
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE("ndn.App");
 
@@ -41,6 +52,22 @@ App::GetTypeId(void)
                         .SetParent<Application>()
                         .AddConstructor<App>()
 
+                        .AddAttribute("ControlLifetime", "Lifetime of recovery (control class) Interests",
+                                      TimeValue(Seconds(1)), MakeTimeAccessor(&App::m_controlLifetime),
+                                      MakeTimeChecker())
+                        .AddAttribute("DataLifetime", "Lifetime of data class Interests",
+                                      TimeValue(Seconds(1)), MakeTimeAccessor(&App::m_dataLifetime),
+                                      MakeTimeChecker())
+                        .AddAttribute("TreeCacheDir", "Directory of the per-node tree cache, empty for no warm start",
+                                      StringValue(""), MakeStringAccessor(&App::m_treeCacheDir),
+                                      MakeStringChecker())
+                        .AddAttribute("HeartbeatInterval", "Beacon interval to a silent tree neighbour, 0 disables the detector",
+                                      TimeValue(Seconds(1)), MakeTimeAccessor(&App::m_heartbeatInterval),
+                                      MakeTimeChecker())
+                        .AddAttribute("PhiThreshold", "Suspicion level above which a tree neighbour is taken as crashed",
+                                      DoubleValue(8.0), MakeDoubleAccessor(&App::m_phiThreshold),
+                                      MakeDoubleChecker<double>(0.0))
+
                         .AddTraceSource("ReceivedInterests", "ReceivedInterests",
                                         MakeTraceSourceAccessor(&App::m_receivedInterests),
                                         "ns3::ndn::App::InterestTraceCallback")
@@ -71,6 +98,7 @@ App::App()
   : m_active(false)
   , m_face(0)
   , m_appId(std::numeric_limits<uint32_t>::max())
+  , m_allNodeName(WqNodeRegistry::Get().GetNames())
 {
 }
 
@@ -78,26 +106,173 @@ App::~App()
 {
 }
 
+int64_t
+App::AssignStreams(int64_t)
+{
+  return 0;
+}
+
+time::milliseconds
+App::GetClassLifetime(const std::string& name) const
+{
+  if (WqTrafficClass::Classify(name) == WqTrafficClass::CONTROL) {
+    return time::milliseconds(m_controlLifetime.GetMilliSeconds());
+  }
+  return time::milliseconds(m_dataLifetime.GetMilliSeconds());
+}
+
+std::vector<std::string>
+App::GetOneHopNeighbours() const
+{
+  std::vector<std::string> neighbours;
+  std::vector<nfd::Forwarder::Neighbour> fibNeighbours =
+    GetNode()->GetObject<L3Protocol>()->getForwarder()->getNeighbours();
+  for (uint64_t i = 0; i < fibNeighbours.size(); i++) {
+    // only nodes of the cluster, as the "/nei-" probes did
+    if (std::find(m_allNodeName.begin(), m_allNodeName.end(), fibNeighbours[i].name) != m_allNodeName.end()) {
+      neighbours.push_back(fibNeighbours[i].name);
+    }
+  }
+  return neighbours;
+}
+
+std::string
+App::GetTreeParent(const std::string& root, uint64_t& faceId) const
+{
+  shared_ptr<nfd::Forwarder> forwarder = GetNode()->GetObject<L3Protocol>()->getForwarder();
+  const nfd::fib::NextHopList& nextHops = forwarder->getFib().findLongestPrefixMatch(Name(root)).getNextHops();
+  if (nextHops.empty()) {
+    return "";
+  }
+  faceId = nextHops.front().getFace().getId();
+  std::vector<nfd::Forwarder::Neighbour> fibNeighbours = forwarder->getNeighbours();
+  for (uint64_t i = 0; i < fibNeighbours.size(); i++) {
+    if (fibNeighbours[i].faceId == faceId) {
+      return fibNeighbours[i].name;
+    }
+  }
+  return "";
+}
+
+uint64_t
+App::GetRouteCostVia(const std::string& root, const std::string& name) const
+{
+  shared_ptr<nfd::Forwarder> forwarder = GetNode()->GetObject<L3Protocol>()->getForwarder();
+  std::vector<nfd::Forwarder::Neighbour> fibNeighbours = forwarder->getNeighbours();
+  uint64_t faceId = 0;
+  bool found = false;
+  for (uint64_t i = 0; i < fibNeighbours.size() && !found; i++) {
+    if (fibNeighbours[i].name == name) {
+      faceId = fibNeighbours[i].faceId;
+      found = true;
+    }
+  }
+  if (found) {
+    const nfd::fib::NextHopList& nextHops = forwarder->getFib().findLongestPrefixMatch(Name(root)).getNextHops();
+    for (nfd::fib::NextHopList::const_iterator it = nextHops.begin(); it != nextHops.end(); ++it) {
+      if (it->getFace().getId() == faceId) {
+        return it->getCost();
+      }
+    }
+  }
+  return std::numeric_limits<uint64_t>::max();
+}
+
+std::vector<uint64_t>
+App::GetFibCosts(const std::vector<std::string>& names) const
+{
+  shared_ptr<nfd::Forwarder> forwarder = GetNode()->GetObject<L3Protocol>()->getForwarder();
+  std::vector<uint64_t> costs;
+  for (uint64_t i = 0; i < names.size(); i++) {
+    const nfd::fib::NextHopList& nextHops = forwarder->getFib().findLongestPrefixMatch(Name(names[i])).getNextHops();
+    costs.push_back(nextHops.empty() ? 0 : nextHops.front().getCost());
+  }
+  return costs;
+}
+
+std::vector<uint64_t>
+App::GetPitInFaces(const std::vector<shared_ptr<const Interest>>& interests) const
+{
+  std::vector<Interest> query;
+  for (uint64_t i = 0; i < interests.size(); i++) {
+    query.push_back(*interests[i]);
+  }
+  std::vector<nfd::Forwarder::Introspection> state =
+    GetNode()->GetObject<L3Protocol>()->getForwarder()->introspect(query);
+  std::vector<uint64_t> faces;
+  for (uint64_t i = 0; i < state.size(); i++) {
+    faces.push_back(state[i].pitInFaces.empty() ? 0 : state[i].pitInFaces.back());
+  }
+  return faces;
+}
+
+uint64_t
+App::GetFibFace(const std::string& name) const
+{
+  std::vector<Interest> query(1, Interest(Name(name)));
+  std::vector<nfd::Forwarder::Introspection> state =
+    GetNode()->GetObject<L3Protocol>()->getForwarder()->introspect(query);
+  if (state[0].fibNextHops.empty()) {
+    return 0;
+  }
+  return state[0].fibNextHops.front();
+}
+
+std::string
+App::GetTopologyFingerprint(const std::string& sink) const
+{
+  std::vector<std::string> parts(m_allNodeName.begin(), m_allNodeName.end());
+  std::vector<std::string> neighbours = GetOneHopNeighbours();
+  parts.push_back(WqTreeCache::JoinNames(neighbours));
+  uint64_t faceId = 0;
+  parts.push_back(GetTreeParent(sink, faceId));
+  return WqTreeCache::Fingerprint(parts);
+}
+
+bool
+App::IsNeighbourUp(const std::string& name) const
+{
+  std::vector<nfd::Forwarder::Neighbour> fibNeighbours =
+    GetNode()->GetObject<L3Protocol>()->getForwarder()->getNeighbours();
+  for (uint64_t i = 0; i < fibNeighbours.size(); i++) {
+    if (fibNeighbours[i].name == name) {
+      return fibNeighbours[i].faceId >= m_faceUp.size() || m_faceUp[fibNeighbours[i].faceId];
+    }
+  }
+  return false;
+}
+
 void
-App::DoInitialize()
+App::OnNeighbourLinkChange(const std::string&, bool)
 {
-  NS_LOG_FUNCTION_NOARGS();
+}
 
-  m_allNodeName.push_back("/m1-");
-  m_allNodeName.push_back("/m2-");
-  m_allNodeName.push_back("/m3-");
-  m_allNodeName.push_back("/m4-");
-  m_allNodeName.push_back("/m5-");
-  m_allNodeName.push_back("/m6-");
-  m_allNodeName.push_back("/m7-");
-
-   for(int i =0; i< 7; i++)
-  {
-    std::string iString = std::to_string(i);
-    std::string nodeName = "/" +iString +"-";
-    m_allNodeName.push_back(nodeName);
+void
+App::OnFaceStateChange(uint64_t faceId, bool up)
+{
+  if (faceId >= m_faceUp.size()) {
+    m_faceUp.resize(faceId + 1, true);
   }
+  if (m_faceUp[faceId] == up) {
+    return;
+  }
+  m_faceUp[faceId] = up;
+
+  std::vector<nfd::Forwarder::Neighbour> fibNeighbours =
+    GetNode()->GetObject<L3Protocol>()->getForwarder()->getNeighbours();
+  for (uint64_t i = 0; i < fibNeighbours.size(); i++) {
+    if (fibNeighbours[i].faceId == faceId
+        && std::find(m_allNodeName.begin(), m_allNodeName.end(), fibNeighbours[i].name) != m_allNodeName.end()) {
+      NS_LOG_DEBUG("link to " << fibNeighbours[i].name << (up ? " up" : " down"));
+      OnNeighbourLinkChange(fibNeighbours[i].name, up);
+    }
+  }
+}
 
+void
+App::DoInitialize()
+{
+  NS_LOG_FUNCTION_NOARGS();
 
   // find out what is application id on the node
   for (uint32_t id = 0; id < GetNode()->GetNApplications(); ++id) {
@@ -172,6 +347,14 @@ App::StartApplication() // Called at time specified by Start
 
   // step 2. Add face to the Ndn stack
   GetNode()->GetObject<L3Protocol>()->addFace(m_face);
+
+  // step 3. Follow link state through the forwarder instead of polling
+  m_faceStateConn = GetNode()->GetObject<L3Protocol>()->getForwarder()->afterFaceStateChange.connect(
+    [this] (const nfd::Face& face, nfd::face::FaceState oldState, nfd::face::FaceState newState) {
+      if (newState == nfd::face::FaceState::UP || newState == nfd::face::FaceState::DOWN) {
+        this->OnFaceStateChange(face.getId(), newState == nfd::face::FaceState::UP);
+      }
+    });
 }
 
 void
@@ -183,6 +366,7 @@ App::StopApplication() // Called at time specified by Stop
     return; // don't assert here, just return
 
   m_active = false;
+  m_faceStateConn.disconnect();
 
   m_face->close();
 }
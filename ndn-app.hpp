@@ -26,6 +26,7 @@
 
 #include "ns3/application.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
 #include "ns3/callback.h"
 #include "ns3/traced-callback.h"
 
@@ -80,6 +81,84 @@ public:
   virtual void
   OnNack(shared_ptr<const lp::Nack> nack);
 
+  /**
+   * @brief Interest lifetime for the traffic class of @p name (ControlLifetime or DataLifetime)
+   */
+  time::milliseconds
+  GetClassLifetime(const std::string& name) const;
+
+  /**
+   * @brief Assign fixed stream numbers to the random variables of the app
+   * @return number of streams used, the next app starts at @p stream plus that
+   */
+  virtual int64_t
+  AssignStreams(int64_t stream);
+
+  /**
+   * @brief One-hop neighbours among m_allNodeName, read from the local forwarder in one call
+   */
+  std::vector<std::string>
+  GetOneHopNeighbours() const;
+
+  /**
+   * @brief Neighbour on the FIB next hop towards @p root, the upstream of this node in the tree of @p root
+   * @param faceId set to the id of that face
+   * @return empty when there is no route or the next hop is not a neighbour
+   */
+  std::string
+  GetTreeParent(const std::string& root, uint64_t& faceId) const;
+
+  /**
+   * @brief FIB cost of reaching @p root through neighbour @p name, used to rank backup parents
+   * @return the largest cost when the FIB has no next hop towards @p root over that neighbour
+   */
+  uint64_t
+  GetRouteCostVia(const std::string& root, const std::string& name) const;
+
+  /**
+   * @brief Cost of the best FIB next hop towards each of @p names, 0 when there is no route.
+   *        Read from the local FIB in one call instead of a probe Interest per name
+   */
+  std::vector<uint64_t>
+  GetFibCosts(const std::vector<std::string>& names) const;
+
+  /**
+   * @brief Face each of @p interests last came in on, as recorded in the local PIT, 0 when it is
+   *        not pending. One forwarder call for all of them instead of a "/p-" probe each
+   */
+  std::vector<uint64_t>
+  GetPitInFaces(const std::vector<shared_ptr<const Interest>>& interests) const;
+
+  /**
+   * @brief Best FIB next hop towards @p name, 0 when there is no route. Replaces the "/f-" probe
+   */
+  uint64_t
+  GetFibFace(const std::string& name) const;
+
+  /**
+   * @brief Local view of the topology for the tree of @p sink: cluster names, neighbours and
+   *        the upstream towards @p sink, hashed. Keys the tree cache of the node.
+   */
+  std::string
+  GetTopologyFingerprint(const std::string& sink) const;
+
+  /**
+   * @brief Link state of the face towards neighbour @p name, as last signalled by the forwarder
+   */
+  bool
+  IsNeighbourUp(const std::string& name) const;
+
+protected:
+  /**
+   * @brief Called when the face towards a cluster neighbour goes down or comes back up
+   */
+  virtual void
+  OnNeighbourLinkChange(const std::string& name, bool up);
+
+private:
+  void
+  OnFaceStateChange(uint64_t faceId, bool up);
+
 public:
   typedef void (*InterestTraceCallback)(shared_ptr<const Interest>, Ptr<App>, shared_ptr<Face>);
   typedef void (*DataTraceCallback)(shared_ptr<const Data>, Ptr<App>, shared_ptr<Face>);
@@ -105,7 +184,14 @@ protected:
   AppLinkService* m_appLink;
 
   uint32_t m_appId;
-  std::vector<std::string> m_allNodeName;
+  const std::vector<std::string>& m_allNodeName; ///< @brief Names of the shared WqNodeRegistry, filled by the scenario
+  Time m_controlLifetime; ///< @brief Lifetime of recovery Interests
+  Time m_dataLifetime;    ///< @brief Lifetime of other Interests sent through the generic send helpers
+  std::string m_treeCacheDir; ///< @brief Directory of the tree cache files, empty disables warm start
+  std::vector<bool> m_faceUp; ///< @brief Link state per FaceId, faces never signalled count as up
+  nfd::signal::ScopedConnection m_faceStateConn;
+  Time m_heartbeatInterval; ///< @brief Beacon interval of the tree neighbour failure detector
+  double m_phiThreshold;    ///< @brief Phi above which a silent tree neighbour is suspected
 
 
   TracedCallback<shared_ptr<const Interest>, Ptr<App>, shared_ptr<Face>>
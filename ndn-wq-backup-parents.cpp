@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ndn-wq-backup-parents.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+WqBackupParents::WqBackupParents()
+  : m_offers(0)
+{
+}
+
+void
+WqBackupParents::Offer(const std::string& tree, const std::string& nei, uint64_t cost)
+{
+  Remove(tree, nei);
+  Candidate candidate;
+  candidate.name = nei;
+  candidate.cost = cost;
+  candidate.order = m_offers++;
+
+  // a handful of neighbours per tree, keep the list sorted on insert
+  std::vector<Candidate>& ranked = m_trees[tree];
+  std::vector<Candidate>::iterator it = ranked.begin();
+  while (it != ranked.end() && it->cost <= cost) {
+    ++it;
+  }
+  ranked.insert(it, candidate);
+}
+
+void
+WqBackupParents::Remove(const std::string& tree, const std::string& nei)
+{
+  std::map<std::string, std::vector<Candidate> >::iterator t = m_trees.find(tree);
+  if (t == m_trees.end()) {
+    return;
+  }
+  for (std::vector<Candidate>::iterator it = t->second.begin(); it != t->second.end(); ++it) {
+    if (it->name == nei) {
+      t->second.erase(it);
+      break;
+    }
+  }
+}
+
+void
+WqBackupParents::Clear(const std::string& tree)
+{
+  m_trees.erase(tree);
+}
+
+std::vector<std::string>
+WqBackupParents::Get(const std::string& tree) const
+{
+  std::vector<std::string> names;
+  std::map<std::string, std::vector<Candidate> >::const_iterator t = m_trees.find(tree);
+  if (t != m_trees.end()) {
+    for (uint64_t i = 0; i < t->second.size(); i++) {
+      names.push_back(t->second[i].name);
+    }
+  }
+  return names;
+}
+
+} // namespace ndn
+} // namespace ns3
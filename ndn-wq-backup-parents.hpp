@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef NDN_WQ_BACKUP_PARENTS_H
+#define NDN_WQ_BACKUP_PARENTS_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Ranked backup parents of a node, per tree
+ *
+ * Filled while the tree is discovered: every tree neighbour that offers itself as
+ * upstream but is not the one chosen is kept here, ranked by its route cost to the
+ * tree root and then by the order its discover arrived. On upstream failure the node
+ * asks the first candidate only and falls through the list on rejection. Candidates
+ * are not re-checked here, the owner drops those it finds stale when walking the list.
+ */
+class WqBackupParents {
+public:
+  WqBackupParents();
+
+  /**
+   * @brief Add @p nei as a candidate of @p tree, or re-rank it when already known
+   */
+  void
+  Offer(const std::string& tree, const std::string& nei, uint64_t cost);
+
+  void
+  Remove(const std::string& tree, const std::string& nei);
+
+  void
+  Clear(const std::string& tree);
+
+  /**
+   * @brief Candidates of @p tree, best first
+   */
+  std::vector<std::string>
+  Get(const std::string& tree) const;
+
+private:
+  struct Candidate
+  {
+    std::string name;
+    uint64_t cost;
+    uint64_t order;
+  };
+
+  std::map<std::string, std::vector<Candidate> > m_trees;
+  uint64_t m_offers;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
@@ -78,6 +78,17 @@ WqCentralUser::WqCentralUser()
   m_taskPrefix2 = "-";
 }
 
+int64_t
+WqCentralUser::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  if (m_random != 0) {
+    m_random->SetStream(stream + 1);
+    return 2;
+  }
+  return 1;
+}
+
 
 void
 WqCentralUser::SendPacket()
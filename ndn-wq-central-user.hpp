@@ -52,6 +52,9 @@ public:
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
 
+  virtual int64_t
+  AssignStreams(int64_t stream);
+
   /**
    * \brief Constructs the Interest packet and sends it using a callback to the underlying NDN
    * protocol
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ndn-wq-checkpoint-codec.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+void
+WqCheckpointCodec::AppendVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back((char)((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+bool
+WqCheckpointCodec::ReadVarint(const std::string& in, uint64_t& pos, uint64_t& value)
+{
+  value = 0;
+  int shift = 0;
+  while (pos < in.size() && shift < 64) {
+    uint8_t b = (uint8_t)in[pos++];
+    value |= (uint64_t)(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+    shift += 7;
+  }
+  return false;
+}
+
+std::string
+WqCheckpointCodec::EncodeRecord(bool full, const std::map<uint64_t, int64_t>& entries,
+                                const std::vector<uint64_t>& removed)
+{
+  std::string out;
+  AppendVarint(out, full ? 1 : 0);
+
+  // std::map keeps seqs sorted, so every delta is positive and mostly 1
+  AppendVarint(out, entries.size());
+  uint64_t preSeq = 0;
+  for (std::map<uint64_t, int64_t>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+    AppendVarint(out, it->first - preSeq);
+    preSeq = it->first;
+    // zigzag, small negative values stay short
+    AppendVarint(out, ((uint64_t)it->second << 1) ^ (uint64_t)(it->second >> 63));
+  }
+
+  AppendVarint(out, removed.size());
+  preSeq = 0;
+  for (uint64_t i = 0; i < removed.size(); i++) {
+    AppendVarint(out, removed[i] - preSeq);
+    preSeq = removed[i];
+  }
+  return out;
+}
+
+bool
+WqCheckpointCodec::DecodeRecord(const std::string& in, bool& full, std::map<uint64_t, int64_t>& entries,
+                                std::vector<uint64_t>& removed)
+{
+  uint64_t pos = 0;
+  uint64_t value = 0;
+  if (!ReadVarint(in, pos, value)) {
+    return false;
+  }
+  full = (value == 1);
+
+  uint64_t num = 0;
+  if (!ReadVarint(in, pos, num)) {
+    return false;
+  }
+  uint64_t seq = 0;
+  for (uint64_t i = 0; i < num; i++) {
+    uint64_t delta = 0;
+    if (!ReadVarint(in, pos, delta) || !ReadVarint(in, pos, value)) {
+      return false;
+    }
+    seq += delta;
+    entries[seq] = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+
+  if (!ReadVarint(in, pos, num)) {
+    return false;
+  }
+  seq = 0;
+  for (uint64_t i = 0; i < num; i++) {
+    uint64_t delta = 0;
+    if (!ReadVarint(in, pos, delta)) {
+      return false;
+    }
+    seq += delta;
+    removed.push_back(seq);
+  }
+  return pos == in.size();
+}
+
+void
+WqCheckpointCodec::ApplyRecord(std::map<uint64_t, int64_t>& state, bool full,
+                               const std::map<uint64_t, int64_t>& entries, const std::vector<uint64_t>& removed)
+{
+  if (full) {
+    state.clear();
+  }
+  for (uint64_t i = 0; i < removed.size(); i++) {
+    state.erase(removed[i]);
+  }
+  for (std::map<uint64_t, int64_t>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+    state[it->first] = it->second;
+  }
+}
+
+void
+WqCheckpointCodec::AppendBundleEntry(std::string& out, const std::string& node, const std::string& record)
+{
+  AppendVarint(out, node.size());
+  out += node;
+  AppendVarint(out, record.size());
+  out += record;
+}
+
+bool
+WqCheckpointCodec::ReadBundleEntry(const std::string& in, uint64_t& pos, std::string& node, std::string& record)
+{
+  uint64_t len = 0;
+  if (!ReadVarint(in, pos, len) || pos + len > in.size()) {
+    return false;
+  }
+  node = in.substr(pos, len);
+  pos += len;
+  if (!ReadVarint(in, pos, len) || pos + len > in.size()) {
+    return false;
+  }
+  record = in.substr(pos, len);
+  pos += len;
+  return true;
+}
+
+std::string
+WqCheckpointCodec::ToHex(const std::string& in)
+{
+  static const char digits[] = "0123456789ABCDEF";
+  std::string out;
+  for (uint64_t i = 0; i < in.size(); i++) {
+    uint8_t b = (uint8_t)in[i];
+    out.push_back(digits[b >> 4]);
+    out.push_back(digits[b & 0x0F]);
+  }
+  return out;
+}
+
+bool
+WqCheckpointCodec::FromHex(const std::string& in, std::string& out)
+{
+  if (in.size() % 2 != 0) {
+    return false;
+  }
+  out.clear();
+  for (uint64_t i = 0; i < in.size(); i += 2) {
+    int b = 0;
+    for (uint64_t j = i; j < i + 2; j++) {
+      char d = in[j];
+      if (d >= '0' && d <= '9') {
+        b = (b << 4) | (d - '0');
+      }
+      else if (d >= 'A' && d <= 'F') {
+        b = (b << 4) | (d - 'A' + 10);
+      }
+      else {
+        return false;
+      }
+    }
+    out.push_back((char)b);
+  }
+  return true;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef NDN_WQ_CHECKPOINT_CODEC_H
+#define NDN_WQ_CHECKPOINT_CODEC_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Compact encoding of reducer checkpoint state
+ *
+ * A record holds (seq, value) entries and the seqs removed since the previous
+ * record. Seqs are sorted and written as varint deltas, values as zigzag varints.
+ * A full record is a snapshot, a delta record only applies on top of the chain
+ * that starts at the last full record.
+ */
+class WqCheckpointCodec {
+public:
+  static void
+  AppendVarint(std::string& out, uint64_t value);
+
+  static bool
+  ReadVarint(const std::string& in, uint64_t& pos, uint64_t& value);
+
+  static std::string
+  EncodeRecord(bool full, const std::map<uint64_t, int64_t>& entries, const std::vector<uint64_t>& removed);
+
+  static bool
+  DecodeRecord(const std::string& in, bool& full, std::map<uint64_t, int64_t>& entries,
+               std::vector<uint64_t>& removed);
+
+  /**
+   * @brief Apply one decoded record on top of a state
+   */
+  static void
+  ApplyRecord(std::map<uint64_t, int64_t>& state, bool full, const std::map<uint64_t, int64_t>& entries,
+              const std::vector<uint64_t>& removed);
+
+  /**
+   * @brief Records of several nodes in one payload, as length-prefixed (node, record) pairs
+   */
+  static void
+  AppendBundleEntry(std::string& out, const std::string& node, const std::string& record);
+
+  static bool
+  ReadBundleEntry(const std::string& in, uint64_t& pos, std::string& node, std::string& record);
+
+  /**
+   * @brief Upper-case hex of a binary record, safe inside an Interest name
+   */
+  static std::string
+  ToHex(const std::string& in);
+
+  static bool
+  FromHex(const std::string& in, std::string& out);
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
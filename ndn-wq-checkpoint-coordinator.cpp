@@ -0,0 +1,277 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-checkpoint-coordinator.hpp"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+WqCheckpointCoordinator::WqCheckpointCoordinator()
+  : m_maxEpochs(1)
+  , m_nextEpoch(0)
+{
+}
+
+void
+WqCheckpointCoordinator::SetMaxEpochs(uint32_t maxEpochs)
+{
+  m_maxEpochs = std::max<uint32_t>(maxEpochs, 1);
+}
+
+bool
+WqCheckpointCoordinator::CanBegin() const
+{
+  return GetOpenEpochs() < m_maxEpochs;
+}
+
+bool
+WqCheckpointCoordinator::BeginCheckpoint(const std::string& cpID, const std::vector<std::string>& nodes)
+{
+  if (m_epochs.find(cpID) != m_epochs.end() || nodes.size() == 0) {
+    return false;
+  }
+  Epoch epoch;
+  epoch.number = m_nextEpoch++;
+  epoch.state = CP_COLLECTING;
+  epoch.waiting.insert(nodes.begin(), nodes.end());
+  m_epochs[cpID] = epoch;
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Ack(const std::string& cpID, const std::string& node)
+{
+  std::map<std::string, Epoch>::iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end() || it->second.state != CP_COLLECTING || it->second.waiting.erase(node) == 0) {
+    // unknown epoch, or a late/duplicate reply
+    return false;
+  }
+  if (it->second.waiting.size() != 0) {
+    return false;
+  }
+  if (it->second.failNodes.size() != 0) {
+    it->second.state = CP_FAILED;
+  }
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Fail(const std::string& cpID, const std::string& node,
+                              const std::vector<std::string>& failNodes)
+{
+  std::map<std::string, Epoch>::iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end() || it->second.state != CP_COLLECTING) {
+    return false;
+  }
+  for (uint64_t i = 0; i < failNodes.size(); i++) {
+    if (std::find(it->second.failNodes.begin(), it->second.failNodes.end(), failNodes[i])
+        == it->second.failNodes.end()) {
+      it->second.failNodes.push_back(failNodes[i]);
+    }
+  }
+  return Ack(cpID, node);
+}
+
+bool
+WqCheckpointCoordinator::Commit(const std::string& cpID)
+{
+  std::map<std::string, Epoch>::iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end() || it->second.state != CP_COLLECTING || it->second.waiting.size() != 0) {
+    return false;
+  }
+  it->second.state = CP_COMMITTED;
+  uint64_t committed = it->second.number;
+  for (it = m_epochs.begin(); it != m_epochs.end();) {
+    if (it->second.number < committed && (it->second.state == CP_COMMITTED || it->second.state == CP_RECOVERED
+                                           || it->second.state == CP_FAILED)) {
+      m_epochs.erase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Expire(const std::string& cpID)
+{
+  std::map<std::string, Epoch>::iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end() || it->second.state != CP_COLLECTING) {
+    return false;
+  }
+  it->second.waiting.clear();
+  it->second.state = CP_FAILED;
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Recover(const std::string& cpID, const std::vector<std::string>& replacements,
+                                 const std::vector<std::string>& unreplaced)
+{
+  std::map<std::string, Epoch>::iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end() || it->second.state != CP_FAILED) {
+    return false;
+  }
+  it->second.state = CP_RECOVERING;
+  it->second.recovering.insert(replacements.begin(), replacements.end());
+  it->second.unreplaced.insert(unreplaced.begin(), unreplaced.end());
+  // failed nodes that were already replaced by an earlier epoch need nothing more
+  CheckRecoverDone(it->second);
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Replaced(const std::string& failNode, const std::string& replacement)
+{
+  std::string cpID = FindEpoch(&Epoch::unreplaced, failNode);
+  if (cpID == "") {
+    return false;
+  }
+  Epoch& epoch = m_epochs[cpID];
+  epoch.unreplaced.erase(failNode);
+  epoch.recovering.insert(replacement);
+  return true;
+}
+
+bool
+WqCheckpointCoordinator::Recovered(const std::string& node, std::string& cpID)
+{
+  cpID = FindEpoch(&Epoch::recovering, node);
+  if (cpID == "") {
+    return false;
+  }
+  Epoch& epoch = m_epochs[cpID];
+  epoch.recovering.erase(node);
+  CheckRecoverDone(epoch);
+  return epoch.recovering.size() == 0 && epoch.unreplaced.size() == 0;
+}
+
+void
+WqCheckpointCoordinator::Rollback(const std::string& node)
+{
+  std::string cpID = FindEpoch(&Epoch::recovering, node);
+  if (cpID != "") {
+    m_epochs[cpID].rollingBack.insert(node);
+  }
+}
+
+bool
+WqCheckpointCoordinator::RolledBack(const std::string& node, std::string& cpID)
+{
+  cpID = FindEpoch(&Epoch::rollingBack, node);
+  if (cpID == "") {
+    return false;
+  }
+  Epoch& epoch = m_epochs[cpID];
+  epoch.rollingBack.erase(node);
+  CheckRecoverDone(epoch);
+  return epoch.state == CP_RECOVERED;
+}
+
+void
+WqCheckpointCoordinator::CheckRecoverDone(Epoch& epoch)
+{
+  if (epoch.recovering.size() != 0 || epoch.unreplaced.size() != 0) {
+    return;
+  }
+  epoch.state = (epoch.rollingBack.size() != 0) ? CP_ROLLING_BACK : CP_RECOVERED;
+}
+
+std::string
+WqCheckpointCoordinator::FindEpoch(const std::set<std::string> Epoch::*nodes, const std::string& node) const
+{
+  // cpIDs do not sort in epoch order ("101-120" < "21-40"), compare the epoch numbers
+  std::string cpID = "";
+  uint64_t number = 0;
+  std::map<std::string, Epoch>::const_iterator it;
+  for (it = m_epochs.begin(); it != m_epochs.end(); ++it) {
+    if ((it->second.*nodes).find(node) != (it->second.*nodes).end() && (cpID == "" || it->second.number < number)) {
+      cpID = it->first;
+      number = it->second.number;
+    }
+  }
+  return cpID;
+}
+
+WqCheckpointCoordinator::State
+WqCheckpointCoordinator::GetState(const std::string& cpID) const
+{
+  std::map<std::string, Epoch>::const_iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end()) {
+    return CP_NONE;
+  }
+  return it->second.state;
+}
+
+std::vector<std::string>
+WqCheckpointCoordinator::GetFailNodes(const std::string& cpID) const
+{
+  std::map<std::string, Epoch>::const_iterator it = m_epochs.find(cpID);
+  if (it == m_epochs.end()) {
+    return std::vector<std::string>();
+  }
+  return it->second.failNodes;
+}
+
+uint32_t
+WqCheckpointCoordinator::GetOpenEpochs() const
+{
+  uint32_t open = 0;
+  std::map<std::string, Epoch>::const_iterator it;
+  for (it = m_epochs.begin(); it != m_epochs.end(); ++it) {
+    if (it->second.state == CP_COLLECTING) {
+      open++;
+    }
+  }
+  return open;
+}
+
+const std::map<std::string, WqCheckpointCoordinator::Epoch>&
+WqCheckpointCoordinator::GetEpochs() const
+{
+  return m_epochs;
+}
+
+std::string
+WqCheckpointCoordinator::StateName(State state)
+{
+  switch (state) {
+  case CP_COLLECTING:
+    return "collecting";
+  case CP_COMMITTED:
+    return "ok";
+  case CP_FAILED:
+    return "failed";
+  case CP_RECOVERING:
+    return "recovering";
+  case CP_ROLLING_BACK:
+    return "rolling-back";
+  case CP_RECOVERED:
+    return "recovered";
+  default:
+    return "none";
+  }
+}
+
+} // namespace ndn
+} // namespace ns3
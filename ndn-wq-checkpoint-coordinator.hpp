@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_CHECKPOINT_COORDINATOR_H
+#define NDN_WQ_CHECKPOINT_COORDINATOR_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Bookkeeping of checkpoint epochs, independent of the app that hosts it
+ *
+ * Each epoch (checkpoint id, e.g. "21-40") walks through its own state machine:
+ *
+ *   COLLECTING --all acked--> COMMITTED
+ *   COLLECTING --all replied, some failed--> FAILED --Recover--> RECOVERING
+ *   COLLECTING --Expire, replies lost--> FAILED
+ *   RECOVERING --replacements joined, rollbacks pending--> ROLLING_BACK --rolled back--> RECOVERED
+ *   RECOVERING --replacements joined, no rollback--> RECOVERED
+ *
+ * A failed node with no spare to replace it yet stays unreplaced and keeps its epoch
+ * RECOVERING until Replaced() hands it a replacement.
+ *
+ * Several epochs may be open at once, so a new checkpoint does not wait for the
+ * previous one. A commit drops the finished epochs begun before it. The sink runs one for the whole job, a reducer can run one when the
+ * sink delegates the collection of a checkpoint to it.
+ */
+class WqCheckpointCoordinator {
+public:
+  enum State {
+    CP_NONE,
+    CP_COLLECTING,
+    CP_COMMITTED,
+    CP_FAILED,
+    CP_RECOVERING,
+    CP_ROLLING_BACK,
+    CP_RECOVERED
+  };
+
+  struct Epoch {
+    uint64_t number;                    // order in which the epochs began
+    State state;
+    std::set<std::string> waiting;      // participants not replied yet
+    std::vector<std::string> failNodes; // nodes reported failed in this epoch
+    std::set<std::string> recovering;   // replacements not joined yet
+    std::set<std::string> rollingBack;  // replacements not rolled back yet
+    std::set<std::string> unreplaced;   // failed nodes still waiting for a spare
+  };
+
+  WqCheckpointCoordinator();
+
+  void
+  SetMaxEpochs(uint32_t maxEpochs);
+
+  /**
+   * @brief True if one more epoch can start collecting
+   */
+  bool
+  CanBegin() const;
+
+  bool
+  BeginCheckpoint(const std::string& cpID, const std::vector<std::string>& nodes);
+
+  /**
+   * @brief Reply of one participant, returns true once the epoch got all replies
+   */
+  bool
+  Ack(const std::string& cpID, const std::string& node);
+
+  /**
+   * @brief Failure reply of one participant, on behalf of the failed nodes
+   */
+  bool
+  Fail(const std::string& cpID, const std::string& node, const std::vector<std::string>& failNodes);
+
+  /**
+   * @brief Commit a fully acked epoch, and drop the committed, recovered or failed epochs
+   *        begun before it
+   */
+  bool
+  Commit(const std::string& cpID);
+
+  /**
+   * @brief An epoch still collecting after its timeout fails with the failures reported
+   *        so far, returns false if it is no longer collecting
+   */
+  bool
+  Expire(const std::string& cpID);
+
+  /**
+   * @brief A failed epoch starts recovery with the given replacement nodes, the failed
+   *        nodes in unreplaced get theirs later through Replaced()
+   */
+  bool
+  Recover(const std::string& cpID, const std::vector<std::string>& replacements,
+          const std::vector<std::string>& unreplaced = std::vector<std::string>());
+
+  /**
+   * @brief A failed node left unreplaced got its replacement
+   */
+  bool
+  Replaced(const std::string& failNode, const std::string& replacement);
+
+  /**
+   * @brief Replacement joined, returns true once all failed nodes of its epoch are replaced
+   *        and all replacements joined
+   */
+  bool
+  Recovered(const std::string& node, std::string& cpID);
+
+  void
+  Rollback(const std::string& node);
+
+  /**
+   * @brief Replacement rolled back, returns true once its epoch is recovered
+   */
+  bool
+  RolledBack(const std::string& node, std::string& cpID);
+
+  State
+  GetState(const std::string& cpID) const;
+
+  std::vector<std::string>
+  GetFailNodes(const std::string& cpID) const;
+
+  uint32_t
+  GetOpenEpochs() const;
+
+  const std::map<std::string, Epoch>&
+  GetEpochs() const;
+
+  static std::string
+  StateName(State state);
+
+private:
+  /**
+   * @brief The oldest epoch whose set contains the node
+   */
+  std::string
+  FindEpoch(const std::set<std::string> Epoch::*nodes, const std::string& node) const;
+
+  void
+  CheckRecoverDone(Epoch& epoch);
+
+private:
+  std::map<std::string, Epoch> m_epochs;
+  uint32_t m_maxEpochs;
+  uint64_t m_nextEpoch;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
@@ -19,6 +19,7 @@
 
 // #include "/usr/include/python2.7/Python.h"
 #include "ndn-wq-checkpoint-mapper.hpp"
+#include "ndn-wq-seq-batch.hpp"
 #include "ns3/log.h"
 #include "ns3/string.h"
 #include "ns3/uinteger.h"
@@ -81,9 +82,18 @@ WqCheckpointMapper::GetTypeId(void)
 WqCheckpointMapper::WqCheckpointMapper()
 {
   m_rand = CreateObject<UniformRandomVariable>();
+  m_valueRand = CreateObject<UniformRandomVariable>();
   NS_LOG_FUNCTION_NOARGS();
 }
 
+int64_t
+WqCheckpointMapper::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  m_valueRand->SetStream(stream + 1);
+  return 2;
+}
+
 // inherited from Application base class.
 void
 WqCheckpointMapper::StartApplication()
@@ -112,7 +122,7 @@ WqCheckpointMapper::SendInterest(std::string sendName)
   shared_ptr<Interest> mapTaskInterest = make_shared<Interest>();
   mapTaskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   mapTaskInterest->setName(*mapTaskName);
-  mapTaskInterest->setInterestLifetime(ndn::time::seconds(1));
+  mapTaskInterest->setInterestLifetime(GetClassLifetime(sendName));
   m_transmittedInterests(mapTaskInterest, this, m_face);
   m_appLink->onReceiveInterest(*mapTaskInterest);
 };
@@ -288,6 +298,33 @@ WqCheckpointMapper::ReplyData(std::string replyContent, shared_ptr<const Interes
   std::cout <<m_prefix.toUri() << " reply-data: " << replyContent << std::endl;
 };
 
+void
+WqCheckpointMapper::SwitchJob(std::string treeId)
+{
+  if(treeId == m_currentTreeTag || treeId == "") {
+    return;
+  };
+  if(m_currentTreeTag == "000") {
+    m_currentTreeTag = treeId;
+    return;
+  };
+  JobContext& park = m_jobs[m_currentTreeTag];
+  park.selectNodeName = m_selectNodeName;
+  park.selectNodeFace = m_selectNodeFace;
+  park.preUpNeiName = m_preUpNeiName;
+  park.myPathID = m_myPathID;
+  park.prePathID = m_prePathID;
+  // a job seen for the first time starts without upstream
+  JobContext load = m_jobs[treeId];
+  m_jobs.erase(treeId);
+  m_selectNodeName = load.selectNodeName;
+  m_selectNodeFace = load.selectNodeFace;
+  m_preUpNeiName = load.preUpNeiName;
+  m_myPathID = load.myPathID;
+  m_prePathID = load.prePathID;
+  m_currentTreeTag = treeId;
+};
+
 void
 WqCheckpointMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
 {
@@ -295,18 +332,41 @@ WqCheckpointMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
   uint64_t u1 = interestName.find("(");
   uint64_t u2 = interestName.find(")");
   std::string seqNum = interestName.substr(u1+1, u2-u1-1);
+  // "SeqA" or a batch "SeqA~B", answered with one value per seq
+  uint32_t firstSeq = 0;
+  uint32_t lastSeq = 0;
+  if (!WqSeqBatch::ParseRange(seqNum, firstSeq, lastSeq)) {
+    std::cout << m_prefix.toUri() << " drop task with bad seq flag: " << interestName << std::endl;
+    return;
+  };
 
-  int rawNum = std::rand() % 100 + 10;
-  std::string rawData = std::to_string(rawNum);
-  rawData = seqNum + "-" + rawData;
-  // add seqNum&data pair to list in case for re-sending
-  std::map<std::string, std::string>::iterator i = m_sentSeqToNei.find(seqNum);
-  if (i == m_sentSeqToNei.end()) 
+  std::vector<std::string> values;
+  std::vector<int> rawNums;
+  for (uint32_t k = firstSeq; k <= lastSeq; k++) {
+    int rawNum = m_valueRand->GetInteger(10, 109);
+    rawNums.push_back(rawNum);
+    values.push_back(std::to_string(rawNum));
+  };
+  std::string rawData = WqSeqBatch::Join(firstSeq, lastSeq, values);
+  if (interestName.find("/bk-") != std::string::npos)
+  {
+    // backup task of a reducer whose own mapper of this region straggles, not one of our seqs
+    ReplyData(rawData, interest);
+    return;
+  };
+  // add seqNum&data pair to list in case for re-sending, a batch is a duplicate only if every seq was sent
+  bool sentBefore = true;
+  for (uint32_t k = firstSeq; k <= lastSeq && sentBefore; k++) {
+    sentBefore = m_sentSeqToNei.find(WqSeqBatch::RangeFlag(k, k)) != m_sentSeqToNei.end();
+  };
+  if (!sentBefore)
   {
     ReplyData(rawData, interest);
     rawData.clear();
   };
-  AddSeqData(seqNum, rawNum);
+  for (uint32_t k = firstSeq; k <= lastSeq; k++) {
+    AddSeqData(WqSeqBatch::RangeFlag(k, k), rawNums[k-firstSeq]);
+  };
 };
 
 void 
@@ -373,6 +433,13 @@ WqCheckpointMapper::OnInterest(shared_ptr<const Interest> interest)
     uint64_t fClear = m_pendingInterestName.toUri().find("clear");
     uint64_t cp = m_pendingInterestName.toUri().find("cp");
     uint64_t changeUp = m_pendingInterestName.toUri().find("newUp");
+
+    // several jobs share this mapper, the tree tag selects whose upstream is used
+    uint64_t t1 = m_pendingInterestName.toUri().find("TS");
+    uint64_t t2 = m_pendingInterestName.toUri().find("TE");
+    if (t1 != std::string::npos && t2 != std::string::npos && t2 > t1) {
+      SwitchJob(m_pendingInterestName.toUri().substr(t1+2, t2-t1-3));
+    }
   
     //interest for discover tree
     if (sp != std::string::npos) 
@@ -382,9 +449,6 @@ WqCheckpointMapper::OnInterest(shared_ptr<const Interest> interest)
       m_askPitPrefix = "/p-";
       m_disTreeInterestMap.insert(std::pair<std::string, std::string>(m_pendingInterestName.toUri(),"0"));
       
-      uint64_t t1 = m_pendingInterestName.toUri().find("TS");
-      uint64_t t2 = m_pendingInterestName.toUri().find("TE");
-      m_currentTreeTag = m_pendingInterestName.toUri().substr(t1+2, t2-t1-3);
       //std::cout <<"tree tag: "<< m_currentTreeTag <<std::endl;
   
       std::string tempAskPit = m_askPitPrefix + m_pendingInterestName.toUri();
@@ -51,6 +51,9 @@ public:
   // inherited from NdnApp
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
+
+  virtual int64_t
+  AssignStreams(int64_t stream);
   
   virtual void
   OnData(shared_ptr<const Data> contentObject);
@@ -65,6 +68,7 @@ public:
   void ReplyData(std::string replyContent, shared_ptr<const Interest> interest);
   void ProcessNormalInterest(shared_ptr<const Interest> interest);
   void ClearHistorySaveData(std::string seqList);
+  void SwitchJob(std::string treeId);
 
 
 protected:
@@ -77,6 +81,7 @@ protected:
 
 private:
   Ptr<UniformRandomVariable> m_rand;
+  Ptr<UniformRandomVariable> m_valueRand; ///< @brief map results, apart from the nonces so they do not shift with traffic
   Name m_prefix;
   Name m_postfix;
   uint32_t m_virtualPayloadSize;
@@ -109,6 +114,19 @@ private:
   std::map<std::string, std::string> m_possibleRejoinNeis; //(one-hop-nei-name, reply-content)
   int m_sendRejoinNum =0;
   int m_gotRejoinNum =0;
+
+  /**
+   * \struct Upstream of this mapper in one job tree, parked while another job is current
+   */
+  struct JobContext {
+    std::string selectNodeName;
+    std::string selectNodeFace;
+    std::string preUpNeiName;
+    std::string myPathID;
+    std::string prePathID;
+  };
+
+  std::map<std::string, JobContext> m_jobs; // tree-id -- upstream state of the jobs not in m_currentTreeTag
 };
 
 } // namespace ndn
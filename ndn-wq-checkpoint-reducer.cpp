@@ -19,6 +19,9 @@
 
 // #include "/usr/include/python3.8/Python.h"
 #include "ndn-wq-checkpoint-reducer.hpp"
+#include "ndn-wq-checkpoint-codec.hpp"
+#include "ndn-wq-checkpoint-coordinator.hpp"
+#include "ndn-wq-seq-batch.hpp"
 #include "ns3/log.h"
 #include "ns3/string.h"
 #include "ns3/uinteger.h"
@@ -28,6 +31,9 @@
 #include "model/ndn-l3-protocol.hpp"
 #include "helper/ndn-fib-helper.hpp"
 #include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 
 #include <deque>
 
@@ -50,6 +56,17 @@ namespace ndn {
 
 NS_OBJECT_ENSURE_REGISTERED(WqCheckpointReducer);
 
+// drop the "treeId-SeqN" entries of one job, jobSeq is "treeId-Seq"
+template<typename T>
+static void
+EraseJobSeqs(std::map<std::string, T>& seqMap, const std::string& jobSeq)
+{
+  typename std::map<std::string, T>::iterator it = seqMap.lower_bound(jobSeq);
+  while(it != seqMap.end() && it->first.compare(0, jobSeq.size(), jobSeq) == 0) {
+    seqMap.erase(it++);
+  };
+}
+
 TypeId
 WqCheckpointReducer::GetTypeId(void)
 {
@@ -74,7 +91,32 @@ WqCheckpointReducer::GetTypeId(void)
       .AddAttribute("LifeTime", "LifeTime for interest packet", StringValue("200s"),
                     MakeTimeAccessor(&WqCheckpointReducer::m_interestLifeTime), MakeTimeChecker())
       .AddAttribute("KeyLocator", "Name to be used for key locator.  If root, then key locator is not used",
-                    NameValue(), MakeNameAccessor(&WqCheckpointReducer::m_keyLocator), MakeNameChecker()); 
+                    NameValue(), MakeNameAccessor(&WqCheckpointReducer::m_keyLocator), MakeNameChecker())
+      .AddAttribute("ReplicaInterval", "Interval to stream committed seq-data to the warm standby reducer",
+                    StringValue("1s"), MakeTimeAccessor(&WqCheckpointReducer::m_replicaInterval), MakeTimeChecker())
+      .AddAttribute("ReplicaBatch", "Seq-data entries streamed to the warm standby per replica Interest",
+                    UintegerValue(20), MakeUintegerAccessor(&WqCheckpointReducer::m_replicaBatch),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("CheckpointFullEvery", "Send a full checkpoint snapshot every K checkpoints, deltas in between",
+                    UintegerValue(5), MakeUintegerAccessor(&WqCheckpointReducer::m_cpFullEvery),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("MaxJobInflight", "Tasks of one job sent to the children at a time, 0 for no limit",
+                    UintegerValue(0), MakeUintegerAccessor(&WqCheckpointReducer::m_maxJobInflight),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("InflightTimeout", "Time after which a task lost below this node no longer counts against its job",
+                    StringValue("20s"), MakeTimeAccessor(&WqCheckpointReducer::m_inflightTimeout), MakeTimeChecker())
+      .AddAttribute("MapperReplicas", "Mappers covering the same sensor region, as /a-=/b-;/c-=/d-",
+                    StringValue(""), MakeStringAccessor(&WqCheckpointReducer::m_mapperReplicas),
+                    MakeStringChecker())
+      .AddAttribute("StragglerPercentile", "Child response-time percentile after which a child straggles",
+                    UintegerValue(95), MakeUintegerAccessor(&WqCheckpointReducer::m_stragglerPercentile),
+                    MakeUintegerChecker<uint32_t>(1, 100))
+      .AddAttribute("StragglerMinSamples", "Response times needed before stragglers are handled",
+                    UintegerValue(20), MakeUintegerAccessor(&WqCheckpointReducer::m_stragglerMinSamples),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("StragglerRetries", "Straggler checks of a seq that has no data yet before partial mode gives up on it",
+                    UintegerValue(3), MakeUintegerAccessor(&WqCheckpointReducer::m_stragglerRetries),
+                    MakeUintegerChecker<uint32_t>());
   return tid;
 }
 
@@ -84,6 +126,13 @@ WqCheckpointReducer::WqCheckpointReducer()
   NS_LOG_FUNCTION_NOARGS();
 }
 
+int64_t
+WqCheckpointReducer::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  return 1;
+}
+
 // inherited from Application base class.
 void
 WqCheckpointReducer::StartApplication()
@@ -92,12 +141,35 @@ WqCheckpointReducer::StartApplication()
   App::StartApplication();
 
   FibHelper::AddRoute(GetNode(), m_prefix, m_face, 0);
+
+  // "/a-=/b-;/c-=/d-", both mappers of a pair stand in for each other
+  std::string pairs = m_mapperReplicas;
+  while(pairs.size() != 0) {
+    uint64_t e = pairs.find(";");
+    std::string pair = pairs.substr(0, e);
+    uint64_t q = pair.find("=");
+    if(q != std::string::npos) {
+      m_mapperReplica[pair.substr(0, q)] = pair.substr(q+1);
+      m_mapperReplica[pair.substr(q+1)] = pair.substr(0, q);
+    };
+    pairs = (e == std::string::npos) ? "" : pairs.substr(e+1);
+  };
 }
 
 void
 WqCheckpointReducer::StopApplication()
 {
   NS_LOG_FUNCTION_NOARGS();
+  Simulator::Cancel(m_replicaEvent);
+  Simulator::Cancel(m_dispatchEvent);
+  std::map<std::string, JobContext>::iterator job;
+  for(job=m_jobs.begin(); job!=m_jobs.end(); job++) {
+    Simulator::Cancel(job->second.replicaEvent);
+  };
+  std::map<std::string, EventId>::iterator cp;
+  for(cp=m_cpLeadTimeouts.begin(); cp!=m_cpLeadTimeouts.end(); cp++) {
+    Simulator::Cancel(cp->second);
+  };
 
   App::StopApplication();
 }
@@ -106,26 +178,14 @@ WqCheckpointReducer::StopApplication()
 void
 WqCheckpointReducer::FindNeighbours()
 {
-  //std::cout << "find neighbours: " << m_pendingInterestName.toUri() << std::endl;
-  m_disNeiPrefix = "/nei-";
-  for(uint8_t i=0; i < m_allNodeName.size(); i++)
+  // one local forwarder query instead of a "/nei-" probe per cluster node
+  m_oneHopNeighbours = GetOneHopNeighbours();
+  std::cout << m_prefix.toUri() << " next-hop neighbour number: " << m_oneHopNeighbours.size() << std::endl;
+  if(m_oneHopNeighbours.size() == 0)
   {
-    if(m_allNodeName[i] != m_prefix.toUri())
-    {
-      m_checkNeibMap.insert(std::pair<std::string, std::string>(m_allNodeName[i],"0"));
-      // written as: /nei-/user-
-      std::string tempDisNei = m_disNeiPrefix + m_allNodeName[i];
-      shared_ptr<Name> disNeiName = make_shared<Name>(tempDisNei);
-      //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-      shared_ptr<Interest> disNeiInterest = make_shared<Interest>();
-      disNeiInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-      disNeiInterest->setName(*disNeiName);
-      disNeiInterest->setInterestLifetime(ndn::time::seconds(1));
-      m_transmittedInterests(disNeiInterest, this, m_face);
-      m_appLink->onReceiveInterest(*disNeiInterest);
-      m_sendDisNeiNum +=1;
-    }
+    return;
   };
+  Simulator::Schedule(Seconds(0.0), &WqCheckpointReducer::DiscoverDownstreams, this);
 };
 
 void
@@ -227,7 +287,7 @@ WqCheckpointReducer::SendOutInterest(std::string newInterest)
   shared_ptr<Interest> sendInterest = make_shared<Interest>();
   sendInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   sendInterest->setName(*sendName);
-  sendInterest->setInterestLifetime(ndn::time::seconds(1));
+  sendInterest->setInterestLifetime(GetClassLifetime(newInterest));
   m_transmittedInterests(sendInterest, this, m_face);
   m_appLink->onReceiveInterest(*sendInterest);
   // std::cout <<m_prefix.toUri() << " Send-Interest: " << newInterest << std::endl;
@@ -259,7 +319,8 @@ WqCheckpointReducer::ReplyData(std::string replyContent, std::string replayName)
   taskData->wireEncode();
   m_transmittedDatas(taskData, this, m_face);
   m_appLink->onReceiveData(*taskData);
-  std::cout <<m_prefix.toUri() << " reply-data: " << replyContent << std::endl;
+  // checkpoint records after "#" are binary, only the text header is printed
+  std::cout <<m_prefix.toUri() << " reply-data: " << replyContent.substr(0, replyContent.find("#")) << std::endl;
 };
 
 void
@@ -549,13 +610,13 @@ void
 WqCheckpointReducer::AddComputeGroup(std::string newId)
 {
   std::string groupID;
-  //to easily check, m_groupIds only store compute-group-id
+  //to easily check, m_groupIds only store compute-group-id, m_computeGroup is keyed by tree-id + id
   if (m_groupIds.size() == 0) 
   {
     int endGroup = stoi(newId) + 4;
     groupID = newId + "-" + std::to_string(endGroup);
     m_groupIds.push_back(groupID);
-    m_computeGroup.insert(std::pair<std::string, std::string>(groupID, ""));
+    m_computeGroup.insert(std::pair<std::string, std::string>(m_currentTreeFlag + "-Seq" + groupID, ""));
   }
   else 
   {
@@ -569,7 +630,7 @@ WqCheckpointReducer::AddComputeGroup(std::string newId)
       endGroup = currentNum + 4;
       groupID = newId + "-" + std::to_string(endGroup);
       m_groupIds.push_back(groupID);
-      m_computeGroup.insert(std::pair<std::string, std::string>(groupID, ""));
+      m_computeGroup.insert(std::pair<std::string, std::string>(m_currentTreeFlag + "-Seq" + groupID, ""));
     };
   };
   // for (auto& x: m_computeGroup) {
@@ -593,6 +654,7 @@ WqCheckpointReducer::SaveSeqInterestName(std::string seqId, std::string requestS
 void
 WqCheckpointReducer::ProcessDataBySeq(std::string startProcessId)
 {
+  SwitchJob(startProcessId.substr(0, startProcessId.find("-Seq")));
   //check if already process and return seq-data
   if ( std::find(m_processOkSeq.begin(), m_processOkSeq.end(), startProcessId) == m_processOkSeq.end() )
   {
@@ -605,45 +667,45 @@ WqCheckpointReducer::ProcessDataBySeq(std::string startProcessId)
         std::string alldata = m_allReceiveSeqData[startProcessId];
         // std::cout << m_prefix.toUri() << " InterstName= " << replyInterest << " && data= " << alldata << std::endl;
 
-        std::vector<int> commaVec;
-        std::vector<std::string> neiData;
-        uint64_t pos = alldata.find(","); 
-        if (pos == std::string::npos) {
-          neiData.push_back(alldata);
+        std::map<std::string, int>::iterator partial = m_partialSeqs.find(startProcessId);
+        std::string rawData = AggregateSeqData(alldata, (partial == m_partialSeqs.end()) ? 0 : partial->second);
+        if (rawData.find("p") != std::string::npos) {
+          std::cout << m_prefix.toUri() << " partial aggregate " << startProcessId << ": " << rawData << std::endl;
+          m_partialFolded.insert(startProcessId);
         }
-        else {
-          while (pos != std::string::npos){
-            commaVec.push_back(pos);
-            pos = alldata.find(",", pos+1);
-          }
+        else if (partial != m_partialSeqs.end()) {
+          m_partialSeqs.erase(partial);
         };
-
-        if (commaVec.size() != 0) {
-          neiData.push_back(alldata.substr(0, commaVec[0]));
-          for(uint64_t k=0; k<commaVec.size(); k++) {
-            neiData.push_back(alldata.substr(commaVec[k]+1, commaVec[k+1]-commaVec[k]-1));
-          }
-        };
-
-        int tempSumData = 0;
-        for (uint8_t i=0; i < neiData.size(); i++) 
-        {
-          uint64_t l1 = neiData[i].find_last_of("-");
-          std::string mapperData = neiData[i].substr(l1+1);
-          tempSumData += std::stoi(mapperData);
-          // std::cout << m_prefix.toUri() << " --- HERE --- " << " neiData= " << neiData[i] << std::endl;
-        };
-        std::string rawData = std::to_string(tempSumData / neiData.size());
         uint64_t findS = startProcessId.find("Seq");
         std::string rxSeq = startProcessId.substr(findS);
 
-        rawData = rxSeq + "-" + rawData;
         // std::cout<< m_prefix.toUri() << " Reply to Who=== " << replyInterest << std::endl;
-        ReplyData(rawData, replyInterest);
+        uint64_t r1 = replyInterest.find("(");
+        uint32_t firstSeq = 0;
+        uint32_t lastSeq = 0;
+        WqSeqBatch::ParseRange(replyInterest.substr(r1+1, replyInterest.find(")")-r1-1), firstSeq, lastSeq);
+        if(firstSeq != lastSeq) {
+          // batch Interest, one Data once every seq of its range is folded
+          std::map<uint32_t, std::string>& batch = m_batchReply[replyInterest];
+          batch[std::stoul(rxSeq.substr(3))] = rawData;
+          if(batch.size() == lastSeq - firstSeq + 1) {
+            std::vector<std::string> values;
+            for(std::map<uint32_t, std::string>::iterator b=batch.begin(); b!=batch.end(); b++) {
+              values.push_back(b->second);
+            };
+            ReplyData(WqSeqBatch::Join(firstSeq, lastSeq, values), replyInterest);
+            m_batchReply.erase(replyInterest);
+          };
+        }
+        else {
+          ReplyData(rxSeq + "-" + rawData, replyInterest);
+        };
+        rawData = rxSeq + "-" + rawData;
         std::map<std::string, std::string>::iterator i = m_processedSeqData.find(rxSeq);
         if (i == m_processedSeqData.end()) {
           m_processedSeqData.insert(std::pair<std::string, std::string>(rxSeq, rawData));
         };
+        NoteReplied(std::stoul(rxSeq.substr(3)));
         std::ofstream recording;
         recording.open("computeStateRecord.txt", std::ios_base::app);
         recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_processedSeqData.size() << std::endl;
@@ -652,6 +714,13 @@ WqCheckpointReducer::ProcessDataBySeq(std::string startProcessId)
         m_processOkSeq.push_back(startProcessId);
         m_seqDataGotNum.erase(startProcessId);
         m_seqDataSendNum.erase(startProcessId);
+        m_childSentTime.erase(startProcessId);
+        m_seqTask.erase(startProcessId);
+        if (m_partialFolded.find(startProcessId) == m_partialFolded.end()) {
+          m_seqAnswered.erase(startProcessId);
+          m_seqParent.erase(startProcessId);
+        };
+        FinishJobTask(startProcessId);
       }
       else {
         std::cout << m_prefix.toUri() << " !!! " << startProcessId << " Send != Received " << std::endl;
@@ -663,6 +732,60 @@ WqCheckpointReducer::ProcessDataBySeq(std::string startProcessId)
   }
 };
 
+std::string
+WqCheckpointReducer::AggregateSeqData(std::string alldata, int missing)
+{
+  std::vector<int> commaVec;
+  std::vector<std::string> neiData;
+  uint64_t pos = alldata.find(","); 
+  if (pos == std::string::npos) {
+    if (alldata.size() != 0) {
+      neiData.push_back(alldata);
+    };
+  }
+  else {
+    while (pos != std::string::npos){
+      commaVec.push_back(pos);
+      pos = alldata.find(",", pos+1);
+    }
+  };
+
+  if (commaVec.size() != 0) {
+    neiData.push_back(alldata.substr(0, commaVec[0]));
+    for(uint64_t k=0; k<commaVec.size(); k++) {
+      neiData.push_back(alldata.substr(commaVec[k]+1, commaVec[k+1]-commaVec[k]-1));
+    }
+  };
+
+  // coverage = mappers behind the values / mappers the seq was sent to, a child value
+  // "v" covers one mapper, a partial one "vpA/B" covers A of B
+  int tempSumData = 0;
+  int covered = 0;
+  int total = missing;
+  for (uint8_t i=0; i < neiData.size(); i++) 
+  {
+    uint64_t l1 = neiData[i].find_last_of("-");
+    std::string mapperData = neiData[i].substr(l1+1);
+    tempSumData += std::stoi(mapperData);
+    uint64_t pm = mapperData.find("p");
+    if (pm != std::string::npos) {
+      uint64_t sl = mapperData.find("/", pm);
+      covered += std::stoi(mapperData.substr(pm+1, sl-pm-1));
+      total += std::stoi(mapperData.substr(sl+1));
+    }
+    else {
+      covered++;
+      total++;
+    };
+    // std::cout << m_prefix.toUri() << " --- HERE --- " << " neiData= " << neiData[i] << std::endl;
+  };
+  std::string rawData = std::to_string(neiData.size() == 0 ? 0 : tempSumData / (int)neiData.size());
+  if (covered != total) {
+    rawData += "p" + std::to_string(covered) + "/" + std::to_string(total);
+  };
+  return rawData;
+};
+
 void 
 WqCheckpointReducer::ProcessTaskNeis(std::string neiString)
 {
@@ -965,6 +1088,339 @@ WqCheckpointReducer::ForwardClearDataSignal(std::string clearMessage)
   };
 };
 
+std::string
+WqCheckpointReducer::CheckpointReplyContent()
+{
+  if(m_cpFailure){
+    return m_prefix.toUri() + "&Fail";
+  };
+  // "#" separates the text header from the binary checkpoint record
+  return m_prefix.toUri() + "&OK#" + EncodeCheckpointState();
+};
+
+void
+WqCheckpointReducer::OnCheckpointReply(std::string cpID, std::string node, std::string content)
+{
+  uint64_t h = content.find_first_of("#");
+  std::string cpHeader = content.substr(0, h);
+  if(h != std::string::npos) {
+    WqCheckpointCodec::AppendBundleEntry(m_cpLeadRecords[cpID], node, content.substr(h+1));
+  };
+  bool collected = false;
+  if(cpHeader.find("&Fail") != std::string::npos) {
+    collected = m_cpCoordinator.Fail(cpID, node, std::vector<std::string>(1, node));
+  }
+  else {
+    collected = m_cpCoordinator.Ack(cpID, node);
+  };
+  if(!collected) {
+    return;
+  };
+
+  // answer the sink once for all nodes, with the failed ones listed
+  std::string replyContent = m_prefix.toUri() + "&OK";
+  if(m_cpCoordinator.GetState(cpID) == WqCheckpointCoordinator::CP_FAILED) {
+    std::vector<std::string> failNodes = m_cpCoordinator.GetFailNodes(cpID);
+    replyContent = m_prefix.toUri() + "&Fail&";
+    for(uint64_t i=0; i<failNodes.size(); i++) {
+      replyContent += (i == 0 ? "" : ";") + failNodes[i];
+    };
+  }
+  else {
+    m_cpCoordinator.Commit(cpID);
+  };
+  std::cout << m_prefix.toUri() << " collected Checkpoint-ID= " << cpID << ": " << replyContent << std::endl;
+  ReplyData(replyContent + "#" + m_cpLeadRecords[cpID], m_cpLeadInterest[cpID]);
+  m_cpLeadInterest.erase(cpID);
+  m_cpLeadRecords.erase(cpID);
+  Simulator::Cancel(m_cpLeadTimeouts[cpID]);
+  m_cpLeadTimeouts.erase(cpID);
+};
+
+void
+WqCheckpointReducer::ExpireLeadCheckpoint(std::string cpID)
+{
+  // the sink's lead Interest is gone by now, the sink expires its own epoch
+  m_cpLeadTimeouts.erase(cpID);
+  if(m_cpCoordinator.Expire(cpID)) {
+    std::cout << m_prefix.toUri() << " lead Checkpoint-ID= " << cpID << " expired" << std::endl;
+    m_cpLeadInterest.erase(cpID);
+    m_cpLeadRecords.erase(cpID);
+  };
+};
+
+std::string
+WqCheckpointReducer::EncodeCheckpointState()
+{
+  // checkpoint state = retained seq-data, keyed by seq number
+  std::map<uint64_t, int64_t> current;
+  std::map<std::string, std::string>::iterator it;
+  for(it=m_processedSeqData.begin(); it!=m_processedSeqData.end(); it++) {
+    // only whole integer values are checkpointed: a partial "12p3/5" is not final yet, its
+    // late fill enters a later checkpoint as a changed entry
+    std::string value = it->second.substr(it->second.find("-")+1);
+    char* end = NULL;
+    errno = 0;
+    long long v = std::strtoll(value.c_str(), &end, 10);
+    if(it->first.compare(0, 3, "Seq") != 0 || value.empty() || *end != '\0' || errno == ERANGE) {
+      continue;
+    };
+    current[std::stoull(it->first.substr(3))] = v;
+  };
+
+  bool full = (m_cpCount % m_cpFullEvery == 0);
+  m_cpCount++;
+  std::map<uint64_t, int64_t> entries;
+  std::vector<uint64_t> removed;
+  if(full) {
+    entries = current;
+  }
+  else {
+    // only entries changed since the previous checkpoint, and the ones cleared meanwhile
+    std::map<uint64_t, int64_t>::iterator c;
+    for(c=current.begin(); c!=current.end(); c++) {
+      std::map<uint64_t, int64_t>::iterator pre = m_cpSnapshot.find(c->first);
+      if(pre == m_cpSnapshot.end() || pre->second != c->second) {
+        entries.insert(*c);
+      };
+    };
+    for(c=m_cpSnapshot.begin(); c!=m_cpSnapshot.end(); c++) {
+      if(current.find(c->first) == current.end()) {
+        removed.push_back(c->first);
+      };
+    };
+  };
+  m_cpSnapshot = current;
+  std::cout << m_prefix.toUri() << " checkpoint " << (full ? "full" : "delta") << " entries= " << entries.size()
+            << " removed= " << removed.size() << std::endl;
+  return WqCheckpointCodec::EncodeRecord(full, entries, removed);
+};
+
+void
+WqCheckpointReducer::ReplicateState(std::string treeId)
+{
+  // each job streams to its own standby, the timer may fire while another job is current
+  SwitchJob(treeId);
+  if(m_standbyNode == "") {
+    return;
+  };
+  // seqs the standby may not hold yet, in numeric order so Seq10 follows Seq9: new or changed
+  // ones above the acked watermark, and ones at or below it rewritten by a late fill since
+  std::map<uint32_t, std::string> pending;
+  std::map<std::string, std::string>::iterator it;
+  for(it=m_processedSeqData.begin(); it!=m_processedSeqData.end(); it++) {
+    if(it->first.compare(0, 3, "Seq") != 0) {
+      continue;
+    };
+    uint32_t seq = std::stoul(it->first.substr(3));
+    if(seq <= m_replicaAcked) {
+      if(m_replicaDirty.find(seq) == m_replicaDirty.end()) {
+        continue;
+      };
+    }
+    else {
+      std::map<uint32_t, std::string>::iterator sent = m_replicaSent.find(seq);
+      if(sent != m_replicaSent.end() && sent->second == it->second) {
+        continue;
+      };
+    };
+    pending[seq] = it->second;
+  };
+  // values hold digits and "p<covered>/<total>" of a partial, never ";"
+  std::string entries = "";
+  uint32_t wm = m_repliedSeq;
+  uint32_t count = 0;
+  bool more = false;
+  std::map<uint32_t, std::string>::iterator p;
+  for(p=pending.begin(); p!=pending.end(); p++) {
+    if(count == m_replicaBatch) {
+      more = true;
+      // the standby holds every seq below the first one left for the next round
+      wm = std::min(wm, p->first - 1);
+      break;
+    };
+    entries += p->second + ";";
+    m_replicaSent[p->first] = p->second;
+    m_replicaDirty.erase(p->first);
+    count++;
+  };
+  // an empty round still refreshes the watermark at the standby
+  std::string replica = m_standbyNode + "/replica(" + m_prefix.toUri() + ")/TS" + m_currentTreeFlag + m_disDownStream2
+                        + "wm(" + std::to_string(wm) + ")/" + entries;
+  // std::cout << m_prefix.toUri() << " replicate: " << replica << std::endl;
+  SendOutInterest(replica);
+  // the rest of a long backlog goes next round, otherwise the stream waits for new state
+  if(more) {
+    m_replicaEvent = Simulator::Schedule(m_replicaInterval, &WqCheckpointReducer::ReplicateState, this, m_currentTreeFlag);
+  };
+};
+
+void
+WqCheckpointReducer::NoteReplied(uint32_t seq)
+{
+  // the watermark has its own counter, checkpoints clear the replied seq-data
+  if(seq > m_repliedSeq) {
+    m_repliedAbove.insert(seq);
+  };
+  while(m_repliedAbove.erase(m_repliedSeq+1) == 1) {
+    m_repliedSeq++;
+  };
+  ArmReplica();
+};
+
+void
+WqCheckpointReducer::ArmReplica()
+{
+  if(m_standbyNode != "" && !m_replicaEvent.IsRunning()) {
+    m_replicaEvent = Simulator::Schedule(m_replicaInterval, &WqCheckpointReducer::ReplicateState, this, m_currentTreeFlag);
+  };
+};
+
+void
+WqCheckpointReducer::SwitchJob(std::string treeId)
+{
+  if(treeId == m_currentTreeFlag || treeId == "" || treeId == "none") {
+    return;
+  };
+  // first job on this node, the m_ fields are still unused
+  if(m_currentTreeFlag == "000") {
+    m_currentTreeFlag = treeId;
+    return;
+  };
+  // park the running job, then load the requested one (a new job loads empty state)
+  SwapJobContext(m_jobs[m_currentTreeFlag]);
+  SwapJobContext(m_jobs[treeId]);
+  m_jobs.erase(treeId);
+  m_currentTreeFlag = treeId;
+};
+
+void
+WqCheckpointReducer::SwapJobContext(JobContext& ctx)
+{
+  std::swap(m_selectNodeName, ctx.selectNodeName);
+  std::swap(m_preUpNodeName, ctx.preUpNodeName);
+  std::swap(m_myPathID, ctx.myPathID);
+  std::swap(m_prePathID, ctx.prePathID);
+  std::swap(m_joinNeiPathId, ctx.joinNeiPathId);
+  std::swap(m_jobRefNei, ctx.jobRefNei);
+  std::swap(m_assignTask, ctx.assignTask);
+  std::swap(m_nodeList4Task, ctx.nodeList4Task);
+  std::swap(jobNeiChangeFlag, ctx.jobNeiChangeFlag);
+  std::swap(m_nodePathId, ctx.nodePathId);
+  std::swap(m_neiLocalId, ctx.neiLocalId);
+  std::swap(m_lostNeiIdRecords, ctx.lostNeiIdRecords);
+  std::swap(m_receiveNodeandData, ctx.receiveNodeandData);
+  std::swap(m_processedSeqData, ctx.processedSeqData);
+  std::swap(m_computeGroup, ctx.computeGroup);
+  std::swap(m_groupIds, ctx.groupIds);
+  std::swap(m_countdata, ctx.countdata);
+  std::swap(m_countSeq, ctx.countSeq);
+  std::swap(m_cpCount, ctx.cpCount);
+  std::swap(m_cpSnapshot, ctx.cpSnapshot);
+  std::swap(m_upNodeFail, ctx.upNodeFail);
+  std::swap(m_interestOfUpfail, ctx.interestOfUpfail);
+  std::swap(m_reportFailNeiList, ctx.reportFailNeiList);
+  std::swap(m_interestAsRecoverReducer, ctx.interestAsRecoverReducer);
+  std::swap(m_cpFailure, ctx.cpFailure);
+  std::swap(m_detectLinkFailure, ctx.detectLinkFailure);
+  std::swap(m_detectFailureSeqData, ctx.detectFailureSeqData);
+  std::swap(m_possibleRejoinNeis, ctx.possibleRejoinNeis);
+  std::swap(m_sendRejoinNum, ctx.sendRejoinNum);
+  std::swap(m_gotRejoinNum, ctx.gotRejoinNum);
+  std::swap(m_sendRejoinNode, ctx.sendRejoinNode);
+  std::swap(m_standbyNode, ctx.standbyNode);
+  std::swap(m_replicaEvent, ctx.replicaEvent);
+  std::swap(m_replicaSent, ctx.replicaSent);
+  std::swap(m_replicaDirty, ctx.replicaDirty);
+  std::swap(m_replicaAcked, ctx.replicaAcked);
+  std::swap(m_repliedSeq, ctx.repliedSeq);
+  std::swap(m_repliedAbove, ctx.repliedAbove);
+  std::swap(m_replicaSeqData, ctx.replicaSeqData);
+  std::swap(m_replicaWatermark, ctx.replicaWatermark);
+  std::swap(m_restoredSeqs, ctx.restoredSeqs);
+};
+
+void
+WqCheckpointReducer::EnqueueTask(shared_ptr<const Interest> taskInterest)
+{
+  std::string taskName = taskInterest->getName().toUri();
+  uint64_t u1 = taskName.find("TS");
+  uint64_t u2 = taskName.find("TE");
+  std::string treeId = taskName.substr(u1+2, u2-u1-3);
+  // a task still queued after its lifetime has no upstream waiting for it any more
+  Time expiry = Simulator::Now() + MilliSeconds(taskInterest->getInterestLifetime().count());
+  m_jobQueue[treeId].push_back(std::make_pair(taskInterest, expiry));
+  if(std::find(m_jobOrder.begin(), m_jobOrder.end(), treeId) == m_jobOrder.end()) {
+    m_jobOrder.push_back(treeId);
+  };
+  DispatchTasks();
+};
+
+void
+WqCheckpointReducer::DispatchTasks()
+{
+  // round-robin over the jobs, each one holds at most m_maxJobInflight seqs below this node
+  bool sent = true;
+  while(sent && m_jobOrder.size() != 0) {
+    sent = false;
+    for(uint64_t k=0; k<m_jobOrder.size(); k++) {
+      std::string treeId = m_jobOrder[(m_jobTurn + k) % m_jobOrder.size()];
+      std::deque<std::pair<shared_ptr<const Interest>, Time>>& queue = m_jobQueue[treeId];
+      while(queue.size() != 0 && queue.front().second <= Simulator::Now()) {
+        std::cout << m_prefix.toUri() << " drop expired task: " << queue.front().first->getName().toUri() << std::endl;
+        queue.pop_front();
+      };
+      std::map<std::string, Time>& inflight = m_jobInflight[treeId];
+      // a seq lost below this node must not hold the job's share for ever
+      std::map<std::string, Time>::iterator it = inflight.begin();
+      while(it != inflight.end()) {
+        if(Simulator::Now() - it->second > m_inflightTimeout) {
+          it = inflight.erase(it);
+        }
+        else {
+          it++;
+        };
+      };
+      if(queue.size() == 0 || (m_maxJobInflight != 0 && inflight.size() >= m_maxJobInflight)) {
+        continue;
+      };
+
+      shared_ptr<const Interest> task = queue.front().first;
+      queue.pop_front();
+      SwitchJob(treeId);
+      m_normalInterest = task;
+      ProcessNormalInterest(task);
+      std::string taskName = task->getName().toUri();
+      uint64_t s1 = taskName.find("(");
+      uint64_t s2 = taskName.find(")");
+      uint32_t firstSeq = 0;
+      uint32_t lastSeq = 0;
+      WqSeqBatch::ParseRange(taskName.substr(s1+1, s2-s1-1), firstSeq, lastSeq);
+      // a batch holds one share of the job, released when its first seq is folded
+      std::string treeIdSeq = treeId + "-Seq" + std::to_string(firstSeq);
+      if(m_seqDataSendNum.find(treeIdSeq) != m_seqDataSendNum.end()) {
+        inflight[treeIdSeq] = Simulator::Now();
+      };
+      m_jobTurn = (m_jobTurn + k + 1) % m_jobOrder.size();
+      sent = true;
+      break;
+    };
+  };
+};
+
+void
+WqCheckpointReducer::FinishJobTask(std::string treeIdSeq)
+{
+  uint64_t findS = treeIdSeq.find("-Seq");
+  std::map<std::string, std::map<std::string, Time>>::iterator it = m_jobInflight.find(treeIdSeq.substr(0, findS));
+  if(it == m_jobInflight.end() || it->second.erase(treeIdSeq) == 0) {
+    return;
+  };
+  if(!m_dispatchEvent.IsRunning()) {
+    m_dispatchEvent = Simulator::ScheduleNow(&WqCheckpointReducer::DispatchTasks, this);
+  };
+};
+
 void 
 WqCheckpointReducer::ProcessNormalInterest(shared_ptr<const Interest> taskInterest)
 {
@@ -973,21 +1429,75 @@ WqCheckpointReducer::ProcessNormalInterest(shared_ptr<const Interest> taskIntere
   uint64_t s1 = m_pendingInterestName.toUri().find("(");
   uint64_t s2 = m_pendingInterestName.toUri().find(")");
   std::string seqNum = m_pendingInterestName.toUri().substr(s1+1, s2-s1-1);
-  std::string n = seqNum.substr(3);
-  AddComputeGroup(n);
+  // "SeqA" or a batch "SeqA~B", the bookkeeping below stays per seq
+  uint32_t firstSeq = 0;
+  uint32_t lastSeq = 0;
+  WqSeqBatch::ParseRange(seqNum, firstSeq, lastSeq);
+  // seqs already committed by the failed reducer this node stood by for, answer from the replica
+  std::vector<std::string> restored;
+  for(uint32_t k=firstSeq; k<=lastSeq; k++) {
+    std::string eachSeq = "Seq" + std::to_string(k);
+    if(m_restoredSeqs.find(eachSeq) == m_restoredSeqs.end()) {
+      break;
+    };
+    std::string eachData = m_processedSeqData[eachSeq];
+    restored.push_back(eachData.substr(eachData.find("-")+1));
+  };
+  if(restored.size() == lastSeq - firstSeq + 1) {
+    std::cout << m_prefix.toUri() << " answer from replica: " << seqNum << std::endl;
+    ReplyData(WqSeqBatch::Join(firstSeq, lastSeq, restored), m_pendingInterestName.toUri());
+    return;
+  };
+  for(uint32_t k=firstSeq; k<=lastSeq; k++) {
+    AddComputeGroup(std::to_string(k));
+  };
   m_doubtSeq = seqNum;
   uint64_t u1 = m_pendingInterestName.toUri().find("TS");
   uint64_t u2 = m_pendingInterestName.toUri().find("TE");
   std::string userId = m_pendingInterestName.toUri().substr(u1+2, u2-u1-3);
   m_assignTask = m_pendingInterestName.toUri().substr(u1-1, s2-u1+2);
   // std::cout << m_prefix.toUri() << " userID: " << userId << std::endl;
+  // straggler handling of the job, "/sm.dup" (replica) or "/sm.part" (partial) in the task,
+  // short tags since "replica" is a keyword of OnInterest
+  uint64_t sm = m_pendingInterestName.toUri().find("/sm.");
+  if(sm != std::string::npos) {
+    uint64_t se = m_pendingInterestName.toUri().find_first_of("-/", sm+4);
+    std::string smTag = m_pendingInterestName.toUri().substr(sm+4, se-sm-4);
+    m_jobStragglerMode[userId] = (smTag == "dup") ? "replica" : (smTag == "part") ? "partial" : "none";
+  };
+  // "/dl.<ms>", how long to wait for the children before replying partial
+  uint64_t dl = m_pendingInterestName.toUri().find("/dl.");
+  std::string childTask = m_assignTask;
+  if(dl != std::string::npos) {
+    uint64_t de = m_pendingInterestName.toUri().find_first_of("-/", dl+4);
+    int deadlineMs = std::stoi(m_pendingInterestName.toUri().substr(dl+4, de-dl-4));
+    m_jobDeadline[userId] = MilliSeconds(deadlineMs);
+    // children get half of it, so their partial replies still make it into ours
+    uint64_t tdl = childTask.find("/dl.");
+    uint64_t tde = childTask.find_first_of("-/", tdl+4);
+    childTask = childTask.substr(0, tdl+4) + std::to_string(deadlineMs / 2) + childTask.substr(tde);
+  };
+  bool shortFold = m_jobDeadline[userId].IsStrictlyPositive() || m_jobStragglerMode[userId] == "partial";
+  // late fills go to the node this task came from, the sink unless it names an upper reducer
+  std::string parent = userId;
+  uint64_t up = m_pendingInterestName.toUri().find("/up<");
+  if(up != std::string::npos) {
+    parent = m_pendingInterestName.toUri().substr(up+4, m_pendingInterestName.toUri().find(">", up)-up-4);
+  };
 
-  std::string treeIdSeq = userId + "-" + seqNum;
-  SaveSeqInterestName(treeIdSeq, m_pendingInterestName.toUri());
-  std::map<std::string, int>::iterator checkSeq = m_seqDataSendNum.find(treeIdSeq);
-  if(checkSeq == m_seqDataSendNum.end()) {
-    m_seqDataSendNum.insert(std::pair<std::string, int>(treeIdSeq, 0));
-  }
+  std::vector<std::string> treeIdSeqs;
+  for(uint32_t k=firstSeq; k<=lastSeq; k++) {
+    std::string treeIdSeq = userId + "-Seq" + std::to_string(k);
+    treeIdSeqs.push_back(treeIdSeq);
+    SaveSeqInterestName(treeIdSeq, m_pendingInterestName.toUri());
+    if(shortFold) {
+      m_seqParent[treeIdSeq] = parent;
+    };
+    std::map<std::string, int>::iterator checkSeq = m_seqDataSendNum.find(treeIdSeq);
+    if(checkSeq == m_seqDataSendNum.end()) {
+      m_seqDataSendNum.insert(std::pair<std::string, int>(treeIdSeq, 0));
+    }
+  };
   int sendTaskNum = 0;
   std::map<std::string, std::string>::iterator fUser = m_jobRefMap.find(userId);
 
@@ -1033,7 +1543,10 @@ WqCheckpointReducer::ProcessNormalInterest(shared_ptr<const Interest> taskIntere
               m_receiveNodeandData.insert(std::pair<std::string, std::string>(m_nodeList4Task[s], ""));
             };
 
-            std::string creatTask = m_nodeList4Task[s] + m_assignTask + "-";
+            std::string creatTask = m_nodeList4Task[s] + childTask + "-";
+            if(shortFold) {
+              creatTask += "/up<" + m_prefix.toUri() + ">-";
+            };
             std::cout << m_prefix.toUri() << " creat: " << creatTask << std::endl; 
             shared_ptr<Name> mapTaskName = make_shared<Name>(creatTask);
             mapTaskName->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
@@ -1044,6 +1557,9 @@ WqCheckpointReducer::ProcessNormalInterest(shared_ptr<const Interest> taskIntere
             //std::cout << "111 to sensor " << ": " << *subInterest << std::endl;
             m_transmittedInterests(mapTaskInterest, this, m_face);
             m_appLink->onReceiveInterest(*mapTaskInterest);
+            for(uint64_t k=0; k<treeIdSeqs.size(); k++) {
+              m_childSentTime[treeIdSeqs[k]][m_nodeList4Task[s]] = Simulator::Now();
+            };
             sendTaskNum++;
             creatTask.clear();
           }
@@ -1062,7 +1578,23 @@ WqCheckpointReducer::ProcessNormalInterest(shared_ptr<const Interest> taskIntere
           }
         }
       };
-      m_seqDataSendNum.at(treeIdSeq) = sendTaskNum;
+      for(uint64_t k=0; k<treeIdSeqs.size(); k++) {
+        m_seqDataSendNum.at(treeIdSeqs[k]) = sendTaskNum;
+      };
+      std::string stragglerMode = m_jobStragglerMode[userId];
+      if(sendTaskNum != 0 && (stragglerMode == "replica" || stragglerMode == "partial")
+         && m_childLatency.size() >= m_stragglerMinSamples) {
+        Time threshold = StragglerThreshold();
+        for(uint64_t k=0; k<treeIdSeqs.size(); k++) {
+          m_seqTask[treeIdSeqs[k]] = m_assignTask;
+          Simulator::Schedule(threshold, &WqCheckpointReducer::CheckStragglers, this, treeIdSeqs[k]);
+        };
+      };
+      if(sendTaskNum != 0 && m_jobDeadline[userId].IsStrictlyPositive()) {
+        for(uint64_t k=0; k<treeIdSeqs.size(); k++) {
+          Simulator::Schedule(m_jobDeadline[userId], &WqCheckpointReducer::ExpireDeadline, this, treeIdSeqs[k]);
+        };
+      };
       sendTaskNum = 0;
       // for (auto& x: m_seqDataSendNum) {
       //   std::cout << m_prefix.toUri() << "send SEQ" << x.first << ": " << x.second << '\n';
@@ -1101,6 +1633,15 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
   uint64_t newUpNei = m_pendingInterestName.toUri().find("newUp");
   uint64_t first_job = m_pendingInterestName.toUri().find("child");
   uint64_t rollback = m_pendingInterestName.toUri().find("rollback");
+  uint64_t standby = m_pendingInterestName.toUri().find("standby");
+  uint64_t replica = m_pendingInterestName.toUri().find("replica");
+  uint64_t promote = m_pendingInterestName.toUri().find("promote");
+  uint64_t cpLead = m_pendingInterestName.toUri().find("cpLead");
+  uint64_t cpCost = m_pendingInterestName.toUri().find("cpCost");
+  uint64_t release = m_pendingInterestName.toUri().find("release");
+  uint64_t adopt = m_pendingInterestName.toUri().find("adopt");
+  uint64_t plan = m_pendingInterestName.toUri().find("/plan<");
+  uint64_t fill = m_pendingInterestName.toUri().find("/fill-");
   
   //get current userId
   uint64_t t1 = m_pendingInterestName.toUri().find("TS");
@@ -1109,6 +1650,7 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     uint64_t t2 = m_pendingInterestName.toUri().find("TE");
     m_treeTag = m_pendingInterestName.toUri().substr(t1+2, t2-t1-3);
     // std::cout << "Reducer " << m_prefix.toUri() << " rececive tree tag: "<< m_treeTag <<std::endl;
+    SwitchJob(m_treeTag);
   }
   
   // Interest for build tree
@@ -1611,6 +2153,125 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     m_upNodeFail=true;
     RejoinTreeDueToUpNeiFail(cancelUpLink);
   }
+  // sink designates the warm standby of this reducer
+  else if (standby != std::string::npos)
+  {
+    uint64_t s1 = m_pendingInterestName.toUri().find("(");
+    uint64_t s2 = m_pendingInterestName.toUri().find(")");
+    m_standbyNode = m_pendingInterestName.toUri().substr(s1+1, s2-s1-1);
+    std::cout << m_prefix.toUri() << " set Standby-reducer: " << m_standbyNode << std::endl;
+    m_replicaSent.clear();
+    m_replicaDirty.clear();
+    m_replicaAcked = 0;
+    Simulator::Cancel(m_replicaEvent);
+    m_replicaEvent = Simulator::Schedule(m_replicaInterval, &WqCheckpointReducer::ReplicateState, this, m_currentTreeFlag);
+    ReplyData("standby-OK", m_pendingInterestName.toUri());
+  }
+  // committed seq-data streamed from the reducer this node stands by for
+  else if (replica != std::string::npos)
+  {
+    std::string replicaName = m_pendingInterestName.toUri();
+    uint64_t s1 = replicaName.find("(");
+    uint64_t s2 = replicaName.find(")");
+    std::string primary = replicaName.substr(s1+1, s2-s1-1);
+    uint64_t w1 = replicaName.find("(", s2);
+    uint64_t w2 = replicaName.find(")", w1);
+    m_replicaWatermark[primary] = std::stoi(replicaName.substr(w1+1, w2-w1-1));
+    std::string entries = replicaName.substr(w2+2);
+    uint64_t e = entries.find(";");
+    while(e != std::string::npos) {
+      std::string entry = entries.substr(0, e);
+      uint64_t q = entry.find("-");
+      if(entry.substr(0, 3) == "Seq" && q != std::string::npos) {
+        m_replicaSeqData[primary][entry.substr(0, q)] = entry;
+      };
+      entries = entries.substr(e+1);
+      e = entries.find(";");
+    };
+    // the ack carries the watermark back, the primary stops tracking what lies below it
+    ReplyData("replica-OK&" + std::to_string(m_replicaWatermark[primary]), replicaName);
+  }
+  // promoted by sink to take over the group of a failed reducer, the replica avoids a rollback
+  else if (promote != std::string::npos)
+  {
+    m_currentTreeFlag = m_treeTag;
+    std::cout << m_prefix.toUri() << " ---- receive Promote-standby-task " << std::endl;
+    uint64_t c1 = m_pendingInterestName.toUri().find("<");
+    uint64_t c2 = m_pendingInterestName.toUri().find(">");
+    uint64_t f1 = m_pendingInterestName.toUri().find("(", c2);
+    uint64_t f2 = m_pendingInterestName.toUri().find(")", f1);
+    std::string primary = m_pendingInterestName.toUri().substr(f1+1, f2-f1-1);
+    m_jobRefNei = m_pendingInterestName.toUri().substr(c1+1, c2-c1-1);
+    ProcessTaskNeis(m_jobRefNei);
+    CreateJobNeiList();
+    std::map<std::string, std::string>::iterator it;
+    for(it=m_replicaSeqData[primary].begin(); it!=m_replicaSeqData[primary].end(); it++) {
+      m_processedSeqData[it->first] = it->second;
+      m_restoredSeqs.insert(it->first);
+    };
+    std::string replyContent = "OK-As-Promoted-Reducer&" + std::to_string(m_replicaWatermark[primary]);
+    m_replicaSeqData.erase(primary);
+    m_replicaWatermark.erase(primary);
+    ReplyData(replyContent, m_pendingInterestName.toUri());
+  }
+  // sink asks the FIB cost from this node to the listed nodes, for job placement
+  else if (cpCost != std::string::npos)
+  {
+    std::string costName = m_pendingInterestName.toUri();
+    uint64_t c1 = costName.find("<");
+    uint64_t c2 = costName.find(">");
+    std::string nodeList = costName.substr(c1+1, c2-c1-1);
+    std::vector<std::string> costNodes;
+    uint64_t n = nodeList.find("-");
+    while(n != std::string::npos) {
+      costNodes.push_back(nodeList.substr(0, n+1));
+      nodeList = nodeList.substr(n+1);
+      n = nodeList.find("-");
+    };
+    std::cout << m_prefix.toUri() << " receive Placement-cost request, Num= " << costNodes.size() << std::endl;
+    // reply "c1,c2,..." in the order asked by sink, all read from the local FIB at once
+    std::vector<uint64_t> costs = GetFibCosts(costNodes);
+    std::string costList = "";
+    for(uint64_t i=0; i<costs.size(); i++) {
+      costList += (i == 0 ? "" : ",") + std::to_string(costs[i]);
+    };
+    ReplyData(costList, costName);
+  }
+  // sink delegates the collection of one checkpoint to this reducer
+  else if (cpLead != std::string::npos)
+  {
+    std::string leadName = m_pendingInterestName.toUri();
+    uint64_t c1 = leadName.find("<");
+    uint64_t c2 = leadName.find(">");
+    uint64_t v1 = leadName.find("(", c2);
+    uint64_t v2 = leadName.find(")", v1);
+    // cpIDs of different jobs overlap, the coordinator is keyed by tree-id + cpID
+    std::string cpID = m_currentTreeFlag + leadName.substr(v1+1, v2-v1-1);
+    std::string nodeList = leadName.substr(c1+1, c2-c1-1);
+    std::vector<std::string> cpNodes;
+    uint64_t n = nodeList.find("-");
+    while(n != std::string::npos) {
+      cpNodes.push_back(nodeList.substr(0, n+1));
+      nodeList = nodeList.substr(n+1);
+      n = nodeList.find("-");
+    };
+    std::cout << m_prefix.toUri() << " lead Checkpoint-ID= " << cpID << " Num= " << cpNodes.size() << std::endl;
+    if(!m_cpCoordinator.BeginCheckpoint(cpID, cpNodes)) {
+      return;
+    };
+    m_cpLeadInterest[cpID] = leadName;
+    m_cpLeadRecords[cpID] = "";
+    m_cpLeadTimeouts[cpID] = Simulator::Schedule(m_interestLifeTime, &WqCheckpointReducer::ExpireLeadCheckpoint, this, cpID);
+    for(uint64_t i=0; i<cpNodes.size(); i++) {
+      if(cpNodes[i] == m_prefix.toUri()) {
+        // own state is checkpointed here, not through the network
+        OnCheckpointReply(cpID, cpNodes[i], CheckpointReplyContent());
+      }
+      else {
+        SendOutInterest(cpNodes[i] + "/cpSeq(" + leadName.substr(v1+1, v2-v1-1) + ")-/TS" + m_currentTreeFlag + "/TE-");
+      };
+    };
+  }
   // to checkpoint
   else if (cp != std::string::npos)
   {
@@ -1622,14 +2283,7 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     }
     else {
       std::cout << m_prefix.toUri() << " receive Checkpoint-msg " << std::endl;
-      std::string replyContent = "";
-      if(m_cpFailure){
-        replyContent = m_prefix.toUri() + "&Fail";
-      }
-      else{
-        replyContent = m_prefix.toUri() + "&OK";
-      };
-      ReplyData(replyContent, m_pendingInterestName.toUri());
+      ReplyData(CheckpointReplyContent(), m_pendingInterestName.toUri());
     }
   }
   // to act as a recover reducer by sink
@@ -1644,21 +2298,129 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     // std::cout << m_prefix.toUri() <<" childs: " << m_jobRefNei <<std::endl;
     ProcessTaskNeis(m_jobRefNei);
     CreateJobNeiList();
+    // "/st<hex>": checkpointed seq-data of the failed reducer, rebuilt by sink from its record chain
+    uint64_t st1 = m_pendingInterestName.toUri().find("/st<", c2);
+    if(st1 != std::string::npos) {
+      uint64_t st2 = m_pendingInterestName.toUri().find(">", st1);
+      std::string record;
+      bool full = false;
+      std::map<uint64_t, int64_t> entries;
+      std::vector<uint64_t> removed;
+      if(WqCheckpointCodec::FromHex(m_pendingInterestName.toUri().substr(st1+4, st2-st1-4), record) &&
+         WqCheckpointCodec::DecodeRecord(record, full, entries, removed)) {
+        std::map<uint64_t, int64_t>::iterator e;
+        for(e=entries.begin(); e!=entries.end(); e++) {
+          std::string eachSeq = "Seq" + std::to_string(e->first);
+          m_processedSeqData[eachSeq] = eachSeq + "-" + std::to_string(e->second);
+          m_restoredSeqs.insert(eachSeq);
+        };
+        std::cout << m_prefix.toUri() << " restored Checkpoint-State entries= " << entries.size() << std::endl;
+      }
+      else {
+        std::cout << m_prefix.toUri() << " got broken Checkpoint-State" << std::endl;
+      };
+    };
     ReplyData(" OK-As-Recover-Reducer", m_pendingInterestName.toUri());
   }
+  // sink places this reducer below another reducer of the reduction tree
+  else if (plan != std::string::npos)
+  {
+    m_currentTreeFlag = m_treeTag;
+    uint64_t c1 = m_pendingInterestName.toUri().find("<");
+    uint64_t c2 = m_pendingInterestName.toUri().find(">");
+    uint64_t f1 = m_pendingInterestName.toUri().find("(", c2);
+    uint64_t f2 = m_pendingInterestName.toUri().find(")", f1);
+    m_myPathID = m_pendingInterestName.toUri().substr(f1+1, f2-f1-1);
+    m_jobRefNei = m_pendingInterestName.toUri().substr(c1+1, c2-c1-1);
+    std::cout << m_prefix.toUri() << " planned at pathId= " << m_myPathID << " childs: " << m_jobRefNei << std::endl;
+    ProcessTaskNeis(m_jobRefNei);
+    CreateJobNeiList();
+    for(uint64_t c=0; c<m_nodeList4Task.size(); c++) {
+      NewJoinAssignId(m_nodeList4Task[c]);
+    };
+    ReplyData("plan-OK", m_pendingInterestName.toUri());
+  }
+  // corrected value of a child that replied partial, "/fill-/TS../TE-/(SeqK)-/from<child>-/v<hex value>-"
+  else if (fill != std::string::npos)
+  {
+    std::string fillName = m_pendingInterestName.toUri();
+    uint64_t s1 = fillName.find("(");
+    std::string rxSeq = fillName.substr(s1+1, fillName.find(")")-s1-1);
+    uint64_t f1 = fillName.find("/from<");
+    std::string child = fillName.substr(f1+6, fillName.find(">", f1)-f1-6);
+    uint64_t v1 = fillName.find("/v<");
+    std::string value;
+    bool decoded = WqCheckpointCodec::FromHex(fillName.substr(v1+3, fillName.find(">", v1)-v1-3), value);
+    std::string treeIdSeq = m_treeTag + "-" + rxSeq;
+    bool processed = std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) != m_processOkSeq.end();
+    if(!decoded) {
+      std::cout << m_prefix.toUri() << " drops an undecodable fill: " << fillName << std::endl;
+    }
+    else if(!processed || m_partialFolded.find(treeIdSeq) != m_partialFolded.end()) {
+      LateFill(treeIdSeq, child, child + rxSeq + "-" + value);
+    };
+    ReplyData("fill-OK", fillName);
+  }
+  // sink moves some mappers to another reducer, tasks of later seqs skip them
+  else if (release != std::string::npos || adopt != std::string::npos)
+  {
+    m_currentTreeFlag = m_treeTag;
+    uint64_t c1 = m_pendingInterestName.toUri().find("<");
+    uint64_t c2 = m_pendingInterestName.toUri().find(">");
+    std::string nodeList = m_pendingInterestName.toUri().substr(c1+1, c2-c1-1);
+    std::string jobRef = m_jobRefMap[m_currentTreeFlag];
+    uint64_t n = nodeList.find("-");
+    while(n != std::string::npos) {
+      std::string mapper = nodeList.substr(0, n+1);
+      nodeList = nodeList.substr(n+1);
+      n = nodeList.find("-");
+      uint64_t j = jobRef.find(mapper);
+      if(release != std::string::npos) {
+        if(j != std::string::npos) {
+          jobRef.erase(j, mapper.size());
+        };
+        m_neiReachable.erase(m_prefix.toUri() + mapper + m_currentTreeFlag);
+        AddLostNeiId(mapper);
+      }
+      else {
+        if(j == std::string::npos) {
+          jobRef += mapper;
+        };
+        m_neiReachable[m_prefix.toUri() + mapper + m_currentTreeFlag] = "true";
+        NewJoinAssignId(mapper);
+      };
+    };
+    std::cout << m_prefix.toUri() << " handover, childs now: " << jobRef << std::endl;
+    m_jobRefMap[m_currentTreeFlag] = jobRef;
+    m_jobRefNei = jobRef;
+    // the task node list is rebuilt from m_jobRefMap with the next seq
+    jobNeiChangeFlag = true;
+    ReplyData(release != std::string::npos ? "release-OK" : "adopt-OK", m_pendingInterestName.toUri());
+  }
   // rollback notification, need clear previous records to restart
   else if (rollback != std::string::npos)
   {
-    m_seqDataSendNum.clear();
-    m_seqDataGotNum.clear();
-    m_allReceiveSeqData.clear();
-    m_seqInterestName.clear();
+    // the tree tag of the Interest selected the job, the other jobs keep their records
+    std::string jobSeq = m_currentTreeFlag + "-Seq";
+    EraseJobSeqs(m_seqDataSendNum, jobSeq);
+    EraseJobSeqs(m_seqDataGotNum, jobSeq);
+    EraseJobSeqs(m_allReceiveSeqData, jobSeq);
+    EraseJobSeqs(m_seqInterestName, jobSeq);
+    std::vector<std::string> keptOkSeq;
+    for(uint64_t k=0; k<m_processOkSeq.size(); k++) {
+      if(m_processOkSeq[k].compare(0, jobSeq.size(), jobSeq) != 0) {
+        keptOkSeq.push_back(m_processOkSeq[k]);
+      };
+    };
+    m_processOkSeq.swap(keptOkSeq);
     m_groupIds.clear();
     m_computeGroup.clear();
-    m_processOkSeq.clear();
     m_countdata=0;
     m_countSeq.clear();
     m_receiveNodeandData.clear();
+    // the sink starts a new checkpoint chain for this node
+    m_cpCount=0;
+    m_cpSnapshot.clear();
     ReplyData("rollback-OK", m_pendingInterestName.toUri());
   }
   // receive msg to change upstrem nei
@@ -1703,7 +2465,7 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     std::cout << m_prefix.toUri() <<" childs: " << m_jobRefNei <<std::endl;
     ProcessTaskNeis(m_jobRefNei);
     CreateJobNeiList();
-    ProcessNormalInterest(interest);
+    EnqueueTask(interest);
   }
   //normal Interest
   else 
@@ -1724,13 +2486,327 @@ WqCheckpointReducer::OnInterest(shared_ptr<const Interest> interest)
     // Simulator::Schedule(Seconds(32), &WqCheckpointReducer::LinkBroken, this, "/5-", "/m3-");
     // Simulator::Schedule(Seconds(63), &WqCheckpointReducer::LinkBroken, this, "/1-", "/m5-");
     std::cout << m_prefix.toUri() <<" get normal Interest: " << m_pendingInterestName.toUri() <<std::endl;
-    m_normalInterest = interest;
-    ProcessNormalInterest(m_normalInterest);
+    EnqueueTask(interest);
     // std::string requestPit = "/p-" + m_pendingInterestName.toUri();
     // SendOutInterest(requestPit);
   }
 };
 
+Time
+WqCheckpointReducer::StragglerThreshold()
+{
+  std::vector<double> samples(m_childLatency.begin(), m_childLatency.end());
+  std::sort(samples.begin(), samples.end());
+  return Seconds(samples[(samples.size() - 1) * m_stragglerPercentile / 100]);
+};
+
+void
+WqCheckpointReducer::CheckStragglers(std::string treeIdSeq)
+{
+  if(std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) != m_processOkSeq.end()) {
+    m_stragglerChecks.erase(treeIdSeq);
+    return;
+  };
+  std::string treeId = treeIdSeq.substr(0, treeIdSeq.find("-Seq"));
+  SwitchJob(treeId);
+  std::map<std::string, Time>& sent = m_childSentTime[treeIdSeq];
+  std::set<std::string>& answered = m_seqAnswered[treeIdSeq];
+
+  if(m_jobStragglerMode[treeId] == "replica") {
+    std::string task = m_seqTask[treeIdSeq];
+    uint64_t s1 = task.find("(");
+    uint32_t firstSeq = 0;
+    uint32_t lastSeq = 0;
+    WqSeqBatch::ParseRange(task.substr(s1+1, task.find(")")-s1-1), firstSeq, lastSeq);
+    std::vector<std::string> slow;
+    for(std::map<std::string, Time>::iterator it=sent.begin(); it!=sent.end(); it++) {
+      if(answered.find(it->first) == answered.end()) {
+        slow.push_back(it->first);
+      };
+    };
+    for(uint64_t c=0; c<slow.size(); c++) {
+      std::map<std::string, std::string>::iterator replica = m_mapperReplica.find(slow[c]);
+      // no replica, or it is asked already (own child, or for another seq of the same batch)
+      if(replica == m_mapperReplica.end() || sent.find(replica->second) != sent.end()) {
+        continue;
+      };
+      std::cout << m_prefix.toUri() << " straggler " << slow[c] << " of " << treeIdSeq << ", ask replica " << replica->second << std::endl;
+      for(uint32_t k=firstSeq; k<=lastSeq; k++) {
+        m_childSentTime[treeId + "-Seq" + std::to_string(k)][replica->second] = Simulator::Now();
+      };
+      // "/bk-" asks the replica to answer even for seqs it already sent to its own reducer
+      SendOutInterest(replica->second + task + "-/bk-");
+    };
+  }
+  else if(m_jobStragglerMode[treeId] == "partial") {
+    std::map<std::string, int>::iterator got = m_seqDataGotNum.find(treeIdSeq);
+    if(got == m_seqDataGotNum.end()) {
+      // nothing to fold yet: the job deadline folds it with no coverage, otherwise look again
+      // one threshold later, a bounded number of times, and leave the seq to the sink's doubt check
+      if(m_jobDeadline[treeId].IsStrictlyPositive()) {
+        return;
+      };
+      if(++m_stragglerChecks[treeIdSeq] > m_stragglerRetries) {
+        std::cout << m_prefix.toUri() << " straggler, no data of " << treeIdSeq << ", give up" << std::endl;
+        m_stragglerChecks.erase(treeIdSeq);
+        return;
+      };
+      Simulator::Schedule(StragglerThreshold(), &WqCheckpointReducer::CheckStragglers, this, treeIdSeq);
+      return;
+    };
+    m_stragglerChecks.erase(treeIdSeq);
+    std::cout << m_prefix.toUri() << " straggler, fold " << treeIdSeq << " with " << got->second << "/" << m_seqDataSendNum[treeIdSeq] << std::endl;
+    FoldPartial(treeIdSeq);
+  };
+};
+
+void
+WqCheckpointReducer::FoldPartial(std::string treeIdSeq)
+{
+  // reply with the children heard so far, the rest is counted as missing coverage
+  int got = m_seqDataGotNum[treeIdSeq];
+  m_partialSeqs[treeIdSeq] = m_seqDataSendNum[treeIdSeq] - got;
+  m_seqDataSendNum[treeIdSeq] = got;
+  ProcessDataBySeq(treeIdSeq);
+};
+
+void
+WqCheckpointReducer::ExpireDeadline(std::string treeIdSeq)
+{
+  if(std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) != m_processOkSeq.end()) {
+    return;
+  };
+  SwitchJob(treeIdSeq.substr(0, treeIdSeq.find("-Seq")));
+  std::cout << m_prefix.toUri() << " deadline of " << treeIdSeq << ", fold with " << m_seqDataGotNum[treeIdSeq] << "/" << m_seqDataSendNum[treeIdSeq] << std::endl;
+  FoldPartial(treeIdSeq);
+};
+
+void
+WqCheckpointReducer::LateFill(std::string treeIdSeq, std::string child, std::string entry)
+{
+  // entry = child + "SeqK-v", replaces the value the child gave before or adds a missing child
+  std::string& alldata = m_allReceiveSeqData[treeIdSeq];
+  std::vector<std::string> entries;
+  bool replaced = false;
+  uint64_t pos = 0;
+  while(pos < alldata.size()) {
+    uint64_t comma = alldata.find(",", pos);
+    std::string each = alldata.substr(pos, comma-pos);
+    if(each.compare(0, child.size() + 3, child + "Seq") == 0) {
+      each = entry;
+      replaced = true;
+    };
+    entries.push_back(each);
+    pos = (comma == std::string::npos) ? alldata.size() : comma+1;
+  };
+  if(!replaced) {
+    entries.push_back(entry);
+    if(m_partialSeqs[treeIdSeq] > 0) {
+      m_partialSeqs[treeIdSeq]--;
+    };
+  };
+  alldata.clear();
+  for(uint64_t e=0; e<entries.size(); e++) {
+    alldata += (e == 0 ? "" : ",") + entries[e];
+  };
+  if(std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) == m_processOkSeq.end()) {
+    // not replied yet, the new value is simply folded in then
+    return;
+  };
+
+  std::string rxSeq = treeIdSeq.substr(treeIdSeq.find("Seq"));
+  std::string rawData = AggregateSeqData(alldata, m_partialSeqs[treeIdSeq]);
+  m_processedSeqData[rxSeq] = rxSeq + "-" + rawData;
+  // the standby may already hold the old value of a seq below its acked watermark
+  if((uint32_t)std::stoul(rxSeq.substr(3)) <= m_replicaAcked) {
+    m_replicaDirty.insert(std::stoul(rxSeq.substr(3)));
+  };
+  ArmReplica();
+  std::string treeId = treeIdSeq.substr(0, treeIdSeq.find("-Seq"));
+  // a partial value like "12p3/5" holds a "/", so the value travels hex encoded
+  std::string fill = m_seqParent[treeIdSeq] + "/fill-/TS" + treeId + "/TE-/(" + rxSeq + ")-/from<" + m_prefix.toUri() + ">-/v<" + WqCheckpointCodec::ToHex(rawData) + ">-";
+  std::cout << m_prefix.toUri() << " late fill: " << fill << std::endl;
+  SendOutInterest(fill);
+  if(rawData.find("p") == std::string::npos) {
+    m_partialFolded.erase(treeIdSeq);
+    m_partialSeqs.erase(treeIdSeq);
+    m_seqAnswered.erase(treeIdSeq);
+    m_seqParent.erase(treeIdSeq);
+  };
+};
+
+void
+WqCheckpointReducer::ReceiveSeqData(std::string gotData, std::string receivedData)
+{
+  uint64_t u1 = gotData.find("TS");
+  uint64_t u2 = gotData.find("TE");
+  std::string receiveTreeId = gotData.substr(u1+2, u2-u1-3);
+  // std::cout << m_prefix.toUri() << "   //////////// receive == " << receivedData << std::endl;
+  uint64_t s1 = receivedData.find("(");
+  uint64_t s = receivedData.find("-Seq");
+  uint64_t f = receivedData.find("-");
+  std::string receiveSeqNum;
+  if(s == std::string::npos) {
+    receiveSeqNum = receivedData.substr(0,f);
+  }
+  else {
+    receiveSeqNum = receivedData.substr(s+1, s1-s-1);
+  };
+  std::string receiveNeiName = gotData.substr(0, u1-1);
+  std::string treeIdSeq = receiveTreeId + "-" + receiveSeqNum;
+
+  std::string stragglerMode = m_jobStragglerMode[receiveTreeId];
+  std::map<std::string, std::map<std::string, Time>>::iterator sentSeq = m_childSentTime.find(treeIdSeq);
+  if(sentSeq != m_childSentTime.end()) {
+    std::map<std::string, Time>::iterator sentChild = sentSeq->second.find(receiveNeiName);
+    if(sentChild != sentSeq->second.end()) {
+      m_childLatency.push_back((Simulator::Now() - sentChild->second).GetSeconds());
+      if(m_childLatency.size() > 200) {
+        m_childLatency.pop_front();
+      };
+    };
+  };
+  if(stragglerMode == "replica") {
+    // a replica answers for the mapper it stands in for, only the first of the two is counted
+    std::map<std::string, std::string>::iterator standIn = m_mapperReplica.find(receiveNeiName);
+    if(standIn != m_mapperReplica.end()
+       && std::find(m_nodeList4Task.begin(), m_nodeList4Task.end(), receiveNeiName) == m_nodeList4Task.end()) {
+      receiveNeiName = standIn->second;
+    };
+  };
+  if(stragglerMode == "replica" || stragglerMode == "partial" || m_jobDeadline[receiveTreeId].IsStrictlyPositive()) {
+    bool processed = std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) != m_processOkSeq.end();
+    if(processed && m_partialFolded.find(treeIdSeq) == m_partialFolded.end()) {
+      std::cout << m_prefix.toUri() << " drop late data of " << treeIdSeq << " from " << receiveNeiName << std::endl;
+      return;
+    };
+    if(!m_seqAnswered[treeIdSeq].insert(receiveNeiName).second) {
+      std::cout << m_prefix.toUri() << " drop duplicate data of " << treeIdSeq << " for " << receiveNeiName << std::endl;
+      return;
+    };
+    if(processed) {
+      // a child heard after the partial reply
+      LateFill(treeIdSeq, receiveNeiName, receiveNeiName + receivedData);
+      return;
+    };
+  };
+
+  std::map<std::string, std::string>::iterator checkNode = m_receiveNodeandData.find(receiveNeiName);
+  if (checkNode != m_receiveNodeandData.end())
+  {
+    if(checkNode->second == "")
+    {
+      checkNode->second = receivedData;
+    }
+    else
+    {
+      checkNode->second = checkNode->second + ";" +receivedData;
+    };
+  }
+  else {
+    std::cout << m_prefix.toUri() << " receive wrong downstream data from " <<  receiveNeiName << std::endl;
+  };
+  // for (auto& x: m_receiveNodeandData) {
+  //   std::cout << m_prefix.toUri() << " nodeID: " << x.first << " data= "<< x.second << std::endl;
+  // };
+
+  if ( std::find(m_countSeq.begin(), m_countSeq.end(), treeIdSeq) == m_countSeq.end() )
+  {
+    m_countSeq.push_back(treeIdSeq);
+    m_countdata += 1;
+    // std::cout<< m_prefix.toUri() << "////// count= " <<  m_countdata << std::endl;
+  };
+
+  uint64_t s2 = receiveSeqNum.find("q");
+  std::string numonly = receiveSeqNum.substr(s2+1);
+  std::string insertId;
+  for(uint64_t j = 0; j < m_groupIds.size(); j++)
+  {
+    uint64_t k = m_groupIds[j].find("-");
+    std::string smallId = m_groupIds[j].substr(0,k);
+    std::string bigId = m_groupIds[j].substr(k+1);
+    // std::cout<< m_prefix.toUri() << "groupIds: " << smallId << " and " << bigId << " rxSeqnum= " << receiveSeqNum << std::endl;
+    if ((stoi(numonly) >= stoi(smallId)) & (stoi(numonly) <= stoi(bigId))) 
+    {
+      std::cout<< m_prefix.toUri() << "seq in Group: " << m_groupIds[j] << std::endl;
+      insertId = receiveTreeId + "-Seq" + m_groupIds[j];
+      if(m_computeGroup[insertId] == "") {
+        m_computeGroup[insertId] = treeIdSeq + ";" ;
+      }
+      else {
+        uint64_t checkid = m_computeGroup[insertId].find(treeIdSeq);
+        if (checkid == std::string::npos) {
+          m_computeGroup[insertId] = m_computeGroup[insertId] + treeIdSeq + ";" ;
+        };
+      };
+    };
+  };
+  // std::cout<< m_prefix.toUri() << "compute-group = " << m_computeGroup[insertId] << std::endl;
+  // for (auto& x: m_computeGroup) {
+  //   std::cout << m_prefix.toUri() << " groupID: " << x.first << " groupSeq= "<< x.second << std::endl;
+  // };
+
+  std::map<std::string, int>::iterator checkSeq = m_seqDataGotNum.find(treeIdSeq);
+  receivedData = receiveNeiName + receivedData;
+  if(checkSeq == m_seqDataGotNum.end()) {
+    m_seqDataGotNum.insert(std::pair<std::string, int>(treeIdSeq, 1));
+    m_allReceiveSeqData.insert(std::pair<std::string, std::string>(treeIdSeq, receivedData));
+  }
+  else {
+    m_seqDataGotNum.at(treeIdSeq) += 1;
+    m_allReceiveSeqData.at(treeIdSeq) += "," + receivedData;
+  };
+  // for (auto& x: m_allReceiveSeqData) {
+  //   std::cout << m_prefix.toUri() << " treeSeqID: " << x.first << " data= "<< x.second << std::endl;
+  // };
+
+  // std::cout << m_prefix.toUri() << " rxSeq numOnly= " << numonly << std::endl;
+  if (stoi(numonly) < m_countdata)
+  {
+    if ( std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) == m_processOkSeq.end() )
+    {
+      ProcessDataBySeq(treeIdSeq);
+      // std::cout << m_prefix.toUri() << " receive before Seq " << receiveSeqNum << std::endl; 
+    }; 
+  };
+
+  if (m_countdata >= 5) 
+  {
+    uint64_t aa = m_countdata % 5;
+    if (aa == 0) {
+      int computeIndex = m_countdata / 5 - 1;
+      std::cout<< m_prefix.toUri() << "Call-Process-Data m_countdata= " << m_countdata << " RxId= " <<  receiveSeqNum << std::endl;
+      std::string getId = receiveTreeId + "-Seq" + m_groupIds[computeIndex];
+      // std::cout << m_prefix.toUri() << " getId ====== " << getId << std::endl;
+      std::string idString = m_computeGroup[getId];
+      std::cout << m_prefix.toUri() << " id ====== " << idString << std::endl;
+      std::vector<int> splitVec;
+      std::vector<std::string> idList;
+      uint64_t pos = idString.find(";"); 
+      if (pos == std::string::npos) {
+        idList.push_back(idString);
+      }
+      else {
+        while (pos != std::string::npos){
+          splitVec.push_back(pos);
+          pos = idString.find(";", pos+1);
+        }
+      };
+      if (splitVec.size() != 0) {
+        idList.push_back(idString.substr(0, splitVec[0]));
+        for(uint64_t k=0; k<splitVec.size()-1; k++) {
+          idList.push_back(idString.substr(splitVec[k]+1, splitVec[k+1]-splitVec[k]-1));
+        }
+      };
+      for(uint64_t l = 0; l < idList.size(); l++) 
+      {
+        std::string startProcessId = idList[l];
+        ProcessDataBySeq(startProcessId);
+      }; 
+    };  
+  };
+};
+
 void
 WqCheckpointReducer::OnData(shared_ptr<const Data> data)
 {
@@ -1743,11 +2819,16 @@ WqCheckpointReducer::OnData(shared_ptr<const Data> data)
   //parse data content
     auto *tmpContent = ((uint8_t*)data->getContent().value());
     std::string receivedData;
-    for(uint8_t i=0; i < data->getContent().value_size(); i++) {
+    for(uint64_t i=0; i < data->getContent().value_size(); i++) {
       receivedData.push_back((char)tmpContent[i]);
     };
     
     std::string gotData = data->getName().toUri();
+    uint64_t t1 = gotData.find("TS");
+    uint64_t t2 = gotData.find("TE");
+    if(t1 != std::string::npos && t2 != std::string::npos && t2 > t1) {
+      SwitchJob(gotData.substr(t1+2, t2-t1-3));
+    };
     uint64_t findDis = gotData.find("/discover");
     uint64_t findDis2 = gotData.find("/func");
     uint64_t findRejoin = gotData.find("rejoin");
@@ -2037,6 +3118,26 @@ WqCheckpointReducer::OnData(shared_ptr<const Data> data)
         };
       };
     }
+    //checkpoint reply of a node, for the checkpoint this reducer leads
+    else if(gotData.find("cpSeq") != std::string::npos)
+    {
+      uint64_t v1 = gotData.find("(");
+      uint64_t v2 = gotData.find(")");
+      OnCheckpointReply(m_currentTreeFlag + gotData.substr(v1+1, v2-v1-1), gotData.substr(0, gotData.find_first_of("-")+1), receivedData);
+    }
+    //ACK of replica stream from standby
+    else if(gotData.find("replica") != std::string::npos)
+    {
+      // std::cout << m_prefix.toUri() << " got Replica-ACK: " << receivedData << std::endl;
+      uint64_t a = receivedData.find("&");
+      if(a != std::string::npos) {
+        uint32_t acked = std::stoul(receivedData.substr(a+1));
+        if(acked > m_replicaAcked) {
+          m_replicaAcked = acked;
+          m_replicaSent.erase(m_replicaSent.begin(), m_replicaSent.upper_bound(acked));
+        };
+      };
+    }
     //confirm of cancel-join request
     else if(findCancel != std::string::npos)
     {
@@ -2309,139 +3410,21 @@ WqCheckpointReducer::OnData(shared_ptr<const Data> data)
         uint64_t d1 = gotData.find("Seq");
         uint64_t d2 = gotData.find(")");
         std::string ignoreSeq = gotData.substr(d1, d2-d1);
-        std::string SeqId = receiveTreeId + "-" + ignoreSeq;
-        m_seqDataSendNum[SeqId] = m_seqDataSendNum[SeqId] - 1;
+        uint32_t firstSeq = 0;
+        uint32_t lastSeq = 0;
+        WqSeqBatch::ParseRange(ignoreSeq, firstSeq, lastSeq);
+        for(uint32_t k=firstSeq; k<=lastSeq; k++) {
+          std::string SeqId = receiveTreeId + "-Seq" + std::to_string(k);
+          m_seqDataSendNum[SeqId] = m_seqDataSendNum[SeqId] - 1;
+        };
         // std::cout << m_prefix.toUri() << "get IGNORE == " <<  SeqId << " NUM= " << m_seqDataSendNum[SeqId] << std::endl;
       }
       else 
       {
-        // std::cout << m_prefix.toUri() << "   //////////// receive == " << receivedData << std::endl;
-        uint64_t s1 = receivedData.find("(");
-        uint64_t s = receivedData.find("-Seq");
-        uint64_t f = receivedData.find("-");
-        std::string receiveSeqNum;
-        if(s == std::string::npos) {
-          receiveSeqNum = receivedData.substr(0,f);
-        }
-        else {
-          receiveSeqNum = receivedData.substr(s+1, s1-s-1);
-        };
-        std::string receiveNeiName = gotData.substr(0, u1-1);
-        std::string treeIdSeq = receiveTreeId + "-" + receiveSeqNum;
-
-        std::map<std::string, std::string>::iterator checkNode = m_receiveNodeandData.find(receiveNeiName);
-        if (checkNode != m_receiveNodeandData.end())
-        {
-          if(checkNode->second == "")
-          {
-            checkNode->second = receivedData;
-          }
-          else
-          {
-            checkNode->second = checkNode->second + ";" +receivedData;
-          };
-        }
-        else {
-          std::cout << m_prefix.toUri() << " receive wrong downstream data from " <<  receiveNeiName << std::endl;
-        };
-        // for (auto& x: m_receiveNodeandData) {
-        //   std::cout << m_prefix.toUri() << " nodeID: " << x.first << " data= "<< x.second << std::endl;
-        // };
-
-        if ( std::find(m_countSeq.begin(), m_countSeq.end(), receiveSeqNum) == m_countSeq.end() )
-        {
-          m_countSeq.push_back(receiveSeqNum);
-          m_countdata += 1;
-          // std::cout<< m_prefix.toUri() << "////// count= " <<  m_countdata << std::endl;
-        };
-
-        uint64_t s2 = receiveSeqNum.find("q");
-        std::string numonly = receiveSeqNum.substr(s2+1);
-        std::string insertId;
-        for(uint64_t j = 0; j < m_groupIds.size(); j++)
-        {
-          uint64_t k = m_groupIds[j].find("-");
-          std::string smallId = m_groupIds[j].substr(0,k);
-          std::string bigId = m_groupIds[j].substr(k+1);
-          // std::cout<< m_prefix.toUri() << "groupIds: " << smallId << " and " << bigId << " rxSeqnum= " << receiveSeqNum << std::endl;
-          if ((stoi(numonly) >= stoi(smallId)) & (stoi(numonly) <= stoi(bigId))) 
-          {
-            std::cout<< m_prefix.toUri() << "seq in Group: " << m_groupIds[j] << std::endl;
-            insertId = m_groupIds[j];
-            if(m_computeGroup[insertId] == "") {
-              m_computeGroup[insertId] = treeIdSeq + ";" ;
-            }
-            else {
-              uint64_t checkid = m_computeGroup[insertId].find(treeIdSeq);
-              if (checkid == std::string::npos) {
-                m_computeGroup[insertId] = m_computeGroup[insertId] + treeIdSeq + ";" ;
-              };
-            };
-          };
-        };
-        // std::cout<< m_prefix.toUri() << "compute-group = " << m_computeGroup[insertId] << std::endl;
-        // for (auto& x: m_computeGroup) {
-        //   std::cout << m_prefix.toUri() << " groupID: " << x.first << " groupSeq= "<< x.second << std::endl;
-        // };
-
-        std::map<std::string, int>::iterator checkSeq = m_seqDataGotNum.find(treeIdSeq);
-        receivedData = receiveNeiName + receivedData;
-        if(checkSeq == m_seqDataGotNum.end()) {
-          m_seqDataGotNum.insert(std::pair<std::string, int>(treeIdSeq, 1));
-          m_allReceiveSeqData.insert(std::pair<std::string, std::string>(treeIdSeq, receivedData));
-        }
-        else {
-          m_seqDataGotNum.at(treeIdSeq) += 1;
-          m_allReceiveSeqData.at(treeIdSeq) += "," + receivedData;
-        };
-        // for (auto& x: m_allReceiveSeqData) {
-        //   std::cout << m_prefix.toUri() << " treeSeqID: " << x.first << " data= "<< x.second << std::endl;
-        // };
-        
-        // std::cout << m_prefix.toUri() << " rxSeq numOnly= " << numonly << std::endl;
-        if (stoi(numonly) < m_countdata)
-        {
-          if ( std::find(m_processOkSeq.begin(), m_processOkSeq.end(), treeIdSeq) == m_processOkSeq.end() )
-          {
-            ProcessDataBySeq(treeIdSeq);
-            // std::cout << m_prefix.toUri() << " receive before Seq " << receiveSeqNum << std::endl; 
-          }; 
-        };
-
-        if (m_countdata >= 5) 
-        {
-          uint64_t aa = m_countdata % 5;
-          if (aa == 0) {
-            int computeIndex = m_countdata / 5 - 1;
-            std::cout<< m_prefix.toUri() << "Call-Process-Data m_countdata= " << m_countdata << " RxId= " <<  receiveSeqNum << std::endl;
-            std::string getId = m_groupIds[computeIndex];
-            // std::cout << m_prefix.toUri() << " getId ====== " << getId << std::endl;
-            std::string idString = m_computeGroup[getId];
-            std::cout << m_prefix.toUri() << " id ====== " << idString << std::endl;
-            std::vector<int> splitVec;
-            std::vector<std::string> idList;
-            uint64_t pos = idString.find(";"); 
-            if (pos == std::string::npos) {
-              idList.push_back(idString);
-            }
-            else {
-              while (pos != std::string::npos){
-                splitVec.push_back(pos);
-                pos = idString.find(";", pos+1);
-              }
-            };
-            if (splitVec.size() != 0) {
-              idList.push_back(idString.substr(0, splitVec[0]));
-              for(uint64_t k=0; k<splitVec.size()-1; k++) {
-                idList.push_back(idString.substr(splitVec[k]+1, splitVec[k+1]-splitVec[k]-1));
-              }
-            };
-            for(uint64_t l = 0; l < idList.size(); l++) 
-            {
-              std::string startProcessId = idList[l];
-              ProcessDataBySeq(startProcessId);
-            }; 
-          };  
+        // a batch reply carries one value per seq of its range, each seq is booked on its own
+        std::vector<std::string> seqData = WqSeqBatch::Split(receivedData);
+        for(uint64_t q=0; q<seqData.size(); q++) {
+          ReceiveSeqData(gotData, seqData[q]);
         };
       };
     }
@@ -2576,37 +3559,6 @@ WqCheckpointReducer::OnData(shared_ptr<const Data> data)
           };
           break;
         }
-        
-        case 'n':
-        {
-          uint64_t d1 = gotData.find("-");
-          std::string neiName = gotData.substr(d1+1, gotData.size()-d1-1);
-          std::map<std::string, std::string>::iterator it = m_checkNeibMap.find(neiName);
-          if(it != m_checkNeibMap.end())
-          {
-            //const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-            //const uint8_t* tempVal = reinterpret_cast<const uint8_t*>(receivedData.c_str());
-            m_checkNeibMap[neiName] = receivedData;
-            m_gotDisNeiNum += 1;
-          }
-          //std::cout << "neighour name: " << neiName << std::endl;
-          if(m_sendDisNeiNum == m_gotDisNeiNum) 
-          { 
-            //std::cout << "R receive all disNeiInterests" <<std::endl;
-            for(it=m_checkNeibMap.begin(); it != m_checkNeibMap.end(); ++it)
-            {
-              if(it->second == "1")
-              { 
-                m_oneHopNeighbours.push_back(it->first);
-                //std::cout << "it -> first: " << it->first <<std::endl;
-              }
-            }
-            //std::cout << "next-hop neighbour number: " << m_oneHopNeighbours.size() <<std::endl;
-            DiscoverDownstreams();
-            m_checkNeibMap.clear();
-          }
-          break;
-        }
       };
     }
 
@@ -23,9 +23,11 @@
 #include "ns3/ndnSIM/model/ndn-common.hpp"
 #include "ns3/random-variable-stream.h"
 #include "ndn-app.hpp"
+#include "ndn-wq-checkpoint-coordinator.hpp"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include <deque>
+#include <set>
 
 
 namespace ns3 {
@@ -41,6 +43,8 @@ namespace ndn {
  * with Data packet with a specified size and name same as in Interest.
  */
 class WqCheckpointReducer : public App {
+  struct JobContext;
+
 public:
   static TypeId
   GetTypeId(void);
@@ -50,6 +54,9 @@ public:
   // inherited from NdnApp
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
+
+  virtual int64_t
+  AssignStreams(int64_t stream);
   // From App
   virtual void
   OnData(shared_ptr<const Data> contentObject);
@@ -82,6 +89,25 @@ public:
   void RejoinTreeDueToUpNeiFail(std::string preChooseLink);
   void ReportFailure(std::string downNei, std::string seqNum);
   void CreateJobNeiList();
+  void ReplicateState(std::string treeId);
+  void NoteReplied(uint32_t seq);
+  void ArmReplica();
+  std::string EncodeCheckpointState();
+  std::string CheckpointReplyContent();
+  void OnCheckpointReply(std::string cpID, std::string node, std::string content);
+  void ExpireLeadCheckpoint(std::string cpID);
+  void SwitchJob(std::string treeId);
+  void SwapJobContext(JobContext& ctx);
+  void EnqueueTask(shared_ptr<const Interest> taskInterest);
+  void DispatchTasks();
+  void FinishJobTask(std::string treeIdSeq);
+  void ReceiveSeqData(std::string gotData, std::string receivedData);
+  Time StragglerThreshold();
+  void CheckStragglers(std::string treeIdSeq);
+  std::string AggregateSeqData(std::string alldata, int missing);
+  void FoldPartial(std::string treeIdSeq);
+  void ExpireDeadline(std::string treeIdSeq);
+  void LateFill(std::string treeIdSeq, std::string child, std::string entry);
 
 
 protected:
@@ -112,9 +138,6 @@ private:
   int m_gotPitNum=0;
   std::string m_selectUpstream;
   std::vector<std::string> m_oneHopNeighbours;
-  int m_sendDisNeiNum=0;
-  int m_gotDisNeiNum=0;
-  std::map<std::string, std::string> m_checkNeibMap;
   std::string m_disNeiPrefix;
   std::string m_disDownStream1;
   std::string m_disDownStream2;
@@ -143,6 +166,7 @@ private:
   std::string m_doubtSeq = "";
   std::map<std::string, std::string> m_computeGroup;
   std::map<std::string, std::string> m_seqInterestName;
+  std::map<std::string, std::map<uint32_t, std::string>> m_batchReply; // batch Interest name -- (seq, folded value)
   std::vector<std::string> m_groupIds;
   int m_countdata = 0;
   std::vector<std::string> m_countSeq;
@@ -177,6 +201,96 @@ private:
   std::string m_interestAsRecoverReducer= "";
   std::string m_preUpNodeName = "";
   bool m_cpFailure=false;
+  std::string m_standbyNode = "";
+  Time m_replicaInterval;
+  EventId m_replicaEvent;
+  std::map<uint32_t, std::string> m_replicaSent; // seq -- seq-data streamed to standby, above the acked watermark
+  std::set<uint32_t> m_replicaDirty; // seqs at or below the acked watermark rewritten since
+  uint32_t m_replicaAcked = 0; // standby holds every seq up to it
+  uint32_t m_repliedSeq = 0; // every seq up to it has been replied upstream
+  std::set<uint32_t> m_repliedAbove; // replied seqs past the first gap above m_repliedSeq
+  uint32_t m_replicaBatch;
+  std::map<std::string, std::map<std::string, std::string>> m_replicaSeqData; //(primary-reducer, (seq, seq-data))
+  std::map<std::string, int> m_replicaWatermark;
+  std::set<std::string> m_restoredSeqs;
+  uint32_t m_cpFullEvery;
+  uint32_t m_cpCount = 0;
+  std::map<uint64_t, int64_t> m_cpSnapshot; //(seq, value) sent with the previous checkpoint
+  WqCheckpointCoordinator m_cpCoordinator; // checkpoints delegated to this reducer by sink
+  std::map<std::string, std::string> m_cpLeadInterest; // cpID -- pending lead Interest from sink
+  std::map<std::string, std::string> m_cpLeadRecords; // cpID -- bundled records of the nodes
+  std::map<std::string, EventId> m_cpLeadTimeouts; // cpID -- expiry of the lead Interest
+  std::string m_mapperReplicas;
+  uint32_t m_stragglerPercentile;
+  uint32_t m_stragglerMinSamples;
+  uint32_t m_stragglerRetries;
+  std::map<std::string, uint32_t> m_stragglerChecks; // tree-seq -- straggler checks that found no data
+  std::map<std::string, std::string> m_mapperReplica; // mapper -- replica mapper of the same sensor region
+  std::map<std::string, std::string> m_jobStragglerMode; // tree-id -- none, replica or partial
+  std::deque<double> m_childLatency; // recent response times of the children (s)
+  std::map<std::string, std::map<std::string, Time>> m_childSentTime; // tree-seq -- (child, task sent)
+  std::map<std::string, std::set<std::string>> m_seqAnswered; // tree-seq -- children whose value is counted
+  std::map<std::string, std::string> m_seqTask; // tree-seq -- task part of its Interest
+  std::map<std::string, int> m_partialSeqs; // tree-seq -- children left out of its aggregate
+  std::map<std::string, Time> m_jobDeadline; // tree-id -- wait for children before a partial reply
+  std::map<std::string, std::string> m_seqParent; // tree-seq -- node its late fill goes to
+  std::set<std::string> m_partialFolded; // tree-seqs replied partial, corrected by late fills
+
+  /**
+   * \struct Per-job state of one tree, swapped in and out of the m_ fields by SwitchJob
+   */
+  struct JobContext {
+    std::string selectNodeName = "";
+    std::string preUpNodeName = "";
+    std::string myPathID;
+    std::string prePathID;
+    std::string joinNeiPathId;
+    std::string jobRefNei = "0";
+    std::string assignTask;
+    std::vector<std::string> nodeList4Task;
+    bool jobNeiChangeFlag = false;
+    std::map<std::string, std::string> nodePathId;
+    std::map<std::string, std::string> neiLocalId;
+    std::map<std::string, std::string> lostNeiIdRecords;
+    std::map<std::string, std::string> receiveNodeandData;
+    std::map<std::string, std::string> processedSeqData;
+    std::map<std::string, std::string> computeGroup;
+    std::vector<std::string> groupIds;
+    int countdata = 0;
+    std::vector<std::string> countSeq;
+    uint32_t cpCount = 0;
+    std::map<uint64_t, int64_t> cpSnapshot;
+    bool upNodeFail = false;
+    std::string interestOfUpfail = "";
+    std::map<std::string, std::string> reportFailNeiList;
+    std::string interestAsRecoverReducer = "";
+    bool cpFailure = false;
+    bool detectLinkFailure = false;
+    std::map<std::string, std::string> detectFailureSeqData;
+    std::map<std::string, std::string> possibleRejoinNeis;
+    int sendRejoinNum = 0;
+    int gotRejoinNum = 0;
+    std::string sendRejoinNode;
+    std::string standbyNode = "";
+    EventId replicaEvent;
+    std::map<uint32_t, std::string> replicaSent;
+    std::set<uint32_t> replicaDirty;
+    uint32_t replicaAcked = 0;
+    uint32_t repliedSeq = 0;
+    std::set<uint32_t> repliedAbove;
+    std::map<std::string, std::map<std::string, std::string>> replicaSeqData;
+    std::map<std::string, int> replicaWatermark;
+    std::set<std::string> restoredSeqs;
+  };
+
+  std::map<std::string, JobContext> m_jobs; // tree-id -- parked state of the jobs not in m_currentTreeFlag
+  uint32_t m_maxJobInflight;
+  Time m_inflightTimeout;
+  std::vector<std::string> m_jobOrder; // round-robin order of the jobs with queued tasks
+  uint64_t m_jobTurn = 0;
+  std::map<std::string, std::deque<std::pair<shared_ptr<const Interest>, Time>>> m_jobQueue; // tree-id -- (task not yet sent to the children, its expiry)
+  std::map<std::string, std::map<std::string, Time>> m_jobInflight; // tree-id -- (tree-seq, dispatch time)
+  EventId m_dispatchEvent;
 };
 
 
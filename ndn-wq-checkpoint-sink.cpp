@@ -18,6 +18,11 @@
  **/
 
 #include "ndn-wq-checkpoint-sink.hpp"
+#include "ndn-wq-checkpoint-codec.hpp"
+#include "ndn-wq-checkpoint-coordinator.hpp"
+#include "ndn-wq-node-registry.hpp"
+#include "ndn-wq-placement.hpp"
+#include "ndn-wq-seq-batch.hpp"
 #include "ns3/ptr.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -52,6 +57,18 @@ WqCheckpointSink::GetTypeId(void)
 
       .AddAttribute("Frequency", "Frequency of interest packets", StringValue("1.0"),
                     MakeDoubleAccessor(&WqCheckpointSink::m_frequency), MakeDoubleChecker<double>())
+      .AddAttribute("IssueMode", "How new seqs are issued: rate (default, Frequency) or window (AIMD on outstanding seqs)",
+                    StringValue("rate"), MakeStringAccessor(&WqCheckpointSink::m_issueMode),
+                    MakeStringChecker())
+      .AddAttribute("InitialWindow", "Outstanding seqs allowed at start in window mode", StringValue("2"),
+                    MakeDoubleAccessor(&WqCheckpointSink::m_initWindow), MakeDoubleChecker<double>(1))
+      .AddAttribute("MinWindow", "Lower bound of the issue window", StringValue("1"),
+                    MakeDoubleAccessor(&WqCheckpointSink::m_minWindow), MakeDoubleChecker<double>(1))
+      .AddAttribute("MaxWindow", "Upper bound of the issue window", StringValue("64"),
+                    MakeDoubleAccessor(&WqCheckpointSink::m_maxWindow), MakeDoubleChecker<double>(1))
+      .AddAttribute("BatchSize", "Contiguous seqs carried by one task Interest, 1 for one Interest per seq",
+                    UintegerValue(1), MakeUintegerAccessor(&WqCheckpointSink::m_batchSize),
+                    MakeUintegerChecker<uint32_t>(1))
 
       .AddAttribute("Randomize",
                     "Type of send time randomization: none (default), uniform, exponential",
@@ -98,14 +115,72 @@ WqCheckpointSink::GetTypeId(void)
 					UintegerValue(0), MakeUintegerAccessor(&WqCheckpointSink::m_signature),
 					MakeUintegerChecker<uint32_t>())
       .AddAttribute("KeyLocator", "Name to be used for key locator.  If root, then key locator is not used",
-                    NameValue(), MakeNameAccessor(&WqCheckpointSink::m_keyLocator), MakeNameChecker()); 
+                    NameValue(), MakeNameAccessor(&WqCheckpointSink::m_keyLocator), MakeNameChecker())
+      .AddAttribute("SpareRetryInterval", "Time between retries to replace a failed reducer that had no spare",
+                    StringValue("2s"), MakeTimeAccessor(&WqCheckpointSink::m_spareRetryInterval),
+                    MakeTimeChecker())
+      .AddAttribute("CatchUpRate", "Task rate (in hertz) a recovered group drains its backlog with",
+                    StringValue("10.0"), MakeDoubleAccessor(&WqCheckpointSink::m_catchUpRate),
+                    MakeDoubleChecker<double>())
+      .AddAttribute("HotStandby", "Keep a warm standby per active reducer and promote it on failure instead of rolling back",
+                    BooleanValue(false), MakeBooleanAccessor(&WqCheckpointSink::m_hotStandby),
+                    MakeBooleanChecker())
+      .AddAttribute("MaxCheckpointEpochs", "Checkpoints allowed to collect replies at the same time",
+                    UintegerValue(4), MakeUintegerAccessor(&WqCheckpointSink::m_maxCpEpochs),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Placement", "How reducers and their mappers are picked: random (default), or cost",
+                    StringValue("random"), MakeStringAccessor(&WqCheckpointSink::m_placement),
+                    MakeStringChecker())
+      .AddAttribute("ReducerNum", "Number of reducers on the job plan",
+                    UintegerValue(5), MakeUintegerAccessor(&WqCheckpointSink::m_reducerNum),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("HopWeight", "Placement weight of mapper-to-reducer hops",
+                    StringValue("1.0"), MakeDoubleAccessor(&WqCheckpointSink::m_hopWeight),
+                    MakeDoubleChecker<double>(0))
+      .AddAttribute("SinkWeight", "Placement weight of reducer-to-sink hops",
+                    StringValue("0.5"), MakeDoubleAccessor(&WqCheckpointSink::m_sinkWeight),
+                    MakeDoubleChecker<double>(0))
+      .AddAttribute("BalanceWeight", "Placement weight of reducer load imbalance",
+                    StringValue("1.0"), MakeDoubleAccessor(&WqCheckpointSink::m_balanceWeight),
+                    MakeDoubleChecker<double>(0))
+      .AddAttribute("MaxFanIn", "Max children per reducer and of sink, 0 for no limit",
+                    UintegerValue(0), MakeUintegerAccessor(&WqCheckpointSink::m_maxFanIn),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("TreeLevels", "Min number of reducer levels between mappers and sink",
+                    UintegerValue(1), MakeUintegerAccessor(&WqCheckpointSink::m_treeLevels),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Rebalance", "Move mappers from slow to fast reducers at checkpoint boundaries",
+                    BooleanValue(false), MakeBooleanAccessor(&WqCheckpointSink::m_rebalance),
+                    MakeBooleanChecker())
+      .AddAttribute("RebalanceRatio", "Group latency ratio (slowest/fastest) that triggers a move",
+                    StringValue("1.5"), MakeDoubleAccessor(&WqCheckpointSink::m_rebalanceRatio),
+                    MakeDoubleChecker<double>(1))
+      .AddAttribute("RebalanceStep", "Max mappers moved per checkpoint boundary",
+                    UintegerValue(2), MakeUintegerAccessor(&WqCheckpointSink::m_rebalanceStep),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("HandoverTimeout", "Time a mapper handover may take before it is rolled back",
+                    StringValue("10s"), MakeTimeAccessor(&WqCheckpointSink::m_handoverTimeout),
+                    MakeTimeChecker())
+      .AddAttribute("CheckpointLeader", "Who collects checkpoint replies: sink (default), or reducer (delegated to a job reducer)",
+                    StringValue("sink"), MakeStringAccessor(&WqCheckpointSink::m_cpLeaderMode),
+                    MakeStringChecker())
+      .AddAttribute("StragglerMode", "Reducers on a slow child: none (default), replica (ask a replica mapper), or partial (reply without it)",
+                    StringValue("none"), MakeStringAccessor(&WqCheckpointSink::m_stragglerMode),
+                    MakeStringChecker())
+      .AddAttribute("Deadline", "Time a reducer waits for its children before replying a partial result, 0 for no deadline",
+                    TimeValue(Seconds(0)), MakeTimeAccessor(&WqCheckpointSink::m_deadline),
+                    MakeTimeChecker())
+      .AddAttribute("PartialPolicy", "Partial results: accept (count the seq, late fills replace the value), or wait (count it at full coverage)",
+                    StringValue("accept"), MakeStringAccessor(&WqCheckpointSink::m_partialPolicy),
+                    MakeStringChecker()); 
 
   return tid;
 }
 
 WqCheckpointSink::WqCheckpointSink()
-  : m_rand(CreateObject<UniformRandomVariable>())
-  , m_firstTime(true)
+  : m_firstTime(true)
+  , m_rand(CreateObject<UniformRandomVariable>())
+  , m_planRand(CreateObject<UniformRandomVariable>())
   , m_seq(0)
   , m_seqMax(0) 
 {
@@ -174,6 +249,18 @@ WqCheckpointSink::CheckRetxTimeout()
   m_retxEvent = Simulator::Schedule(m_retxTimer, &WqCheckpointSink::CheckRetxTimeout, this);
 }
 
+int64_t
+WqCheckpointSink::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  m_planRand->SetStream(stream + 1);
+  if (m_random != 0) {
+    m_random->SetStream(stream + 2);
+    return 3;
+  }
+  return 2;
+}
+
 void
 WqCheckpointSink::StartApplication()
 {
@@ -181,6 +268,18 @@ WqCheckpointSink::StartApplication()
   App::StartApplication();
 
   FibHelper::AddRoute(GetNode(), m_prefix, m_face, 0);
+  m_cpCoordinator.SetMaxEpochs(m_maxCpEpochs);
+  m_issueWindow.SetRttEstimator(m_rtt);
+  m_issueWindow.SetLimits(m_initWindow, m_minWindow, m_maxWindow);
+  if (m_deadline.IsStrictlyPositive()) {
+    m_taskContent += "/dl." + std::to_string(m_deadline.GetMilliSeconds());
+  };
+  if (m_stragglerMode == "replica") {
+    m_taskContent += "/sm.dup";
+  }
+  else if (m_stragglerMode == "partial") {
+    m_taskContent += "/sm.part";
+  };
 
   SendPacket();
 }
@@ -192,6 +291,13 @@ WqCheckpointSink::StopApplication()
 
   // cancel periodic packet generation
   Simulator::Cancel(m_sendEvent);
+  Simulator::Cancel(m_windowEvent);
+  Simulator::Cancel(m_spareRetryEvent);
+  Simulator::Cancel(m_handoverEvent);
+  std::map<std::string, EventId>::iterator cp;
+  for(cp=m_cpTimeouts.begin(); cp!=m_cpTimeouts.end(); cp++) {
+    Simulator::Cancel(cp->second);
+  };
 
   // cleanup base stuff
   App::StopApplication();
@@ -256,27 +362,12 @@ WqCheckpointSink::SendPacket()
   }
   else
   {
-    //start discovery neighbours
-    m_sendDisNeiNum = 0;
-    for(uint8_t i=0; i < m_allNodeName.size(); i++)
+    //start discovery neighbours, one local forwarder query instead of a "/nei-" probe per node
+    m_oneHopNeighbours = GetOneHopNeighbours();
+    std::cout << "next-hop neighbour number: " << m_oneHopNeighbours.size() <<std::endl;
+    if(m_oneHopNeighbours.size() != 0)
     {
-      // std::cout << " m_allNode " << m_allNodeName[i] << std::endl;
-      if(m_allNodeName[i] != m_ownPrefix)
-      {
-        m_checkNeibMap.insert(std::pair<std::string, std::string>(m_allNodeName[i],"0"));
-        // written as: /nei-/user-
-        std::string tempDisNei = m_disNeiPrefix + m_allNodeName[i];
-        shared_ptr<Name> disNeiName = make_shared<Name>(tempDisNei);
-        //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-        shared_ptr<Interest> disNeiInterest = make_shared<Interest>();
-        disNeiInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-        disNeiInterest->setName(*disNeiName);
-        disNeiInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
-        std::cout << " User disNeiInterest " << disNeiInterest->getName().toUri() << std::endl;
-        m_transmittedInterests(disNeiInterest, this, m_face);
-        m_appLink->onReceiveInterest(*disNeiInterest);
-        m_sendDisNeiNum +=1;
-      }
+      Simulator::Schedule(Seconds(0.0), &WqCheckpointSink::SendPacket, this);
     };
   };
 }
@@ -291,6 +382,16 @@ WqCheckpointSink::ScheduleNextPacket()
     m_sendEvent = Simulator::Schedule(Seconds(0.0), &WqCheckpointSink::SendPacket, this);
     m_firstTime = false;
   }
+  else if (m_issueMode == "window") {
+    if (m_sendEvent.IsRunning())
+      return;
+    m_issueWindow.ExpireTimeouts();
+    // open window: next seq after one pacing gap, closed: a completion or the timeout reopens it
+    if (m_issueWindow.CanIssue())
+      m_sendEvent = Simulator::Schedule(m_issueWindow.GetPacing(), &WqCheckpointSink::SendPacket, this);
+    else if (!m_windowEvent.IsRunning())
+      m_windowEvent = Simulator::Schedule(m_rtt->RetransmitTimeout(), &WqCheckpointSink::ScheduleNextPacket, this);
+  }
   else if (!m_sendEvent.IsRunning())
     m_sendEvent = Simulator::Schedule((m_random == 0) ? Seconds(1.0 / m_frequency)
                                                       : Seconds(m_random->GetValue()),
@@ -326,6 +427,22 @@ WqCheckpointSink::GetRandomize() const
 void
 WqCheckpointSink::GetAllComputeNodes()
 {
+  // same topology as the last job: reuse its census, the /cpCost round of PlanJob still
+  // has to reach every cached reducer before the plan runs
+  m_censusCache.SetPath(m_treeCacheDir, m_ownPrefix, "/cpCom-");
+  if(m_censusCache.Load(GetTopologyFingerprint(m_ownPrefix))) {
+    m_mappers = WqTreeCache::SplitNames(m_censusCache.Get("mappers"));
+    m_existReducers = WqTreeCache::SplitNames(m_censusCache.Get("reducers"));
+    if(m_mappers.size() != 0 && m_existReducers.size() != 0) {
+      std::cout << "Sink warm census, ComputeNodes Num=: " << m_existReducers.size()
+                << " Mapper Num=: " << m_mappers.size() << std::endl;
+      PlanJob();
+      return;
+    };
+    m_mappers.clear();
+    m_existReducers.clear();
+  };
+
   if(m_allNodeName.size() < 20) {
     for(uint64_t i=0; i < m_allNodeName.size(); i++) {
     // std::cout << " m_allNode " << m_allNodeName[i] << std::endl;
@@ -346,97 +463,159 @@ WqCheckpointSink::GetAllComputeNodes()
     };
   }
   else {
-    //for BRITE-topo
-    for(int i =31; i< 99; i++) {
-      std::string prefix = "/" + std::to_string(i) + "-";
-      m_mappers.push_back(prefix);
-    };
-    for(int r =1; r< 31; r++) {
-      std::string prefix = "/" + std::to_string(r) + "-";
-      m_existReducers.push_back(prefix);
-    };
-    RunJobPlan();
+    // large topologies (BRITE): roles come from the node registry instead of one probe per node
+    m_mappers = WqNodeRegistry::Get().GetByRole("mapper");
+    m_existReducers = WqNodeRegistry::Get().GetByRole("reducer");
+    PlanJob();
   }
   
 }
 
 void
-WqCheckpointSink::RunJobPlan()
+WqCheckpointSink::PlanJob()
 {
+  if(m_placement != "cost") {
+    RunJobPlan();
+    return;
+  };
+  // every compute node reports its FIB cost to all mappers and to sink
+  std::string nodes = "";
+  for(uint64_t m=0; m<m_mappers.size(); m++) {
+    nodes += m_mappers[m];
+  };
+  nodes += m_ownPrefix;
+  m_hopCost.clear();
+  m_txCostNum = 0;
+  std::string costName = "";
+  for(uint64_t r=0; r<m_existReducers.size(); r++) {
+    costName = m_existReducers[r] + "/cpCost<" + nodes + ">-";
+    SendOutInterest(costName);
+    m_txCostNum++;
+  };
+  // nodes that do not answer within the Interest lifetime are left out
+  m_planEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(costName).count()), &WqCheckpointSink::RunJobPlan, this);
+}
+
+bool
+WqCheckpointSink::PlaceByCost(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers)
+{
+  std::vector<std::string> candidates;
+  std::vector<std::vector<uint32_t>> hops;
+  std::vector<uint32_t> sinkHops;
+  std::map<std::string, std::vector<uint32_t>>::iterator it;
+  for(it=m_hopCost.begin(); it!=m_hopCost.end(); it++) {
+    // "c1,c2,...,cSink" in the order of m_mappers, sink last
+    if(it->second.size() != m_mappers.size() + 1) {
+      continue;
+    };
+    candidates.push_back(it->first);
+    hops.push_back(std::vector<uint32_t>(it->second.begin(), it->second.end()-1));
+    sinkHops.push_back(it->second.back());
+  };
+  if(candidates.size() == 0 || m_mappers.size() == 0) {
+    return false;
+  };
+
+  WqPlacement placement(m_hopWeight, m_sinkWeight, m_balanceWeight);
+  std::vector<uint32_t> assign;
+  std::vector<uint32_t> open = placement.Solve(hops, sinkHops, m_reducerNum, assign);
+  std::map<uint32_t, std::string> groups;
+  for(uint64_t m=0; m<assign.size(); m++) {
+    groups[assign[m]] += m_mappers[m];
+  };
+  // a reducer left without mappers stays off the job plan
+  for(uint64_t o=0; o<open.size(); o++) {
+    if(groups.find(open[o]) != groups.end()) {
+      pick_reducers.push_back(candidates[open[o]]);
+      group_mappers.push_back(groups[open[o]]);
+    };
+  };
+  std::cout << "Placement by cost, Reducer Num= " << pick_reducers.size() << " objective= " << placement.GetObjective() << std::endl;
+  return true;
+}
+
+void
+WqCheckpointSink::PlaceRandom(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers)
+{
+  // every picked reducer gets at least one mapper
+  uint64_t reducerNum = std::min<uint64_t>(m_reducerNum, std::min(m_existReducers.size(), m_mappers.size()));
+  if(reducerNum == 0) {
+    std::cout << "Placement random, no reducer or mapper to place" << std::endl;
+    return;
+  };
   std::vector<int> pick_index;
   std::vector<int>::iterator it_pick;
   int max = m_existReducers.size();
-  while(pick_index.size() != 5) {
-    int random = rand() % max;
+  while(pick_index.size() != reducerNum) {
+    int random = m_planRand->GetInteger(0, max - 1);
     it_pick = find(pick_index.begin(), pick_index.end(), random);
     if(it_pick == pick_index.end()) {
       pick_index.push_back(random);
       // std::cout << "pick_index= " <<  random << std::endl;
     };
   };
-
-  std::vector<std::string> pick_reducers;
-  std::vector<std::string>::iterator it_r;
   for(uint64_t p=0; p<pick_index.size(); p++) {
-    int r_index = pick_index[p];
-    if(pick_reducers.size() == 0) {
-      pick_reducers.push_back(m_existReducers[r_index]);
-    }
-    else {
-      it_r = find(pick_reducers.begin(), pick_reducers.end(), m_existReducers[r_index]);
-      if(it_r == pick_reducers.end()) {
-        pick_reducers.push_back(m_existReducers[r_index]);
-      }
-      else {
-        std::cout << "pick_Duplicated Reducers"<< std::endl;
-      };
-    };
-    // std::cout << "pick_Reducers= Node-" << m_existReducers[r_index] << std::endl;
+    pick_reducers.push_back(m_existReducers[pick_index[p]]);
+    // std::cout << "pick_Reducers= Node-" << m_existReducers[pick_index[p]] << std::endl;
   };
 
-  // all nodes on the job plan
-  m_nodes4CP = m_mappers;
-  m_nodes4CP.insert(m_nodes4CP.end(), pick_reducers.begin(), pick_reducers.end());
-
-  std::vector<int> group_num;
-  std::vector<int>::iterator it_group;
-  int random1;
-  while(group_num.size() != 4) {
-    random1 = 5 + rand() % 15;
-    group_num.push_back(random1);
-    // std::cout << "random1= " << random1 << std::endl;
-  };
-  int sum = 0;
-  for(it_group=group_num.begin(); it_group!=group_num.end(); ++it_group) {
-    sum += *it_group;
-  };
-  // std::cout << "sum= " << sum << std::endl;
-  if(sum < m_mappers.size()) {
-    int m = m_mappers.size() - sum;
-    group_num.push_back(m);
-    // std::cout << "add-new-m= " << m << std::endl;
+  // random group sizes: reducerNum-1 distinct cut points split the mapper list
+  std::vector<int> cuts;
+  int mapperNum = m_mappers.size();
+  while(cuts.size() != reducerNum - 1) {
+    int random1 = m_planRand->GetInteger(1, mapperNum - 1);
+    if(find(cuts.begin(), cuts.end(), random1) == cuts.end()) {
+      cuts.push_back(random1);
+    };
   };
+  std::sort(cuts.begin(), cuts.end());
+  cuts.push_back(mapperNum);
 
-  std::vector<std::string> v2_mappers;
-  std::vector<std::string> group_mappers;
-  v2_mappers.assign(m_mappers.begin(), m_mappers.end());
-  for(uint64_t i=0; i<group_num.size(); i++) {
-    uint64_t l = group_num[i];
+  int first = 0;
+  for(uint64_t i=0; i<cuts.size(); i++) {
     std::string sub_mappers="";
-    for(uint64_t j=0; j<l; j++) {
-      sub_mappers += v2_mappers[j];
+    for(int j=first; j<cuts[i]; j++) {
+      sub_mappers += m_mappers[j];
     };
     group_mappers.push_back(sub_mappers);
-    // std::cout << "group-len= " << l << " sub_mappers= " << sub_mappers << std::endl;
-    v2_mappers.erase(v2_mappers.begin(), v2_mappers.begin()+l);
+    // std::cout << "group-len= " << cuts[i]-first << " sub_mappers= " << sub_mappers << std::endl;
+    first = cuts[i];
+  };
+  std::cout << "Placement random, Reducer Num= " << pick_reducers.size() << std::endl;
+}
+
+void
+WqCheckpointSink::RunJobPlan()
+{
+  Simulator::Cancel(m_planEvent);
+  if(m_groupNode.size() != 0) {
+    return;
+  };
+  std::vector<std::string> pick_reducers;
+  std::vector<std::string> group_mappers;
+  if(m_placement != "cost" || !PlaceByCost(pick_reducers, group_mappers)) {
+    PlaceRandom(pick_reducers, group_mappers);
   };
 
-  if(pick_reducers.size() == group_mappers.size()) {
+  if(pick_reducers.size() != 0 && pick_reducers.size() == group_mappers.size()) {
+    // reducers below the top level are told their children first
+    BuildReductionTree(pick_reducers, group_mappers);
+
+    // all nodes on the job plan
+    m_nodes4CP = m_mappers;
+    m_nodes4CP.insert(m_nodes4CP.end(), pick_reducers.begin(), pick_reducers.end());
+    m_nodes4CP.insert(m_nodes4CP.end(), m_innerReducers.begin(), m_innerReducers.end());
+
     for(uint64_t i=0; i<pick_reducers.size(); i++) {
       std::cout << "Reducer= " << pick_reducers[i] << " Mapper=" << group_mappers[i] << std::endl;
       m_groupNode.insert(std::pair<std::string, std::string>(pick_reducers[i], group_mappers[i]));
     };
-    AssignJobs();
+    if(m_hotStandby) {
+      AssignStandbys();
+    };
+    if(m_planAcks == 0) {
+      AssignJobs();
+    };
   }
   else {
     std::cout << "Reducer num != Mapper num" << std::endl;
@@ -444,80 +623,733 @@ WqCheckpointSink::RunJobPlan()
 
 }
 
+std::string
+WqCheckpointSink::PickPlanReducer(std::vector<std::string>& spareReducers, std::vector<std::string> children)
+{
+  // closest spare to the children when they are mappers, else closest to sink
+  uint64_t best = 0;
+  uint64_t bestCost = std::numeric_limits<uint64_t>::max();
+  for(uint64_t r=0; r<spareReducers.size(); r++) {
+    std::map<std::string, std::vector<uint32_t>>::iterator cost = m_hopCost.find(spareReducers[r]);
+    if(cost == m_hopCost.end() || cost->second.size() != m_mappers.size() + 1) {
+      continue;
+    };
+    uint64_t sum = 0;
+    for(uint64_t c=0; c<children.size(); c++) {
+      std::vector<std::string>::iterator idx = std::find(m_mappers.begin(), m_mappers.end(), children[c]);
+      sum += (idx != m_mappers.end()) ? cost->second[idx - m_mappers.begin()] : cost->second.back();
+    };
+    if(sum < bestCost) {
+      bestCost = sum;
+      best = r;
+    };
+  };
+  std::string pick = spareReducers[best];
+  spareReducers.erase(spareReducers.begin()+best);
+  return pick;
+}
+
+void
+WqCheckpointSink::BuildReductionTree(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers)
+{
+  std::vector<std::string> spareReducers;
+  for(uint64_t r=0; r<m_existReducers.size(); r++) {
+    if(std::find(pick_reducers.begin(), pick_reducers.end(), m_existReducers[r]) == pick_reducers.end()) {
+      spareReducers.push_back(m_existReducers[r]);
+    };
+  };
+  uint32_t fanIn = (m_maxFanIn == 0) ? std::numeric_limits<uint32_t>::max() : std::max<uint32_t>(m_maxFanIn, 2);
+
+  // leaf level: a reducer with too many mappers hands the extra ones to spare reducers
+  std::vector<std::string> level;
+  std::map<std::string, std::vector<std::string>> children; // reducer -- its children
+  for(uint64_t i=0; i<pick_reducers.size(); i++) {
+    std::vector<std::string> mappers = SplitNodeList(group_mappers[i]);
+    std::string reducer = pick_reducers[i];
+    for(uint64_t m=0; m<mappers.size(); m+=fanIn) {
+      if(m != 0) {
+        if(spareReducers.size() == 0) {
+          std::cout << "No spare reducer for fan-in, " << reducer << " keeps " << mappers.size() - m << " more" << std::endl;
+          children[reducer].insert(children[reducer].end(), mappers.begin()+m, mappers.end());
+          break;
+        };
+        reducer = PickPlanReducer(spareReducers, std::vector<std::string>(mappers.begin()+m, mappers.begin()+std::min<uint64_t>(m+fanIn, mappers.size())));
+      };
+      children[reducer].assign(mappers.begin()+m, mappers.begin()+std::min<uint64_t>(m+fanIn, mappers.size()));
+      level.push_back(reducer);
+    };
+  };
+
+  // upper levels: intermediate reducers until sink fan-in and the level count are met
+  uint32_t levels = 1;
+  while((level.size() > fanIn || levels < m_treeLevels) && level.size() > 1 && spareReducers.size() != 0) {
+    std::vector<std::string> upper;
+    // with the fan-in already met, an extra level asked for splits the level in two
+    uint64_t chunk = (level.size() > fanIn) ? fanIn : std::max<uint64_t>(2, (level.size()+1)/2);
+    uint64_t n = 0;
+    for(; n<level.size() && spareReducers.size() != 0; n+=chunk) {
+      std::vector<std::string> group(level.begin()+n, level.begin()+std::min<uint64_t>(n+chunk, level.size()));
+      std::string parent = PickPlanReducer(spareReducers, group);
+      children[parent] = group;
+      upper.push_back(parent);
+    };
+    // out of spare reducers half way, the rest stays one level lower
+    for(; n<level.size(); n++) {
+      upper.push_back(level[n]);
+    };
+    level = upper;
+    levels++;
+  };
+
+  // top level answers to sink, every reducer below is addressed by path id
+  pick_reducers.clear();
+  group_mappers.clear();
+  m_innerReducers.clear();
+  m_planParent.clear();
+  m_planChildren.clear();
+  m_planAcks = 0;
+  std::deque<std::pair<std::string, std::string>> walk; // reducer -- path id
+  for(uint64_t t=0; t<level.size(); t++) {
+    std::string groupString = "";
+    for(uint64_t c=0; c<children[level[t]].size(); c++) {
+      groupString += children[level[t]][c];
+    };
+    pick_reducers.push_back(level[t]);
+    group_mappers.push_back(groupString);
+    walk.push_back(std::make_pair(level[t], std::to_string(t)));
+  };
+  while(walk.size() != 0) {
+    std::string reducer = walk.front().first;
+    std::string pathId = walk.front().second;
+    walk.pop_front();
+    m_nodePathId[reducer] = pathId;
+    std::string groupString = "";
+    for(uint64_t c=0; c<children[reducer].size(); c++) {
+      std::string child = children[reducer][c];
+      groupString += child;
+      if(children.find(child) != children.end()) {
+        walk.push_back(std::make_pair(child, pathId + "-" + std::to_string(c)));
+        m_planParent[child] = reducer;
+      };
+    };
+    if(std::find(pick_reducers.begin(), pick_reducers.end(), reducer) == pick_reducers.end()) {
+      m_innerReducers.push_back(reducer);
+      m_planChildren[reducer] = groupString;
+      std::string plan = reducer + "/plan<" + groupString + ">(" + pathId + ")" + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
+      std::cout << "Plan inner reducer: " << plan << std::endl;
+      SendOutInterest(plan);
+      m_planAcks++;
+    };
+  };
+  std::cout << "Reduction tree levels= " << levels << " top Num= " << pick_reducers.size() << " inner Num= " << m_innerReducers.size() << std::endl;
+}
+
+std::vector<std::string>
+WqCheckpointSink::GetSpareReducers()
+{
+  // spare reducers: compute nodes neither working on the job, standing by, nor failed before
+  std::vector<std::string> spareReducers;
+  std::map<std::string, std::string>::iterator it_s;
+  for(uint64_t r=0; r<m_existReducers.size(); r++) {
+    std::string candidate = m_existReducers[r];
+    bool standby = false;
+    for(it_s=m_standbyNode.begin(); it_s!=m_standbyNode.end(); it_s++) {
+      if(it_s->second == candidate) {
+        standby = true;
+      };
+    };
+    if(!standby && m_groupNode.find(candidate) == m_groupNode.end() &&
+       std::find(m_innerReducers.begin(), m_innerReducers.end(), candidate) == m_innerReducers.end() &&
+       std::find(m_preFailReducer.begin(), m_preFailReducer.end(), candidate) == m_preFailReducer.end()) {
+      spareReducers.push_back(candidate);
+    };
+  };
+  return spareReducers;
+}
+
+void
+WqCheckpointSink::AssignStandbys()
+{
+  std::vector<std::string> spareReducers = GetSpareReducers();
+  std::map<std::string, std::string>::iterator it;
+  for(it=m_groupNode.begin(); it!=m_groupNode.end(); it++) {
+    if(m_standbyNode.find(it->first) != m_standbyNode.end()) {
+      continue;
+    };
+    if(spareReducers.size() == 0) {
+      std::cout << " No spare reducer left as standby for: " << it->first << std::endl;
+      break;
+    };
+    int random = m_planRand->GetInteger(0, spareReducers.size() - 1);
+    std::string standby = spareReducers[random];
+    spareReducers.erase(spareReducers.begin()+random);
+    m_standbyNode.insert(std::pair<std::string, std::string>(it->first, standby));
+    // the active reducer streams its committed seq-data to the standby from now on
+    std::string tellStandby = it->first + "/standby(" + standby + ")-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
+    std::cout << "Tell-Standby: " << tellStandby << std::endl;
+    SendOutInterest(tellStandby);
+  };
+}
+
 void 
-WqCheckpointSink::PickRecoverReducer()
+WqCheckpointSink::PickRecoverReducer(std::string cpID)
 {
   // std::cout << " Here: -------" <<std::endl;
-  m_reScheduleJob = true;
-  
-  std::map<std::string, std::string>::iterator it = m_cpFailMsg.find(m_failSeq);
-  uint64_t q = it->second.find(";");
-  if(q != std::string::npos) {
-    //multiple-nodes fail
-    std::cout << " -------Fail-Nodes: " << it->second <<std::endl;
+  // one or several reducers may have failed in the same checkpoint
+  std::vector<std::string> failNodes = m_cpCoordinator.GetFailNodes(cpID);
+  std::vector<std::string> failReducers;
+  std::vector<std::string> failInner;
+  for(uint64_t f=0; f<failNodes.size(); f++) {
+    std::cout << " -------Fail-Node: " << failNodes[f] << " in Checkpoint-ID= " << cpID <<std::endl;
+    // only reducers on the job plan own a group of mappers to hand over, a node
+    // replaced in an earlier checkpoint is no longer on it, a pending one waits for a spare
+    if(std::find(m_unreplacedReducers.begin(), m_unreplacedReducers.end(), failNodes[f]) != m_unreplacedReducers.end()) {
+      continue;
+    };
+    if(m_groupNode.find(failNodes[f]) != m_groupNode.end()) {
+      failReducers.push_back(failNodes[f]);
+    }
+    else if(std::find(m_innerReducers.begin(), m_innerReducers.end(), failNodes[f]) != m_innerReducers.end()) {
+      failInner.push_back(failNodes[f]);
+    };
+  };
+
+  // a failed reducer with a healthy warm standby is promoted, the others need a cold spare
+  std::map<std::string, std::string> promoteStandby;
+  std::map<std::string, std::string>::iterator it_s;
+  for(uint64_t f=0; f<failReducers.size(); f++) {
+    it_s = m_standbyNode.find(failReducers[f]);
+    if(it_s != m_standbyNode.end()) {
+      if(std::find(failReducers.begin(), failReducers.end(), it_s->second) == failReducers.end() &&
+         std::find(m_preFailReducer.begin(), m_preFailReducer.end(), it_s->second) == m_preFailReducer.end()) {
+        promoteStandby.insert(std::pair<std::string, std::string>(failReducers[f], it_s->second));
+      };
+      m_standbyNode.erase(it_s);
+    };
+  };
+  std::vector<std::string> spareReducers = GetSpareReducers();
+  for(uint64_t f=0; f<failReducers.size(); f++) {
+    std::vector<std::string>::iterator it_f = std::find(spareReducers.begin(), spareReducers.end(), failReducers[f]);
+    if(it_f != spareReducers.end()) {
+      spareReducers.erase(it_f);
+    };
+  };
+
+  // pick all replacements at once, a picked node leaves the spare pool so no two groups share it;
+  // groups left without a spare stay paused and are replaced once a reducer becomes spare
+  std::vector<std::string> replacements;
+  std::vector<std::string> unreplaced;
+  // inner reducers first, so a top-level replacement gets the child list with their replacements
+  for(uint64_t f=0; f<failInner.size(); f++) {
+    if(spareReducers.size() == 0) {
+      std::cout << " No spare reducer for inner Fail-Node: " << failInner[f] << ", kept pending" << std::endl;
+      m_unreplacedReducers.push_back(failInner[f]);
+      m_pausedGroups.insert(TopReducerOf(failInner[f]));
+      unreplaced.push_back(failInner[f]);
+      continue;
+    };
+    replacements.push_back(ReplaceInnerReducer(failInner[f], spareReducers));
+  };
+  for(uint64_t f=0; f<failReducers.size(); f++) {
+    std::string oneFailReducer = failReducers[f];
+    std::string standby = "";
+    it_s = promoteStandby.find(oneFailReducer);
+    if(it_s != promoteStandby.end()) {
+      standby = it_s->second;
+    }
+    else if(spareReducers.size() == 0) {
+      std::cout << " No spare reducer for Fail-Node: " << oneFailReducer << ", kept pending" << std::endl;
+      m_unreplacedReducers.push_back(oneFailReducer);
+      m_pausedGroups.insert(oneFailReducer);
+      unreplaced.push_back(oneFailReducer);
+      continue;
+    };
+    replacements.push_back(ReplaceFailedReducer(oneFailReducer, standby, spareReducers));
+  };
+
+  UpdateCheckpointNodes();
+  m_cpCoordinator.Recover(cpID, replacements, unreplaced);
+  if(unreplaced.size() != 0 && !m_spareRetryEvent.IsRunning()) {
+    m_spareRetryEvent = Simulator::Schedule(m_spareRetryInterval, &WqCheckpointSink::RetryUnreplaced, this);
+  };
+  if(replacements.size() == 0 && unreplaced.size() == 0) {
+    std::cout << "Checkpoint-ID= " << cpID << " failed nodes already replaced" << std::endl;
+  };
+
+  /* for (auto& x: m_sendJobNeis) {
+    std::cout << "pick_reducers: " << x << '\n';
+  };
+  for (auto& x: m_groupNode) {
+    std::cout << "R= " << x.first << " M= " << x.second << '\n';
+  }; */
+};
+
+std::string
+WqCheckpointSink::ReplaceFailedReducer(std::string oneFailReducer, std::string standby,
+                                       std::vector<std::string>& spareReducers)
+{
+  if(m_handoverPhase != "" && (oneFailReducer == m_handoverFrom || oneFailReducer == m_handoverTo)) {
+    // the replacement takes over the group as it was before the handover
+    AbortHandover();
+  };
+  std::map<std::string, std::string>::iterator it = m_groupNode.find(oneFailReducer);
+  std::string work_mappers = it->second;
+  m_groupNode.erase(it);
+
+  std::string pickNode;
+  std::string tellPickNode;
+  if(standby != "") {
+    pickNode = standby;
+    std::cout << " promote Standby-Node: " << pickNode << " for Fail-Node: " << oneFailReducer <<std::endl;
+    tellPickNode = pickNode + "/promote<" + work_mappers + ">(" + oneFailReducer + ")" + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
+    m_promoteFrom[pickNode] = oneFailReducer;
   }
   else {
-    std::string oneFailReducer = it->second;
-    int max = m_existReducers.size();
-    int random = rand() % max;
-    std::string pickNode = m_existReducers[random];
-
-    it = m_groupNode.find(pickNode);
-    std::vector<std::string>::iterator it_pre = std::find(m_preFailReducer.begin(), m_preFailReducer.end(), pickNode);
-    while(pickNode == oneFailReducer || it!=m_groupNode.end() || it_pre!=m_preFailReducer.end()) {
-      random = rand() % max;
-      pickNode = m_existReducers[random];
-      it = m_groupNode.find(pickNode);
-    };
-    std::cout << " pick Recover-Node: " << pickNode <<std::endl;
-
-    it=m_groupNode.find(oneFailReducer);
-    std::string work_mappers = it->second;
-    m_groupNode.erase(it);
-    m_groupNode.insert(std::pair<std::string, std::string>(pickNode, work_mappers));
-    std::string tellPickNode = pickNode + "/recover<" + work_mappers + ">" + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
-    std::cout << "Tell-NewPickReducer: " << tellPickNode << std::endl;
-    SendOutInterest(tellPickNode);
-
-    std::vector<std::string> temp;
-    temp.push_back(pickNode);
-    for(uint64_t n=0; n<m_sendJobNeis.size(); n++) {
-      if(m_sendJobNeis[n] != oneFailReducer){
-        temp.push_back(m_sendJobNeis[n]);
+    int random = m_planRand->GetInteger(0, spareReducers.size() - 1);
+    pickNode = spareReducers[random];
+    spareReducers.erase(spareReducers.begin()+random);
+    std::cout << " pick Recover-Node: " << pickNode << " for Fail-Node: " << oneFailReducer <<std::endl;
+    // the cold replacement starts from the state of the last checkpoint chain of the failed reducer
+    std::string cpState = "";
+    std::map<uint64_t, int64_t> state = RebuildCheckpointState(oneFailReducer);
+    if(state.size() != 0) {
+      cpState = "/st<" + WqCheckpointCodec::ToHex(WqCheckpointCodec::EncodeRecord(true, state, std::vector<uint64_t>())) + ">";
+      std::cout << " restore Checkpoint-State for " << pickNode << " entries= " << state.size() << std::endl;
+    };
+    tellPickNode = pickNode + "/recover<" + work_mappers + ">" + cpState + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
+  };
+  m_groupNode.insert(std::pair<std::string, std::string>(pickNode, work_mappers));
+
+  // only this group is paused: the seqs the sink never got from it are buffered for the
+  // replacement, later seqs queue behind them until the replacement has taken over
+  std::set<std::string> rxSeqs = m_groupRxSeqs[oneFailReducer];
+  m_groupRxSeqs.erase(oneFailReducer);
+  m_cpChain.erase(oneFailReducer);
+  m_groupLatency.erase(oneFailReducer);
+  m_groupRxSeqs[pickNode] = rxSeqs;
+  m_groupBacklog.erase(oneFailReducer);
+  m_pausedGroups.erase(oneFailReducer);
+  m_pausedGroups.insert(pickNode);
+  std::deque<std::string> backlog;
+  for(int n=1; n<=m_seqNum; n++) {
+    std::string seqFlag = "Seq" + std::to_string(n);
+    if(rxSeqs.find(seqFlag) == rxSeqs.end()) {
+      backlog.push_back(seqFlag);
+    };
+  };
+  m_groupBacklog[pickNode] = backlog;
+  std::cout << "Buffer Seqs for " << pickNode << " Num= " << backlog.size() << std::endl;
+  std::cout << "Tell-NewPickReducer: " << tellPickNode << std::endl;
+  SendOutInterest(tellPickNode);
+
+  for(uint64_t n=0; n<m_sendJobNeis.size(); n++) {
+    if(m_sendJobNeis[n] == oneFailReducer){
+      m_sendJobNeis[n] = pickNode;
+    };
+  };
+  std::map<std::string, std::string>::iterator parent;
+  for(parent=m_planParent.begin(); parent!=m_planParent.end(); parent++) {
+    if(parent->second == oneFailReducer) {
+      parent->second = pickNode;
+    };
+  };
+  return pickNode;
+}
+
+std::string
+WqCheckpointSink::TopReducerOf(std::string reducer)
+{
+  std::map<std::string, std::string>::iterator parent = m_planParent.find(reducer);
+  while(parent != m_planParent.end()) {
+    reducer = parent->second;
+    parent = m_planParent.find(reducer);
+  };
+  return reducer;
+}
+
+std::string
+WqCheckpointSink::ReplaceInnerReducer(std::string oneFailReducer, std::vector<std::string>& spareReducers)
+{
+  int random = m_planRand->GetInteger(0, spareReducers.size() - 1);
+  std::string pickNode = spareReducers[random];
+  spareReducers.erase(spareReducers.begin()+random);
+  std::string parent = m_planParent[oneFailReducer];
+  std::string children = m_planChildren[oneFailReducer];
+  std::string pathId = m_nodePathId[oneFailReducer];
+  std::cout << " pick Recover-Node: " << pickNode << " for inner Fail-Node: " << oneFailReducer << " parent= " << parent << std::endl;
+
+  // the replacement takes the place of the failed node in the tree, with the same path id
+  *std::find(m_innerReducers.begin(), m_innerReducers.end(), oneFailReducer) = pickNode;
+  m_nodePathId[pickNode] = pathId;
+  m_nodePathId.erase(oneFailReducer);
+  m_planChildren[pickNode] = children;
+  m_planChildren.erase(oneFailReducer);
+  m_planParent[pickNode] = parent;
+  m_planParent.erase(oneFailReducer);
+  std::map<std::string, std::string>::iterator it;
+  for(it=m_planParent.begin(); it!=m_planParent.end(); it++) {
+    if(it->second == oneFailReducer) {
+      it->second = pickNode;
+    };
+  };
+  std::map<std::string, std::string>::iterator group = m_groupNode.find(parent);
+  std::string& siblings = (group != m_groupNode.end()) ? group->second : m_planChildren[parent];
+  uint64_t f = siblings.find(oneFailReducer);
+  if(f != std::string::npos) {
+    siblings.replace(f, oneFailReducer.size(), pickNode);
+  };
+
+  // "/tree-" acks are not counted as a mapper handover
+  SendOutInterest(pickNode + "/plan<" + children + ">(" + pathId + ")" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  SendOutInterest(parent + "/release<" + oneFailReducer + ">/tree-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  SendOutInterest(parent + "/adopt<" + pickNode + ">/tree-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  std::vector<std::string> childList = SplitNodeList(children);
+  for(uint64_t c=0; c<childList.size(); c++) {
+    SendOutInterest(childList[c] + "/newUp(" + pickNode + ")-/tree-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  };
+  m_replanInner.insert(pickNode);
+  // the group above lost the seqs in flight through the failed node, it waits for the replacement
+  m_pausedGroups.insert(TopReducerOf(pickNode));
+  return pickNode;
+}
+
+void
+WqCheckpointSink::RollbackSubtree(std::string top)
+{
+  // every reducer of the subtree forgets its seqs in flight, the sink issues them again
+  std::vector<std::string> nodes;
+  nodes.push_back(top);
+  for(uint64_t i=0; i<m_innerReducers.size(); i++) {
+    if(TopReducerOf(m_innerReducers[i]) == top) {
+      nodes.push_back(m_innerReducers[i]);
+    };
+  };
+  std::set<std::string>& rxSeqs = m_groupRxSeqs[top];
+  std::deque<std::string> backlog;
+  for(int n=1; n<=m_seqNum; n++) {
+    std::string seqFlag = "Seq" + std::to_string(n);
+    if(rxSeqs.find(seqFlag) == rxSeqs.end()) {
+      backlog.push_back(seqFlag);
+    };
+  };
+  m_groupBacklog[top] = backlog;
+  std::cout << "Rollback subtree of " << top << " Num= " << nodes.size() << " buffer Seqs Num= " << backlog.size() << std::endl;
+  m_subtreeRollbacks[top] = nodes.size();
+  for(uint64_t n=0; n<nodes.size(); n++) {
+    m_rollbackTop[nodes[n]] = top;
+    SendOutInterest(nodes[n] + "/rollback-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  };
+}
+
+void
+WqCheckpointSink::RetryUnreplaced()
+{
+  Simulator::Cancel(m_spareRetryEvent);
+  if(m_unreplacedReducers.size() == 0) {
+    return;
+  };
+  std::vector<std::string> spareReducers = GetSpareReducers();
+  while(m_unreplacedReducers.size() != 0 && spareReducers.size() != 0) {
+    std::string oneFailReducer = m_unreplacedReducers.front();
+    m_unreplacedReducers.erase(m_unreplacedReducers.begin());
+    std::string pickNode;
+    if(std::find(m_innerReducers.begin(), m_innerReducers.end(), oneFailReducer) != m_innerReducers.end()) {
+      pickNode = ReplaceInnerReducer(oneFailReducer, spareReducers);
+    }
+    else {
+      pickNode = ReplaceFailedReducer(oneFailReducer, "", spareReducers);
+    };
+    m_cpCoordinator.Replaced(oneFailReducer, pickNode);
+  };
+  UpdateCheckpointNodes();
+  if(m_unreplacedReducers.size() != 0) {
+    std::cout << " Still no spare reducer, pending Num= " << m_unreplacedReducers.size() << std::endl;
+    m_spareRetryEvent = Simulator::Schedule(m_spareRetryInterval, &WqCheckpointSink::RetryUnreplaced, this);
+  };
+}
+
+void
+WqCheckpointSink::UpdateCheckpointNodes()
+{
+  // a failed reducer waiting for a spare would fail every checkpoint, it joins none
+  m_nodes4CP.clear();
+  m_nodes4CP = m_mappers;
+  for(uint64_t n=0; n<m_sendJobNeis.size(); n++) {
+    if(std::find(m_unreplacedReducers.begin(), m_unreplacedReducers.end(), m_sendJobNeis[n]) == m_unreplacedReducers.end()) {
+      m_nodes4CP.push_back(m_sendJobNeis[n]);
+    };
+  };
+  for(uint64_t n=0; n<m_innerReducers.size(); n++) {
+    if(std::find(m_unreplacedReducers.begin(), m_unreplacedReducers.end(), m_innerReducers[n]) == m_unreplacedReducers.end()) {
+      m_nodes4CP.push_back(m_innerReducers[n]);
+    };
+  };
+}
+
+void
+WqCheckpointSink::CompleteRecovery(std::string cpID)
+{
+  std::cout << "----- Recover Finish, all replacement reducers joined for Checkpoint-ID= " << cpID << std::endl;
+  m_promoteFrom.clear();
+  if(m_hotStandby) {
+    AssignStandbys();
+  };
+}
+
+void
+WqCheckpointSink::ResumeGroup(std::string reducer)
+{
+  std::cout << "Resume group of " << reducer << " backlog= " << m_groupBacklog[reducer].size() << std::endl;
+  m_pausedGroups.erase(reducer);
+  Simulator::Cancel(m_drainEvent[reducer]);
+  DrainGroupBacklog(reducer);
+}
+
+void
+WqCheckpointSink::DrainGroupBacklog(std::string reducer)
+{
+  if(m_pausedGroups.find(reducer) != m_pausedGroups.end()) {
+    return;
+  };
+  std::map<std::string, std::deque<std::string>>::iterator it = m_groupBacklog.find(reducer);
+  if(it == m_groupBacklog.end() || it->second.size() == 0) {
+    return;
+  };
+  SendTaskInterest(reducer, it->second.front());
+  it->second.pop_front();
+  if(it->second.size() != 0) {
+    // catch up faster than the normal task rate until the backlog is empty
+    m_drainEvent[reducer] = Simulator::Schedule(Seconds(1.0 / m_catchUpRate), &WqCheckpointSink::DrainGroupBacklog, this, reducer);
+  };
+}
+
+void
+WqCheckpointSink::SendTaskInterest(std::string reducer, std::string seqFlag)
+{
+  std::string taskString = reducer + m_disDownStream3 + m_ownPrefix + m_disDownStream2 + m_taskContent 
+                            + "-" + "/(" + seqFlag + ")-";
+  std::cout << "Assign task: " << taskString << std::endl;
+  uint32_t firstSeq = 0;
+  uint32_t lastSeq = 0;
+  WqSeqBatch::ParseRange(seqFlag, firstSeq, lastSeq);
+  for(uint32_t n=firstSeq; n<=lastSeq; n++) {
+    m_taskSentTime[reducer + "Seq" + std::to_string(n)] = Simulator::Now();
+  };
+  shared_ptr<Name> taskName = make_shared<Name>(taskString);
+  taskName->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
+  shared_ptr<Interest> taskInterest = make_shared<Interest>();
+  taskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
+  taskInterest->setName(*taskName);
+  taskInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
+  m_transmittedInterests(taskInterest, this, m_face);
+  m_appLink->onReceiveInterest(*taskInterest);
+}
+
+std::vector<std::string>
+WqCheckpointSink::SplitNodeList(std::string nodeList)
+{
+  // "/a-/b-/c-" -> "/a-", "/b-", "/c-"
+  std::vector<std::string> nodes;
+  uint64_t n = nodeList.find("-");
+  while(n != std::string::npos) {
+    nodes.push_back(nodeList.substr(0, n+1));
+    nodeList = nodeList.substr(n+1);
+    n = nodeList.find("-");
+  };
+  return nodes;
+}
+
+void
+WqCheckpointSink::RebalanceGroups()
+{
+  // one handover at a time, and never while a group recovers or catches up
+  if(!m_rebalance || m_handoverPhase != "" || m_pausedGroups.size() != 0) {
+    return;
+  };
+  std::map<std::string, std::deque<std::string>>::iterator backlog;
+  for(backlog=m_groupBacklog.begin(); backlog!=m_groupBacklog.end(); backlog++) {
+    if(backlog->second.size() != 0) {
+      return;
+    };
+  };
+  std::string slow = "";
+  std::string fast = "";
+  std::map<std::string, double>::iterator it;
+  for(it=m_groupLatency.begin(); it!=m_groupLatency.end(); it++) {
+    if(m_groupNode.find(it->first) == m_groupNode.end()) {
+      continue;
+    };
+    if(slow == "" || it->second > m_groupLatency[slow]) {
+      slow = it->first;
+    };
+    if(fast == "" || it->second < m_groupLatency[fast]) {
+      fast = it->first;
+    };
+  };
+  if(slow == "" || slow == fast || m_groupLatency[slow] < m_rebalanceRatio * m_groupLatency[fast]) {
+    return;
+  };
+  std::vector<std::string> slowMappers = SplitNodeList(m_groupNode[slow]);
+  if(slowMappers.size() <= 1) {
+    return;
+  };
+
+  // the mappers of the slow group closest to the fast reducer move first
+  std::vector<std::pair<uint32_t, std::string>> byCost;
+  std::map<std::string, std::vector<uint32_t>>::iterator cost = m_hopCost.find(fast);
+  for(uint64_t m=0; m<slowMappers.size(); m++) {
+    uint32_t hops = slowMappers.size() - m;
+    if(cost != m_hopCost.end()) {
+      std::vector<std::string>::iterator idx = std::find(m_mappers.begin(), m_mappers.end(), slowMappers[m]);
+      if(idx != m_mappers.end() && (uint64_t)(idx - m_mappers.begin()) < cost->second.size()) {
+        hops = cost->second[idx - m_mappers.begin()];
       };
     };
-    m_sendJobNeis.clear();
-    m_sendJobNeis = temp;
+    byCost.push_back(std::make_pair(hops, slowMappers[m]));
+  };
+  std::sort(byCost.begin(), byCost.end());
+  std::string moved = "";
+  m_handoverMappers.clear();
+  for(uint64_t m=0; m<byCost.size() && m<m_rebalanceStep && m+1<byCost.size(); m++) {
+    moved += byCost[m].second;
+    m_handoverMappers.push_back(byCost[m].second);
+  };
 
-    m_nodes4CP.clear();
-    m_nodes4CP = m_mappers;
-    m_nodes4CP.insert(m_nodes4CP.end(), m_sendJobNeis.begin(), m_sendJobNeis.end());
+  std::string slowGroup = "";
+  for(uint64_t m=0; m<slowMappers.size(); m++) {
+    if(std::find(m_handoverMappers.begin(), m_handoverMappers.end(), slowMappers[m]) == m_handoverMappers.end()) {
+      slowGroup += slowMappers[m];
+    };
+  };
+  std::cout << "Rebalance: move " << moved << " from " << slow << " (" << m_groupLatency[slow] << "s) to "
+            << fast << " (" << m_groupLatency[fast] << "s)" << std::endl;
+
+  // both groups hold their next seqs, and the move waits until every seq issued so far
+  // came back from both. So each seq is computed by exactly one reducer for every mapper
+  m_handoverFrom = slow;
+  m_handoverTo = fast;
+  m_handoverMoved = moved;
+  m_handoverFromGroup = m_groupNode[slow];
+  m_handoverToGroup = m_groupNode[fast];
+  m_handoverNewFromGroup = slowGroup;
+  m_handoverPhase = "drain";
+  m_pausedGroups.insert(slow);
+  m_pausedGroups.insert(fast);
+  // a lost ack or a failed reducer must not keep both groups paused
+  m_handoverEvent = Simulator::Schedule(m_handoverTimeout, &WqCheckpointSink::AbortHandover, this);
+  CheckHandoverDrained();
+}
 
-    /* for (auto& x: m_sendJobNeis) {
-      std::cout << "pick_reducers: " << x << '\n';
+bool
+WqCheckpointSink::GroupDrained(std::string reducer)
+{
+  std::set<std::string>& rxSeqs = m_groupRxSeqs[reducer];
+  for(int n=m_seqNum; n>=1; n--) {
+    if(rxSeqs.find("Seq" + std::to_string(n)) == rxSeqs.end()) {
+      return false;
     };
-    for (auto& x: m_groupNode) {
-      std::cout << "R= " << x.first << " M= " << x.second << '\n';
-    }; */
+  };
+  return true;
+}
 
+void
+WqCheckpointSink::CheckHandoverDrained()
+{
+  if(m_handoverPhase != "drain" || !GroupDrained(m_handoverFrom) || !GroupDrained(m_handoverTo)) {
+    return;
   };
+  std::cout << "Handover drained " << m_handoverFrom << " and " << m_handoverTo << std::endl;
+  m_groupNode[m_handoverFrom] = m_handoverNewFromGroup;
+  m_groupNode[m_handoverTo] += m_handoverMoved;
+  m_handoverPhase = "swap";
+  m_handoverAcks = 2;
+  SendOutInterest(m_handoverFrom + "/release<" + m_handoverMoved + ">" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  SendOutInterest(m_handoverTo + "/adopt<" + m_handoverMoved + ">" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+}
 
-};
+void
+WqCheckpointSink::FinishHandover()
+{
+  // the groups resume only once every moved mapper sends to its new reducer
+  m_handoverPhase = "newUp";
+  m_handoverAcks = m_handoverMappers.size();
+  for(uint64_t m=0; m<m_handoverMappers.size(); m++) {
+    SendOutInterest(m_handoverMappers[m] + "/newUp(" + m_handoverTo + ")-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  };
+  if(m_handoverAcks == 0) {
+    CompleteHandover();
+  };
+}
+
+void
+WqCheckpointSink::CompleteHandover()
+{
+  std::cout << "Handover done from " << m_handoverFrom << " to " << m_handoverTo << std::endl;
+  Simulator::Cancel(m_handoverEvent);
+  // both groups changed, their latency is measured again
+  m_groupLatency.erase(m_handoverFrom);
+  m_groupLatency.erase(m_handoverTo);
+  m_handoverPhase = "";
+  m_handoverAcks = 0;
+  m_handoverMappers.clear();
+  ResumeGroup(m_handoverFrom);
+  ResumeGroup(m_handoverTo);
+}
+
+void
+WqCheckpointSink::AbortHandover()
+{
+  if(m_handoverPhase == "") {
+    return;
+  };
+  std::cout << "Handover from " << m_handoverFrom << " to " << m_handoverTo << " aborted in " << m_handoverPhase << std::endl;
+  Simulator::Cancel(m_handoverEvent);
+  // "/undo-" acks are not counted, a later handover never mistakes them for its own
+  if(m_handoverPhase != "drain") {
+    SendOutInterest(m_handoverTo + "/release<" + m_handoverMoved + ">/undo-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+    SendOutInterest(m_handoverFrom + "/adopt<" + m_handoverMoved + ">/undo-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  };
+  if(m_handoverPhase == "newUp") {
+    for(uint64_t m=0; m<m_handoverMappers.size(); m++) {
+      SendOutInterest(m_handoverMappers[m] + "/newUp(" + m_handoverFrom + ")-/undo-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+    };
+  };
+  m_handoverPhase = "";
+  m_handoverAcks = 0;
+  m_handoverMappers.clear();
+  m_groupNode[m_handoverFrom] = m_handoverFromGroup;
+  m_groupNode[m_handoverTo] = m_handoverToGroup;
+  // a failed reducer stays paused, its replacement takes the group over
+  if(std::find(m_preFailReducer.begin(), m_preFailReducer.end(), m_handoverFrom) == m_preFailReducer.end()) {
+    ResumeGroup(m_handoverFrom);
+  };
+  if(std::find(m_preFailReducer.begin(), m_preFailReducer.end(), m_handoverTo) == m_preFailReducer.end()) {
+    ResumeGroup(m_handoverTo);
+  };
+}
 
 void
 WqCheckpointSink::AssignJobs()
 {
-  m_seqNum += 1;
-  std::string seqStr = std::to_string(m_seqNum);
-  std::string seqFlag = "Seq" + seqStr;
-  std::map<std::string, int>::iterator checkJobSeq = m_assignJobSeq.find(seqFlag);
-  if (checkJobSeq == m_assignJobSeq.end()) {
-    m_assignJobSeq.insert(std::pair<std::string, int>(seqFlag, 0));
-  }
+  // one task Interest carries the seqs [firstSeq, m_seqNum], all bookkeeping stays per seq
+  int firstSeq = m_seqNum + 1;
+  m_seqNum += m_batchSize;
+  std::string seqFlag = WqSeqBatch::RangeFlag(firstSeq, m_seqNum);
+  for(int n=firstSeq; n<=m_seqNum; n++) {
+    // only window mode completes and expires issued seqs
+    if(m_issueMode == "window") {
+      m_issueWindow.OnIssue(n);
+    };
+    std::string eachSeq = "Seq" + std::to_string(n);
+    std::map<std::string, int>::iterator checkJobSeq = m_assignJobSeq.find(eachSeq);
+    if (checkJobSeq == m_assignJobSeq.end()) {
+      m_assignJobSeq.insert(std::pair<std::string, int>(eachSeq, 0));
+    }
+  };
   // std::cout << "User assign Seq length " <<  m_assignJobSeq.size() << std::endl;
   int i = 0;
   std::map<std::string, std::string>::iterator it_assign;
-  if(m_seqNum == 1) {
+  if(firstSeq == 1) {
     for(it_assign=m_groupNode.begin(); it_assign!=m_groupNode.end(); it_assign++)
     {
       if(std::find(m_sendJobNeis.begin(), m_sendJobNeis.end(), it_assign->first) == m_sendJobNeis.end()) {
@@ -526,6 +1358,9 @@ WqCheckpointSink::AssignJobs()
       std::string taskString = it_assign->first + "/child<" + it_assign->second + ">" + m_disDownStream3 + m_ownPrefix + m_disDownStream2 + m_taskContent 
                                 + "-/(" + seqFlag + ")-";
       std::cout << "Assign task: " << taskString << std::endl;
+      for(int n=firstSeq; n<=m_seqNum; n++) {
+        m_taskSentTime[it_assign->first + "Seq" + std::to_string(n)] = Simulator::Now();
+      };
       shared_ptr<Name> taskName = make_shared<Name>(taskString);
       taskName->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
       shared_ptr<Interest> taskInterest = make_shared<Interest>();
@@ -535,63 +1370,110 @@ WqCheckpointSink::AssignJobs()
       m_transmittedInterests(taskInterest, this, m_face);
       m_appLink->onReceiveInterest(*taskInterest);
       i++;
-      if(!m_reScheduleJob) {
-        ScheduleNextPacket();
-      };
-      
     };
-    m_assignJobSeq[seqFlag] = i;
   }
   else {
     for(uint64_t j=0; j<m_sendJobNeis.size(); j++)
     {
-      std::string taskString = m_sendJobNeis[j] + m_disDownStream3 + m_ownPrefix + m_disDownStream2 + m_taskContent 
-                                + "-" + "/(Seq" + seqStr + ")-";
-      std::cout << "Assign task: " << taskString << std::endl;
-      shared_ptr<Name> taskName = make_shared<Name>(taskString);
-      taskName->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-      shared_ptr<Interest> taskInterest = make_shared<Interest>();
-      taskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-      taskInterest->setName(*taskName);
-      taskInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
-      m_transmittedInterests(taskInterest, this, m_face);
-      m_appLink->onReceiveInterest(*taskInterest);
-      i++;
-      if(!m_reScheduleJob) {
-        ScheduleNextPacket();
+      std::string reducer = m_sendJobNeis[j];
+      std::map<std::string, std::deque<std::string>>::iterator backlog = m_groupBacklog.find(reducer);
+      if(m_pausedGroups.find(reducer) != m_pausedGroups.end() ||
+         (backlog != m_groupBacklog.end() && backlog->second.size() != 0)) {
+        // group under recovery or still catching up, keep the seq order of its backlog
+        m_groupBacklog[reducer].push_back(seqFlag);
+        std::cout << "Buffer task: " << reducer << " " << seqFlag << std::endl;
+      }
+      else {
+        SendTaskInterest(reducer, seqFlag);
       };
+      i++;
     }
-    m_assignJobSeq[seqFlag] = i;
   };
+  for(int n=firstSeq; n<=m_seqNum; n++) {
+    m_assignJobSeq["Seq" + std::to_string(n)] = i;
+  };
+  // healthy groups keep their task rate while a group is recovering
+  ScheduleNextPacket();
   
   //start checkpoint
   if(m_seqNum >= 20) {
-    if(m_seqNum % 20 == 0) {
-      m_cpEnd = m_cpStart + 19;
-      std::string cpID = std::to_string(m_cpStart) + "-" + std::to_string(m_cpEnd);
-      std::map<std::string, int>::iterator checkID = m_requestCp.find(cpID);
-      if (checkID == m_requestCp.end()) {
-        m_requestCp.insert(std::pair<std::string, int>(cpID, 0));
-      }
-      int count_cp = 0;
-      for(uint64_t p=0; p < m_nodes4CP.size(); p++){
-        std::string cpTask = m_nodes4CP[p] + "/cpSeq(" + std::to_string(m_cpStart) + "-" + std::to_string(m_cpEnd) + ")-";
-        shared_ptr<Name> cpTaskName = make_shared<Name>(cpTask);
-        //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-        shared_ptr<Interest> cpTaskInterest = make_shared<Interest>();
-        cpTaskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-        cpTaskInterest->setName(*cpTaskName);
-        cpTaskInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
-        std::cout << " Sink Checkpoint-msg " << cpTaskInterest->getName().toUri() << std::endl;
-        m_transmittedInterests(cpTaskInterest, this, m_face);
-        m_appLink->onReceiveInterest(*cpTaskInterest);
-        count_cp++;
+    // a batch may step over the multiple of 20
+    if(m_seqNum / 20 != (firstSeq - 1) / 20) {
+      StartCheckpoint();
+      RebalanceGroups();
+    };
+  };
+}
+
+void
+WqCheckpointSink::StartCheckpoint()
+{
+  // earlier checkpoints may still be collecting, a new one only waits when too many are open
+  if(!m_cpCoordinator.CanBegin()) {
+    std::cout << " Sink defers Checkpoint, open Num= " << m_cpCoordinator.GetOpenEpochs() << std::endl;
+    return;
+  };
+  // a deferred checkpoint is merged into this one
+  m_cpEnd = m_seqNum;
+  std::string cpID = std::to_string(m_cpStart) + "-" + std::to_string(m_cpEnd);
+
+  std::vector<std::string> cpNodes;
+  if(m_cpLeaderMode == "reducer") {
+    // one healthy job reducer collects the replies of all nodes and answers once
+    std::string leader = "";
+    for(uint64_t j=0; j<m_sendJobNeis.size() && leader==""; j++) {
+      if(m_pausedGroups.find(m_sendJobNeis[j]) == m_pausedGroups.end()) {
+        leader = m_sendJobNeis[j];
       };
-      m_requestCp[cpID] = count_cp;
-      std::cout << " Sink sent Checkpoint-ID= " << cpID << " & Num= " << m_requestCp[cpID] << std::endl;
-      m_cpStart = m_cpEnd + 1;
+    };
+    if(leader == "") {
+      std::cout << " Sink defers Checkpoint, no reducer to lead" << std::endl;
+      return;
+    };
+    std::string nodes = "";
+    for(uint64_t p=0; p < m_nodes4CP.size(); p++){
+      nodes += m_nodes4CP[p];
+    };
+    cpNodes.push_back(leader);
+    SendCheckpointInterest(leader + "/cpLead<" + nodes + ">(" + cpID + ")-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
+  }
+  else {
+    cpNodes = m_nodes4CP;
+    for(uint64_t p=0; p < m_nodes4CP.size(); p++){
+      SendCheckpointInterest(m_nodes4CP[p] + "/cpSeq(" + cpID + ")-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2);
     };
   };
+  m_cpCoordinator.BeginCheckpoint(cpID, cpNodes);
+  // a lost checkpoint Interest or reply must not keep the epoch open
+  m_cpTimeouts[cpID] = Simulator::Schedule(m_interestLifeTime, &WqCheckpointSink::ExpireCheckpoint, this, cpID);
+  std::cout << " Sink sent Checkpoint-ID= " << cpID << " & Num= " << cpNodes.size() << std::endl;
+  m_cpStart = m_cpEnd + 1;
+}
+
+void
+WqCheckpointSink::ExpireCheckpoint(std::string cpID)
+{
+  m_cpTimeouts.erase(cpID);
+  if(!m_cpCoordinator.Expire(cpID)) {
+    return;
+  };
+  // recovery replaces the failures reported so far, or closes the epoch if there are none
+  std::cout << " Sink Checkpoint-ID= " << cpID << " expired" << std::endl;
+  PickRecoverReducer(cpID);
+}
+
+void
+WqCheckpointSink::SendCheckpointInterest(std::string cpTask)
+{
+  shared_ptr<Name> cpTaskName = make_shared<Name>(cpTask);
+  //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
+  shared_ptr<Interest> cpTaskInterest = make_shared<Interest>();
+  cpTaskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
+  cpTaskInterest->setName(*cpTaskName);
+  cpTaskInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
+  std::cout << " Sink Checkpoint-msg " << cpTaskInterest->getName().toUri() << std::endl;
+  m_transmittedInterests(cpTaskInterest, this, m_face);
+  m_appLink->onReceiveInterest(*cpTaskInterest);
 }
 
 void
@@ -631,7 +1513,7 @@ WqCheckpointSink::SendOutInterest(std::string newInterest)
   shared_ptr<Interest> sendInterest = make_shared<Interest>();
   sendInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   sendInterest->setName(*sendName);
-  sendInterest->setInterestLifetime(ndn::time::seconds(1));
+  sendInterest->setInterestLifetime(GetClassLifetime(newInterest));
   m_transmittedInterests(sendInterest, this, m_face);
   m_appLink->onReceiveInterest(*sendInterest);
 }
@@ -663,13 +1545,58 @@ WqCheckpointSink::ResentDataCheck(std::string resentSeq)
   };
 }
 
+void
+WqCheckpointSink::SaveCheckpointRecord(std::string reducer, std::string record)
+{
+  bool full = false;
+  std::map<uint64_t, int64_t> entries;
+  std::vector<uint64_t> removed;
+  if(!WqCheckpointCodec::DecodeRecord(record, full, entries, removed)) {
+    std::cout << "Sink got broken Checkpoint-Record from " << reducer << std::endl;
+    return;
+  };
+  // a full record starts a new chain, deltas only make sense on top of it
+  if(full) {
+    m_cpChain[reducer].clear();
+  }
+  else if(m_cpChain[reducer].empty()) {
+    std::cout << "Sink got Checkpoint-Delta without base from " << reducer << std::endl;
+    return;
+  };
+  m_cpChain[reducer].push_back(record);
+
+  std::ofstream recording;
+  recording.open("checkpointSizeRecord.txt", std::ios_base::app);
+  recording << Simulator::Now().GetSeconds() << '\t' << reducer << '\t' << (full ? "full" : "delta") << '\t'
+            << record.size() << std::endl;
+  recording.close();
+}
+
+std::map<uint64_t, int64_t>
+WqCheckpointSink::RebuildCheckpointState(std::string reducer)
+{
+  std::map<uint64_t, int64_t> state;
+  std::map<std::string, std::vector<std::string>>::iterator it = m_cpChain.find(reducer);
+  if(it == m_cpChain.end()) {
+    return state;
+  };
+  for(uint64_t i=0; i < it->second.size(); i++) {
+    bool full = false;
+    std::map<uint64_t, int64_t> entries;
+    std::vector<uint64_t> removed;
+    WqCheckpointCodec::DecodeRecord(it->second[i], full, entries, removed);
+    WqCheckpointCodec::ApplyRecord(state, full, entries, removed);
+  };
+  return state;
+}
+
 void
 WqCheckpointSink::OnData(shared_ptr<const Data> data)
 {
   //parse data content
     auto *tmpContent = ((uint8_t*)data->getContent().value());
     std::string receivedData;
-    for(uint8_t i=0; i < data->getContent().value_size(); i++) {
+    for(uint64_t i=0; i < data->getContent().value_size(); i++) {
       receivedData.push_back((char)tmpContent[i]);
     };
     // std::cout << "User Receive Data: " << receivedData << " from " << data->getName().toUri() << std::endl;
@@ -681,6 +1608,12 @@ WqCheckpointSink::OnData(shared_ptr<const Data> data)
     uint64_t cp = gotData.find("cp");
     uint64_t recover = gotData.find("recover");
     uint64_t rollback = gotData.find("rollback");
+    uint64_t promote = gotData.find("promote");
+    uint64_t standby = gotData.find("standby");
+    uint64_t release = gotData.find("release");
+    uint64_t adopt = gotData.find("adopt");
+    uint64_t newUp = gotData.find("newUp");
+    uint64_t plan = gotData.find("/plan<");
 
     if(gotData[1] == 'n')
     {
@@ -784,7 +1717,25 @@ WqCheckpointSink::OnData(shared_ptr<const Data> data)
     {
       // std::cout << "Sink got CP-Data: " << receivedData << std::endl;
       uint64_t compteInfo = gotData.find("Com");
-      if(compteInfo != std::string::npos) {
+      uint64_t costInfo = gotData.find("cpCost");
+      if(costInfo != std::string::npos) {
+        std::string reducer = gotData.substr(0, gotData.find_first_of("-")+1);
+        std::vector<uint32_t> costs;
+        std::string costList = receivedData + ",";
+        uint64_t q = costList.find(",");
+        while(q != std::string::npos && q != 0) {
+          // cost 0 means no FIB route, taken as unreachable
+          uint32_t cost = std::stoul(costList.substr(0, q));
+          costs.push_back(cost == 0 ? 1000 : cost);
+          costList = costList.substr(q+1);
+          q = costList.find(",");
+        };
+        m_hopCost[reducer] = costs;
+        if(m_hopCost.size() == (uint64_t)m_txCostNum) {
+          RunJobPlan();
+        };
+      }
+      else if(compteInfo != std::string::npos) {
         m_rxCpReducerNum++;
         uint64_t u = receivedData.find_first_of("&");
         std::string node_type = receivedData.substr(0, u);
@@ -796,6 +1747,10 @@ WqCheckpointSink::OnData(shared_ptr<const Data> data)
           it = find (m_existReducers.begin(), m_existReducers.end(), node_type);
           if (it == m_existReducers.end()) {
             m_existReducers.push_back(node_type);
+            // a reducer new to the job can take over a group that waits for a spare
+            if(m_unreplacedReducers.size() != 0) {
+              RetryUnreplaced();
+            };
           };
         }
         else {
@@ -807,7 +1762,12 @@ WqCheckpointSink::OnData(shared_ptr<const Data> data)
         if(m_txCpReducerNum == m_rxCpReducerNum) {
           std::cout << "Sink got ComputeNodes Num=: " << m_existReducers.size() << std::endl;
           std::cout << "Sink got Mapper Num=: " << m_mappers.size() << std::endl;
-          RunJobPlan();
+          if(m_censusCache.IsEnabled()) {
+            m_censusCache.Set("mappers", WqTreeCache::JoinNames(m_mappers));
+            m_censusCache.Set("reducers", WqTreeCache::JoinNames(m_existReducers));
+            m_censusCache.Save(GetTopologyFingerprint(m_ownPrefix));
+          };
+          PlanJob();
           m_txCpReducerNum =0;
           m_rxCpReducerNum =0;
         };
@@ -816,186 +1776,293 @@ WqCheckpointSink::OnData(shared_ptr<const Data> data)
         uint64_t v1 = gotData.find("(");
         uint64_t v2 = gotData.find(")");
         std::string cpID = gotData.substr(v1+1, v2-v1-1);
+        std::string cpNode = gotData.substr(0, gotData.find_first_of("-")+1);
         // std::cout << "CheckPoint-ID= " << cpID << std::endl;
-        std::map<std::string, int>::iterator checkCp = m_receiveCp.find(cpID);
-        if(checkCp == m_receiveCp.end()) {
-          m_receiveCp.insert(std::pair<std::string, int>(cpID, 1));
-        }
-        else {
-          checkCp->second ++;
-          // std::cout << "Sink recevice CheckPoint-ID= " << cpID << " & Num=" << checkCp->second << std::endl;
+
+        // text header before "#", binary checkpoint records after it: one record from a
+        // reducer, or a bundle of (node, record) from a delegated checkpoint leader
+        uint64_t h = receivedData.find_first_of("#");
+        std::string cpHeader = receivedData.substr(0, h);
+        if(h != std::string::npos) {
+          std::string records = receivedData.substr(h+1);
+          if(gotData.find("cpLead") != std::string::npos) {
+            uint64_t pos = 0;
+            std::string node, record;
+            while(pos < records.size() && WqCheckpointCodec::ReadBundleEntry(records, pos, node, record)) {
+              SaveCheckpointRecord(node, record);
+            };
+          }
+          else {
+            SaveCheckpointRecord(cpNode, records);
+          };
         };
 
-        //check each reply msg if checkpoiont OK or Fail
-        uint64_t check_fail = receivedData.find("Fail");
+        //check each reply msg if checkpoiont OK or Fail, "node&Fail" or "leader&Fail&/a-;/b-"
+        bool collected = false;
+        uint64_t check_fail = cpHeader.find("&Fail");
         if(check_fail != std::string::npos) {
-          uint64_t l = receivedData.find_first_of("-");
-          std::cout << "Fail-node= " << receivedData.substr(0,l+1) << std::endl;
-          m_preFailReducer.push_back(receivedData.substr(0,l+1));
-          std::map<std::string, std::string>::iterator it = m_cpFailMsg.find(cpID);
-          if(it == m_cpFailMsg.end()) {
-            m_cpFailMsg.insert(std::pair<std::string, std::string>(cpID, receivedData.substr(0,l+1)));
-          }
-          else{
-            it->second = it->second + ";" + receivedData.substr(0,l+1);
+          std::vector<std::string> failNodes;
+          std::string failList = cpNode + ";";
+          if(cpHeader.find("&", check_fail+1) != std::string::npos) {
+            failList = cpHeader.substr(cpHeader.find("&", check_fail+1)+1) + ";";
           };
+          uint64_t q = failList.find(";");
+          while(q != std::string::npos) {
+            if(q != 0) {
+              std::cout << "Fail-node= " << failList.substr(0, q) << std::endl;
+              failNodes.push_back(failList.substr(0, q));
+              if(std::find(m_preFailReducer.begin(), m_preFailReducer.end(), failList.substr(0, q)) == m_preFailReducer.end()) {
+                m_preFailReducer.push_back(failList.substr(0, q));
+              };
+            };
+            failList = failList.substr(q+1);
+            q = failList.find(";");
+          };
+          collected = m_cpCoordinator.Fail(cpID, cpNode, failNodes);
+        }
+        else {
+          collected = m_cpCoordinator.Ack(cpID, cpNode);
         };
 
-        if(m_requestCp.at(cpID) == m_receiveCp.at(cpID)) {
+        if(collected) {
           std::cout << "Sink got ALL CheckPoint-ID= Seq" << cpID << std::endl;
-          if(m_cpFailMsg.size() != 0) {
-            m_failSeq = cpID;
-            PickRecoverReducer();
+          Simulator::Cancel(m_cpTimeouts[cpID]);
+          m_cpTimeouts.erase(cpID);
+          if(m_cpCoordinator.GetState(cpID) == WqCheckpointCoordinator::CP_FAILED) {
+            PickRecoverReducer(cpID);
           }
           else {
             // save successful checkpoint state
-            std::map<std::string, std::string>::iterator it = m_cpRecords.find(cpID);
-            if(it == m_cpRecords.end()) {
-              m_cpRecords.insert(std::pair<std::string, std::string>(cpID, "ok"));
-            }
-            for (auto& x: m_cpRecords) {
-              std::cout << "id= " << x.first << " Status= " << x.second << '\n';
+            m_cpCoordinator.Commit(cpID);
+            const std::map<std::string, WqCheckpointCoordinator::Epoch>& epochs = m_cpCoordinator.GetEpochs();
+            std::map<std::string, WqCheckpointCoordinator::Epoch>::const_iterator it;
+            for (it=epochs.begin(); it!=epochs.end(); it++) {
+              std::cout << "id= " << it->first << " Status= " << WqCheckpointCoordinator::StateName(it->second.state) << '\n';
             };
           };
         };
       };
     }
-    // reply from picked recover-reducer 
-    else if (recover != std::string::npos)
+    // reply from picked recover-reducer, or from a promoted standby-reducer
+    else if (recover != std::string::npos || promote != std::string::npos)
     {
       std::cout << "Sink got Recover-reducer-Reply:" << receivedData << std::endl;
-      if(m_cpRecords.size() == 0) {
-        // m_cpRecords =0, means there is no successful checkpoint, need to restart from begining
-        m_rollbackID="";
+      std::string reducer = gotData.substr(0, gotData.find_first_of("-")+1);
+      if(promote != std::string::npos) {
+        // the standby already holds the group state, its group resumes right away
+        ResumeGroup(reducer);
       }
       else {
-        //rollback to last-saved seqID
-        std::map<std::string, std::string>::iterator it_cp;
-        int max_ID=0;
-        std::string last_cpid="";
-        for(it_cp = m_cpRecords.begin(); it_cp != m_cpRecords.end(); it_cp++) {
-          // std::cout << "cp-records:" << it_cp->first << " & " << it_cp->second << std::endl;
-          uint64_t q = it_cp->first.find("-");
-          last_cpid = it_cp->first.substr(q+1);
-          if(stoi(last_cpid) > max_ID) {
-            max_ID = stoi(last_cpid);
-          }
-        }
-        m_rollbackID = std::to_string(max_ID);
-        // std::cout << "-------maxID:" << m_rollbackID << std::endl;
-      };
-      m_reScheduleJob=false;
-      //tell reducers to rollback due to failure, to help reducers clear local computation records
-      for(uint64_t j=0; j<m_sendJobNeis.size(); j++) {
-        std::string rollback = m_sendJobNeis[j] + "/rollback-";
+        //tell the cold replacement to rollback to the last checkpoint, to clear its local computation records
+        std::string rollback = reducer + "/rollback-" + m_disDownStream3 + m_ownPrefix + m_disDownStream2;
         // std::cout << "Rollbask msg: " << rollback << std::endl;
         SendOutInterest(rollback);
-        m_txRollback++;
+        m_cpCoordinator.Rollback(reducer);
+      };
+      std::string cpID;
+      if(m_cpCoordinator.Recovered(reducer, cpID)) {
+        CompleteRecovery(cpID);
       };
     }
+    // ack of a mapper handover between two reducers
+    else if (release != std::string::npos || adopt != std::string::npos)
+    {
+      std::cout << "Sink got Handover-Reply: " << receivedData << std::endl;
+      if(m_handoverPhase == "swap" && gotData.find("/undo-") == std::string::npos && gotData.find("/tree-") == std::string::npos) {
+        m_handoverAcks--;
+        if(m_handoverAcks == 0) {
+          FinishHandover();
+        };
+      };
+    }
+    // inner reducer got its children, jobs start once the whole tree is set up
+    else if (plan != std::string::npos)
+    {
+      std::cout << "Sink got Plan-Reply: " << receivedData << std::endl;
+      std::string reducer = gotData.substr(0, gotData.find_first_of("-")+1);
+      if(m_replanInner.erase(reducer) != 0) {
+        // replacement of an inner reducer joined, the subtree above restarts the seqs it lost
+        RollbackSubtree(TopReducerOf(reducer));
+        std::string cpID;
+        if(m_cpCoordinator.Recovered(reducer, cpID)) {
+          CompleteRecovery(cpID);
+        };
+      }
+      else {
+        m_planAcks--;
+        if(m_planAcks == 0) {
+          AssignJobs();
+        };
+      };
+    }
+    else if (newUp != std::string::npos)
+    {
+      std::cout << "Sink got Mapper-Upstream-Reply: " << receivedData << std::endl;
+      if(m_handoverPhase == "newUp" && gotData.find("/undo-") == std::string::npos && gotData.find("/tree-") == std::string::npos) {
+        m_handoverAcks--;
+        if(m_handoverAcks == 0) {
+          CompleteHandover();
+        };
+      };
+    }
+    // reply for standby designation
+    else if (standby != std::string::npos)
+    {
+      std::cout << "Sink got Standby-Reply: " << receivedData << std::endl;
+    }
     else if (rollback != std::string::npos)
     {
-      m_rxRollback++;
-      if(m_rxRollback == m_txRollback) {
-        //rollback to seq=1 to restart
-        std::cout << "----- Rollbask msg Finish " << std::endl;
-        if(m_rollbackID != "") {
-          m_seqNum = stoi(m_rollbackID);
-        }
-        else { 
-          m_seqNum=0;
+      std::string reducer = gotData.substr(0, gotData.find_first_of("-")+1);
+      std::cout << "----- Rollbask msg Finish at " << reducer << std::endl;
+      std::string cpID;
+      if(m_cpCoordinator.RolledBack(reducer, cpID)) {
+        std::cout << "----- Checkpoint-ID= " << cpID << " recovered" << std::endl;
+      };
+      std::map<std::string, std::string>::iterator top = m_rollbackTop.find(reducer);
+      if(top != m_rollbackTop.end()) {
+        // a subtree resumes once all its reducers rolled back
+        std::string topReducer = top->second;
+        m_rollbackTop.erase(top);
+        m_subtreeRollbacks[topReducer]--;
+        if(m_subtreeRollbacks[topReducer] == 0) {
+          m_subtreeRollbacks.erase(topReducer);
+          ResumeGroup(topReducer);
         };
-        m_assignJobSeq.clear();
-        m_receiveJobSeq.clear();
-        m_receiveSeqData.clear();
-        m_seqOkList.clear();
-        m_cpStart = m_cpStart - 20;
-        m_requestCp[m_failSeq] = 0;
-        m_receiveCp[m_failSeq] = 0;
-        AssignJobs();
-        m_rollbackID="";
-        m_failSeq="";
-        m_cpFailMsg.clear();
+      }
+      else {
+        ResumeGroup(reducer);
       };
     }
     // normal data
     else
     {
       std::cout << "User Receive Data: " << receivedData << std::endl;
-      uint64_t s1 = receivedData.find("Seq");
-      uint64_t s2 = receivedData.find("-");
-      std::string gotSeq = receivedData.substr(s1, s2-s1);
-      std::string gotResult = receivedData.substr(s2+1);
-      // std::cout << "User Receive Seq= " << gotSeq << std::endl;
-
-      std::map<std::string, int>::iterator checkJobSeq = m_receiveJobSeq.find(gotSeq);
-      if (checkJobSeq == m_receiveJobSeq.end()) {
-        m_receiveJobSeq.insert(std::pair<std::string, int>(gotSeq, 1));
-        std::map<std::string, std::string>::iterator check2 = m_receiveSeqData.find(gotSeq);
-        if(check2 == m_receiveSeqData.end())
-        {
-          m_receiveSeqData.insert(std::pair<std::string, std::string>(gotSeq, gotResult));
-        }
-        else
-        {
-          m_receiveSeqData.at(gotSeq) = m_receiveSeqData.at(gotSeq) + ";" + gotResult;
+      // a batch reply carries one result per seq of its range
+      std::vector<std::string> seqResults = WqSeqBatch::Split(receivedData);
+      for(uint64_t b=0; b<seqResults.size(); b++) {
+        std::string seqResult = seqResults[b];
+        uint64_t s1 = seqResult.find("Seq");
+        uint64_t s2 = seqResult.find("-");
+        std::string gotSeq = seqResult.substr(s1, s2-s1);
+        std::string gotResult = seqResult.substr(s2+1);
+        // std::cout << "User Receive Seq= " << gotSeq << std::endl;
+        if(gotResult.find("p") != std::string::npos) {
+          // partial aggregate, "vpA/B" covers A of B mappers
+          std::cout << "User Receive partial Seq= " << gotSeq << " result= " << gotResult << std::endl;
         };
-        // std::cout << "AllData-SameSeq = " << m_receiveSeqData.at(gotSeq) << std::endl;
-      }
-      else {
-        checkJobSeq->second += 1;
-        m_receiveSeqData.at(gotSeq) = m_receiveSeqData.at(gotSeq) + ";" + gotResult;
-        // std::cout << "AllData-SameSeq = " << m_receiveSeqData.at(gotSeq) << std::endl;
-      };
-
-      std::map<std::string, int>::iterator compareSeq = m_assignJobSeq.find(gotSeq);
-      if (compareSeq != m_assignJobSeq.end()) 
-      {
-        if (m_assignJobSeq.at(gotSeq) == m_receiveJobSeq.at(gotSeq)) 
-        {
-          // std::cout << "User Receive==Sent Seq= " << gotSeq << " and num=" << m_receiveJobSeq.at(gotSeq)  << std::endl;
-          for (auto x: m_seqOkList) {
-            std::cout << "User Receive==Sent Seq List: " << x << std::endl;
+        std::string fromReducer = gotData.substr(0, gotData.find_first_of("-")+1);
+        if(m_groupNode.find(fromReducer) == m_groupNode.end()) {
+          // late data of a replaced reducer, its seqs are recomputed by the replacement
+          std::cout << "Ignore data from replaced reducer " << fromReducer << std::endl;
+          return;
+        };
+        m_groupRxSeqs[fromReducer].insert(gotSeq);
+        if(fromReducer == m_handoverFrom || fromReducer == m_handoverTo) {
+          CheckHandoverDrained();
+        };
+        std::map<std::string, Time>::iterator sent = m_taskSentTime.find(fromReducer + gotSeq);
+        if(sent != m_taskSentTime.end()) {
+          double sample = (Simulator::Now() - sent->second).GetSeconds();
+          std::map<std::string, double>::iterator latency = m_groupLatency.find(fromReducer);
+          if(latency == m_groupLatency.end()) {
+            m_groupLatency[fromReducer] = sample;
+          }
+          else {
+            latency->second = 0.8 * latency->second + 0.2 * sample;
           };
-          // for (auto x: m_receiveSeqData) {
-          //   std::cout << "User AllReceiveSeq= " << x.first << " Data= " << x.second << std::endl;
-          // };
-          m_seqOkList.push_back(gotSeq);
-          std::ofstream recording;
-          recording.open("computeStateRecord.txt", std::ios_base::app);
-          recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_seqOkList.size() << std::endl;
-          recording.close();
-
-          m_countOkSeq++;
-          if(m_countOkSeq == 2000) {
-            // for (auto x: m_seqOkList) {
-            //   std::cout << "User Receive==Sent Seq List: " << x << std::endl;
-            // };
-            std::string notifySeqs = "";
-            for(uint64_t h=0; h<10; h++) {
-              notifySeqs = notifySeqs + m_seqOkList[h] + "/";
-              m_askClearSeqs.push_back(m_seqOkList[h]);
-            };
-            for(uint64_t n=0; n<m_oneHopNeighbours.size(); n++)
-            {
-              std::string notifyClearSeq = m_oneHopNeighbours[n] + "/clear-" + notifySeqs + "-";
-              std::cout << "User notify to clear-Seqs " << notifyClearSeq << std::endl;
-              SendOutInterest(notifyClearSeq);
-            };
-            m_seqOkList.erase(m_seqOkList.begin(), m_seqOkList.begin()+20);
-            m_countOkSeq=0;
+          m_taskSentTime.erase(sent);
+        };
 
-            std::ofstream recording;
-            recording.open("computeStateRecord.txt", std::ios_base::app);
-            recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_seqOkList.size() << std::endl;
-            recording.close();
+        if(gotResult.find("p") != std::string::npos) {
+          m_partialResult[gotSeq][fromReducer] = gotResult;
+          if(m_partialPolicy == "wait") {
+            // counted once a late fill brings full coverage
+            continue;
           };
-        }
+          // remember which ";" entry is this reducer's, other reducers may send the same value
+          std::map<std::string, std::string>::iterator booked = m_receiveSeqData.find(gotSeq);
+          m_partialIndex[gotSeq][fromReducer] = (booked == m_receiveSeqData.end())
+            ? 0 : std::count(booked->second.begin(), booked->second.end(), ';') + 1;
+        };
+        BookSeqResult(gotSeq, gotResult);
       };
-      
     }
 }
 
+void
+WqCheckpointSink::BookSeqResult(std::string gotSeq, std::string gotResult)
+{
+  std::map<std::string, int>::iterator checkJobSeq = m_receiveJobSeq.find(gotSeq);
+  if (checkJobSeq == m_receiveJobSeq.end()) {
+    m_receiveJobSeq.insert(std::pair<std::string, int>(gotSeq, 1));
+    std::map<std::string, std::string>::iterator check2 = m_receiveSeqData.find(gotSeq);
+    if(check2 == m_receiveSeqData.end())
+    {
+      m_receiveSeqData.insert(std::pair<std::string, std::string>(gotSeq, gotResult));
+    }
+    else
+    {
+      m_receiveSeqData.at(gotSeq) = m_receiveSeqData.at(gotSeq) + ";" + gotResult;
+    };
+    // std::cout << "AllData-SameSeq = " << m_receiveSeqData.at(gotSeq) << std::endl;
+  }
+  else {
+    checkJobSeq->second += 1;
+    m_receiveSeqData.at(gotSeq) = m_receiveSeqData.at(gotSeq) + ";" + gotResult;
+    // std::cout << "AllData-SameSeq = " << m_receiveSeqData.at(gotSeq) << std::endl;
+  };
+
+  std::map<std::string, int>::iterator compareSeq = m_assignJobSeq.find(gotSeq);
+  if (compareSeq != m_assignJobSeq.end()) 
+  {
+    if (m_assignJobSeq.at(gotSeq) == m_receiveJobSeq.at(gotSeq)) 
+    {
+      // std::cout << "User Receive==Sent Seq= " << gotSeq << " and num=" << m_receiveJobSeq.at(gotSeq)  << std::endl;
+      for (auto x: m_seqOkList) {
+        std::cout << "User Receive==Sent Seq List: " << x << std::endl;
+      };
+      // for (auto x: m_receiveSeqData) {
+      //   std::cout << "User AllReceiveSeq= " << x.first << " Data= " << x.second << std::endl;
+      // };
+      m_seqOkList.push_back(gotSeq);
+      if(m_issueMode == "window" && m_issueWindow.OnComplete(std::stoul(gotSeq.substr(3)))) {
+        std::cout << "Issue window= " << m_issueWindow.GetWindow() << " outstanding= " << m_issueWindow.GetOutstanding() << std::endl;
+        Simulator::Cancel(m_windowEvent);
+        ScheduleNextPacket();
+      };
+      std::ofstream recording;
+      recording.open("computeStateRecord.txt", std::ios_base::app);
+      recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_seqOkList.size() << std::endl;
+      recording.close();
+
+      m_countOkSeq++;
+      if(m_countOkSeq == 2000) {
+        // for (auto x: m_seqOkList) {
+        //   std::cout << "User Receive==Sent Seq List: " << x << std::endl;
+        // };
+        std::string notifySeqs = "";
+        for(uint64_t h=0; h<10; h++) {
+          notifySeqs = notifySeqs + m_seqOkList[h] + "/";
+          m_askClearSeqs.push_back(m_seqOkList[h]);
+        };
+        for(uint64_t n=0; n<m_oneHopNeighbours.size(); n++)
+        {
+          std::string notifyClearSeq = m_oneHopNeighbours[n] + "/clear-" + notifySeqs + "-";
+          std::cout << "User notify to clear-Seqs " << notifyClearSeq << std::endl;
+          SendOutInterest(notifyClearSeq);
+        };
+        m_seqOkList.erase(m_seqOkList.begin(), m_seqOkList.begin()+20);
+        m_countOkSeq=0;
+
+        std::ofstream recording;
+        recording.open("computeStateRecord.txt", std::ios_base::app);
+        recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_seqOkList.size() << std::endl;
+        recording.close();
+      };
+    }
+  };
+};
+
 void
 WqCheckpointSink::OnInterest(shared_ptr<const Interest> interest)
 {
@@ -1008,6 +2075,7 @@ WqCheckpointSink::OnInterest(shared_ptr<const Interest> interest)
   uint64_t r = interest->getName().toUri().find("/resend");
   uint64_t leave = interest->getName().toUri().find("leave");
   uint64_t b = interest->getName().toUri().find("backTree");
+  uint64_t fill = interest->getName().toUri().find("/fill-");
   
 
   // node check fail seq&data
@@ -1021,6 +2089,10 @@ WqCheckpointSink::OnInterest(shared_ptr<const Interest> interest)
     std::string doubtSeq = interest->getName().toUri().substr(s1, s2-s1-1);
     std::string d_nodePathId = interest->getName().toUri().substr(p1+1, p2-p1-1);
     std::string directNeiId = d_nodePathId.substr(0,1);
+    // a node lost data of the job, issue slower until the tree recovers
+    if(m_issueMode == "window") {
+      m_issueWindow.OnCongestion();
+    };
     // std::cout << " User receive doubt seq= " << doubtSeq << " neiID= " << directNeiId << std::endl;
     std::map<std::string, std::string>::iterator findId;
     for(findId=m_nodePathId.begin(); findId!=m_nodePathId.end(); findId++)
@@ -1094,6 +2166,64 @@ WqCheckpointSink::OnInterest(shared_ptr<const Interest> interest)
     m_sendJobNeis.push_back(rejoinNode);
     ReplyData("Rejoin-Ok", interest->getName().toUri());
   }
+  // late fill of a reducer that replied partial, "/fill-/TS../TE-/(SeqK)-/from<reducer>-/v<hex value>-"
+  else if(fill != std::string::npos)
+  {
+    std::string fillName = interest->getName().toUri();
+    uint64_t s1 = fillName.find("(");
+    std::string fillSeq = fillName.substr(s1+1, fillName.find(")")-s1-1);
+    uint64_t f1 = fillName.find("/from<");
+    std::string fromReducer = fillName.substr(f1+6, fillName.find(">", f1)-f1-6);
+    uint64_t v1 = fillName.find("/v<");
+    std::string value;
+    bool decoded = WqCheckpointCodec::FromHex(fillName.substr(v1+3, fillName.find(">", v1)-v1-3), value);
+    std::cout << " User got late fill of " << fillSeq << " from " << fromReducer << ": " << value << std::endl;
+    std::map<std::string, std::map<std::string, std::string>>::iterator held = m_partialResult.find(fillSeq);
+    if(decoded && held != m_partialResult.end() && held->second.find(fromReducer) != held->second.end()) {
+      if(m_partialPolicy != "wait") {
+        // the partial value is already counted, replace this reducer's entry instead of adding the fill
+        uint64_t index = m_partialIndex[fillSeq][fromReducer];
+        std::string results = m_receiveSeqData[fillSeq];
+        std::string replaced;
+        uint64_t entry = 0;
+        uint64_t pos = 0;
+        while(pos <= results.size()) {
+          uint64_t semi = results.find(";", pos);
+          std::string each = results.substr(pos, semi-pos);
+          if(entry == index) {
+            each = value;
+          };
+          replaced += (pos == 0 ? "" : ";") + each;
+          if(semi == std::string::npos) {
+            break;
+          };
+          pos = semi+1;
+          entry += 1;
+        };
+        m_receiveSeqData[fillSeq] = replaced;
+      };
+      if(value.find("p") == std::string::npos) {
+        held->second.erase(fromReducer);
+        if(held->second.size() == 0) {
+          m_partialResult.erase(held);
+        };
+        std::map<std::string, std::map<std::string, uint64_t>>::iterator indexed = m_partialIndex.find(fillSeq);
+        if(indexed != m_partialIndex.end()) {
+          indexed->second.erase(fromReducer);
+          if(indexed->second.size() == 0) {
+            m_partialIndex.erase(indexed);
+          };
+        };
+        if(m_partialPolicy == "wait") {
+          BookSeqResult(fillSeq, value);
+        };
+      }
+      else {
+        held->second[fromReducer] = value;
+      };
+    };
+    ReplyData("fill-OK", interest->getName().toUri());
+  }
 }
 
 void
@@ -23,9 +23,13 @@
 #include "ns3/ndnSIM/model/ndn-common.hpp"
 #include "ns3/random-variable-stream.h"
 #include "ndn-app.hpp"
+#include "ndn-wq-checkpoint-coordinator.hpp"
+#include "ndn-wq-issue-window.hpp"
+#include "ndn-wq-tree-cache.hpp"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include <deque>
+#include <set>
 #include "ns3/ndnSIM/utils/ndn-rtt-estimator.hpp"
 
 namespace ns3 {
@@ -53,6 +57,9 @@ public:
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
 
+  virtual int64_t
+  AssignStreams(int64_t stream);
+
   /**
    * @brief Timeout event
    * @param sequenceNumber time outed sequence number
@@ -118,16 +125,54 @@ public:
   void CheckSeqAtReducer(std::string reducerName, std::string checkSeq);
   void ResentDataCheck(std::string resentSeq);
   void AssignJobs();
-  void PickRecoverReducer();
+  void BookSeqResult(std::string gotSeq, std::string gotResult);
+  void StartCheckpoint();
+  void ExpireCheckpoint(std::string cpID);
+  void SendCheckpointInterest(std::string cpTask);
+  void PickRecoverReducer(std::string cpID);
+  std::string ReplaceFailedReducer(std::string oneFailReducer, std::string standby, std::vector<std::string>& spareReducers);
+  void RetryUnreplaced();
+  std::string TopReducerOf(std::string reducer);
+  std::string ReplaceInnerReducer(std::string oneFailReducer, std::vector<std::string>& spareReducers);
+  void RollbackSubtree(std::string top);
+  void UpdateCheckpointNodes();
+  std::vector<std::string> GetSpareReducers();
+  void AssignStandbys();
+  void CompleteRecovery(std::string cpID);
+  void ResumeGroup(std::string reducer);
+  void DrainGroupBacklog(std::string reducer);
+  void SendTaskInterest(std::string reducer, std::string seqFlag);
+  std::vector<std::string> SplitNodeList(std::string nodeList);
+  void RebalanceGroups();
+  bool GroupDrained(std::string reducer);
+  void CheckHandoverDrained();
+  void FinishHandover();
+  void CompleteHandover();
+  void AbortHandover();
+  void SaveCheckpointRecord(std::string reducer, std::string record);
+  std::map<uint64_t, int64_t> RebuildCheckpointState(std::string reducer);
   void GetAllComputeNodes();
   void RunJobPlan();
+  void PlanJob();
+  bool PlaceByCost(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers);
+  void PlaceRandom(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers);
+  void BuildReductionTree(std::vector<std::string>& pick_reducers, std::vector<std::string>& group_mappers);
+  std::string PickPlanReducer(std::vector<std::string>& spareReducers, std::vector<std::string> children);
 
 protected:
   double m_frequency; // Frequency of interest packets (in hertz)
+  std::string m_issueMode; // "rate": one seq per 1/Frequency, "window": AIMD window of outstanding seqs
+  double m_initWindow;
+  double m_minWindow;
+  double m_maxWindow;
+  WqIssueWindow m_issueWindow;
+  uint32_t m_batchSize; // seqs carried by one task Interest
+  EventId m_windowEvent; ///< @brief re-check of a closed issue window
   bool m_firstTime;
   Ptr<RandomVariableStream> m_random;
   std::string m_randomType;
   Ptr<UniformRandomVariable> m_rand; ///< @brief nonce generator
+  Ptr<UniformRandomVariable> m_planRand; ///< @brief placement, standby and recovery picks
   uint32_t m_seq;      ///< @brief currently requested sequence number
   uint32_t m_seqMax;   ///< @brief maximum number of sequence number
   EventId m_sendEvent; ///< @brief EventId of pending "send packet" event
@@ -177,20 +222,66 @@ private:
   int m_cpEnd = 0;
   std::vector<std::string> m_existReducers;
   std::vector<std::string> m_mappers;
-  std::string m_failSeq;
-  std::map<std::string, int> m_requestCp;
-  std::map<std::string, int> m_receiveCp;
-  bool m_reScheduleJob = false;
   int m_rxCpReducerNum = 0;
   int m_txCpReducerNum = 0;
+  WqTreeCache m_censusCache; // compute-node census of the last job on this topology
   std::map<std::string, std::string> m_groupNode; // pick-reducer -- sub-mappers
   std::vector<std::string> m_nodes4CP;
-  std::map<std::string, std::string> m_cpFailMsg;
-  std::map<std::string, std::string> m_cpRecords;
-  int m_rxRollback = 0;
-  int m_txRollback = 0;
-  std::string m_rollbackID = "";
+  WqCheckpointCoordinator m_cpCoordinator;
+  uint32_t m_maxCpEpochs;
+  std::map<std::string, EventId> m_cpTimeouts; // cpID -- expiry of the epoch still collecting
+  std::string m_cpLeaderMode;
+  std::string m_stragglerMode; // none, replica or partial, carried to reducers in the task
+  Time m_deadline;
+  std::string m_partialPolicy;
+  std::map<std::string, std::map<std::string, std::string>> m_partialResult; // seq -- (reducer, partial result)
+  std::map<std::string, std::map<std::string, uint64_t>> m_partialIndex; // seq -- (reducer, its entry in m_receiveSeqData)
+  std::string m_placement;
+  uint32_t m_reducerNum;
+  double m_hopWeight;
+  double m_sinkWeight;
+  double m_balanceWeight;
+  std::map<std::string, std::vector<uint32_t>> m_hopCost; // reducer -- FIB cost to each mapper, sink last
+  int m_txCostNum = 0;
+  EventId m_planEvent;
+  uint32_t m_maxFanIn;
+  uint32_t m_treeLevels;
+  std::vector<std::string> m_innerReducers; // reducers below the top level of the reduction tree
+  std::map<std::string, std::string> m_planParent; // inner reducer -- its parent reducer
+  std::map<std::string, std::string> m_planChildren; // inner reducer -- its children
+  std::set<std::string> m_replanInner; // replacements of inner reducers not planned yet
+  std::map<std::string, std::string> m_rollbackTop; // reducer -- top reducer of the subtree it rolls back with
+  std::map<std::string, int> m_subtreeRollbacks; // top reducer -- rollbacks of its subtree not acked yet
+  int m_planAcks = 0;
+  bool m_rebalance;
+  double m_rebalanceRatio;
+  uint32_t m_rebalanceStep;
+  std::map<std::string, Time> m_taskSentTime; // reducer+seq -- time the task was sent
+  std::map<std::string, double> m_groupLatency; // reducer -- EWMA of seq completion latency (s)
+  std::string m_handoverPhase; // "", drain, swap (release/adopt sent) or newUp (mappers told)
+  int m_handoverAcks = 0;
+  std::string m_handoverFrom;
+  std::string m_handoverTo;
+  std::string m_handoverMoved;
+  std::string m_handoverFromGroup; // groups before the handover, restored on abort
+  std::string m_handoverToGroup;
+  std::string m_handoverNewFromGroup;
+  std::vector<std::string> m_handoverMappers;
+  Time m_handoverTimeout;
+  EventId m_handoverEvent;
   std::vector<std::string> m_preFailReducer;
+  std::vector<std::string> m_unreplacedReducers; // failed reducers waiting for a spare
+  Time m_spareRetryInterval;
+  EventId m_spareRetryEvent;
+  double m_catchUpRate;
+  std::set<std::string> m_pausedGroups; // reducers under recovery
+  std::map<std::string, std::deque<std::string>> m_groupBacklog; // reducer -- seqs waiting for it
+  std::map<std::string, EventId> m_drainEvent;
+  bool m_hotStandby;
+  std::map<std::string, std::string> m_standbyNode; // active-reducer -- warm standby-reducer
+  std::map<std::string, std::string> m_promoteFrom; // promoted standby -- failed reducer
+  std::map<std::string, std::set<std::string>> m_groupRxSeqs; // reducer -- seqs received from its group
+  std::map<std::string, std::vector<std::string>> m_cpChain; // reducer -- checkpoint records since its last full one
 
     /// @cond include_hidden
   /**
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-heartbeat.hpp"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace ndn {
+
+static const uint64_t WINDOW = 100;
+
+WqHeartbeatDetector::WqHeartbeatDetector()
+  : m_interval(Seconds(1))
+{
+}
+
+void
+WqHeartbeatDetector::SetInterval(Time interval)
+{
+  m_interval = interval;
+}
+
+void
+WqHeartbeatDetector::Heard(const std::string& peer)
+{
+  Time now = Simulator::Now();
+  std::map<std::string, History>::iterator it = m_peers.find(peer);
+  if (it == m_peers.end()) {
+    History history;
+    history.last = now;
+    history.sum = 0;
+    history.sumSq = 0;
+    m_peers[peer] = history;
+    return;
+  }
+  History& history = it->second;
+  double gap = (now - history.last).GetSeconds();
+  history.last = now;
+  history.gaps.push_back(gap);
+  history.sum += gap;
+  history.sumSq += gap * gap;
+  if (history.gaps.size() > WINDOW) {
+    double old = history.gaps.front();
+    history.gaps.pop_front();
+    history.sum -= old;
+    history.sumSq -= old * old;
+  }
+}
+
+double
+WqHeartbeatDetector::Phi(const std::string& peer) const
+{
+  std::map<std::string, History>::const_iterator it = m_peers.find(peer);
+  if (it == m_peers.end()) {
+    return 0;
+  }
+  const History& history = it->second;
+  double interval = m_interval.GetSeconds();
+  double mean = interval;
+  double stdDev = interval / 4;
+  if (history.gaps.size() >= 2) {
+    double n = history.gaps.size();
+    mean = history.sum / n;
+    stdDev = std::sqrt(std::max(0.0, history.sumSq / n - mean * mean));
+  }
+  // bursty traffic has near-zero variance, keep a floor so one quiet beacon period is not a crash;
+  // a silent link is also probed every interval, so the mean cannot exceed it by much
+  stdDev = std::max(stdDev, interval / 4);
+  mean = std::min(mean, interval);
+
+  double silence = (Simulator::Now() - history.last).GetSeconds();
+  // logistic approximation of the normal CDF, as in the usual phi-accrual detectors
+  double y = (silence - mean) / stdDev;
+  double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+  if (silence > mean) {
+    return -std::log10(e / (1.0 + e));
+  }
+  return -std::log10(1.0 - 1.0 / (1.0 + e));
+}
+
+Time
+WqHeartbeatDetector::Silence(const std::string& peer) const
+{
+  std::map<std::string, History>::const_iterator it = m_peers.find(peer);
+  if (it == m_peers.end()) {
+    return Time::Max();
+  }
+  return Simulator::Now() - it->second.last;
+}
+
+void
+WqHeartbeatDetector::Forget(const std::string& peer)
+{
+  m_peers.erase(peer);
+}
+
+std::vector<std::string>
+WqHeartbeatDetector::GetPeers() const
+{
+  std::vector<std::string> peers;
+  for (std::map<std::string, History>::const_iterator it = m_peers.begin(); it != m_peers.end(); ++it) {
+    peers.push_back(it->first);
+  }
+  return peers;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_HEARTBEAT_H
+#define NDN_WQ_HEARTBEAT_H
+
+#include "ns3/nstime.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Phi-accrual failure detector over the tree neighbours of a node
+ *
+ * Every packet from a neighbour counts as a heartbeat. The gaps between them are kept
+ * in a sliding window and phi = -log10(P(gap >= now - last)) under a normal fit of that
+ * window, so the suspicion level follows the traffic pattern of each neighbour instead of
+ * one global timeout. A neighbour with fewer than two gaps is judged against the beacon
+ * interval.
+ */
+class WqHeartbeatDetector {
+public:
+  WqHeartbeatDetector();
+
+  /**
+   * @brief Beacon interval of the node, the first estimate of the gap to a new neighbour
+   */
+  void
+  SetInterval(Time interval);
+
+  void
+  Heard(const std::string& peer);
+
+  /**
+   * @brief Suspicion level of @p peer now, 0 when it was never heard
+   */
+  double
+  Phi(const std::string& peer) const;
+
+  /**
+   * @brief Time since @p peer was last heard, Time::Max() when never
+   */
+  Time
+  Silence(const std::string& peer) const;
+
+  void
+  Forget(const std::string& peer);
+
+  std::vector<std::string>
+  GetPeers() const;
+
+private:
+  struct History
+  {
+    Time last;
+    std::deque<double> gaps; // seconds
+    double sum;
+    double sumSq;
+  };
+
+  std::map<std::string, History> m_peers;
+  Time m_interval;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-issue-window.hpp"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+WqIssueWindow::WqIssueWindow()
+  : m_window(2)
+  , m_minWindow(1)
+  , m_maxWindow(64)
+  , m_lastDecrease(Seconds(0))
+{
+}
+
+void
+WqIssueWindow::SetRttEstimator(Ptr<RttEstimator> rtt)
+{
+  m_rtt = rtt;
+}
+
+void
+WqIssueWindow::SetLimits(double initial, double minWindow, double maxWindow)
+{
+  m_minWindow = std::max(1.0, minWindow);
+  m_maxWindow = std::max(m_minWindow, maxWindow);
+  m_window = std::min(m_maxWindow, std::max(m_minWindow, initial));
+}
+
+bool
+WqIssueWindow::CanIssue() const
+{
+  return m_outstanding.size() < (uint64_t)m_window;
+}
+
+void
+WqIssueWindow::OnIssue(uint32_t seq)
+{
+  m_outstanding[seq] = Simulator::Now();
+  m_rtt->SentSeq(SequenceNumber32(seq), 1);
+}
+
+bool
+WqIssueWindow::OnComplete(uint32_t seq)
+{
+  std::map<uint32_t, Time>::iterator it = m_outstanding.find(seq);
+  if (it == m_outstanding.end()) {
+    return false;
+  }
+  Time latency = Simulator::Now() - it->second;
+  m_outstanding.erase(it);
+
+  // compare with the timeout from before this sample, a slow seq must not raise its own bar
+  Time rto = m_rtt->RetransmitTimeout();
+  m_rtt->AckSeq(SequenceNumber32(seq));
+  if (latency > rto) {
+    Decrease();
+  }
+  else {
+    m_rtt->ResetMultiplier();
+    m_window = std::min(m_maxWindow, m_window + 1.0 / m_window);
+  }
+  return true;
+}
+
+void
+WqIssueWindow::OnCongestion()
+{
+  Decrease();
+}
+
+uint32_t
+WqIssueWindow::ExpireTimeouts()
+{
+  Time rto = m_rtt->RetransmitTimeout();
+  uint32_t expired = 0;
+  std::map<uint32_t, Time>::iterator it = m_outstanding.begin();
+  while (it != m_outstanding.end()) {
+    if (Simulator::Now() - it->second > rto) {
+      m_outstanding.erase(it++);
+      expired++;
+    }
+    else {
+      it++;
+    }
+  }
+  if (expired != 0) {
+    m_rtt->IncreaseMultiplier();
+    Decrease();
+  }
+  return expired;
+}
+
+Time
+WqIssueWindow::GetPacing() const
+{
+  return Seconds(m_rtt->GetCurrentEstimate().GetSeconds() / m_window);
+}
+
+double
+WqIssueWindow::GetWindow() const
+{
+  return m_window;
+}
+
+uint32_t
+WqIssueWindow::GetOutstanding() const
+{
+  return m_outstanding.size();
+}
+
+void
+WqIssueWindow::Decrease()
+{
+  // one decrease per latency, a burst of signals from the same episode counts once
+  if (m_lastDecrease != Seconds(0) && Simulator::Now() - m_lastDecrease < m_rtt->GetCurrentEstimate()) {
+    return;
+  }
+  m_lastDecrease = Simulator::Now();
+  m_window = std::max(m_minWindow, m_window / 2);
+}
+
+} // namespace ndn
+} // namespace ns3
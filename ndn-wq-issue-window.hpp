@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_ISSUE_WINDOW_H
+#define NDN_WQ_ISSUE_WINDOW_H
+
+#include "ns3/ndnSIM/utils/ndn-rtt-estimator.hpp"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include <map>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief AIMD window on the number of outstanding seqs of a job
+ *
+ * A seq is outstanding from its issue until all its results are back. Each completion
+ * within the retransmission timeout of the RTT estimator grows the window by 1/window,
+ * a slow completion, a seq outstanding past the timeout or a doubt report from the tree
+ * halves it, at most once per smoothed completion latency.
+ */
+class WqIssueWindow {
+public:
+  WqIssueWindow();
+
+  void
+  SetRttEstimator(Ptr<RttEstimator> rtt);
+
+  void
+  SetLimits(double initial, double minWindow, double maxWindow);
+
+  bool
+  CanIssue() const;
+
+  void
+  OnIssue(uint32_t seq);
+
+  /**
+   * @returns false if the seq was not outstanding (already expired or never issued)
+   */
+  bool
+  OnComplete(uint32_t seq);
+
+  void
+  OnCongestion();
+
+  /**
+   * @brief Stop counting seqs outstanding past the timeout, they halve the window once
+   * @returns number of expired seqs
+   */
+  uint32_t
+  ExpireTimeouts();
+
+  /**
+   * @brief Gap between two issues that spreads one window over one completion latency
+   */
+  Time
+  GetPacing() const;
+
+  double
+  GetWindow() const;
+
+  uint32_t
+  GetOutstanding() const;
+
+private:
+  void
+  Decrease();
+
+private:
+  Ptr<RttEstimator> m_rtt;
+  double m_window;
+  double m_minWindow;
+  double m_maxWindow;
+  std::map<uint32_t, Time> m_outstanding; // seq -- issue time
+  Time m_lastDecrease;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
@@ -81,9 +81,18 @@ WqMapper::GetTypeId(void)
 WqMapper::WqMapper()
 {
   m_rand = CreateObject<UniformRandomVariable>();
+  m_valueRand = CreateObject<UniformRandomVariable>();
   NS_LOG_FUNCTION_NOARGS();
 }
 
+int64_t
+WqMapper::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  m_valueRand->SetStream(stream + 1);
+  return 2;
+}
+
 // inherited from Application base class.
 void
 WqMapper::StartApplication()
@@ -99,6 +108,8 @@ WqMapper::StopApplication()
 {
   NS_LOG_FUNCTION_NOARGS();
 
+  Simulator::Cancel(m_heartbeatEvent);
+  Simulator::Cancel(m_rejoinEvent);
   App::StopApplication();
 }
 
@@ -112,7 +123,7 @@ WqMapper::SendInterest(std::string sendName)
   shared_ptr<Interest> mapTaskInterest = make_shared<Interest>();
   mapTaskInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   mapTaskInterest->setName(*mapTaskName);
-  mapTaskInterest->setInterestLifetime(ndn::time::seconds(1));
+  mapTaskInterest->setInterestLifetime(GetClassLifetime(sendName));
   m_transmittedInterests(mapTaskInterest, this, m_face);
   m_appLink->onReceiveInterest(*mapTaskInterest);
 };
@@ -128,84 +139,6 @@ WqMapper::CheckNeiConnect()
   // std::cout << "OnData check nei size: " << m_checkNeibMap.size() << std::endl;
 };
 
-void 
-WqMapper::LinkBroken(std::string upNode, std::string downNode)
-{
-  if(upNode == "/6-" && downNode == "/m3-")
-  {
-    std::string changeLink = "/m3-/6-/0-";
-    if (excuteR2M3Fail == false) {
-      std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-      if (l != m_neiReachable.end()) {
-        l->second = "false";
-        CheckNeiConnect();  // maybe not using this function anymore?
-      };
-      excuteR2M3Fail = true;
-    };
-  }
-  else if(upNode == "/2-" && downNode == "/m3-")
-  {
-    std::string changeLink = "/m3-/2-/0-";
-    if (excuteR2M6Fail == false) {
-      std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-      if (l != m_neiReachable.end()) {
-        l->second = "false";
-        CheckNeiConnect();
-      };
-      excuteR2M6Fail = true;
-    };
-  }
-  else if(upNode == "/1-" && downNode == "/m6-")
-  {
-    std::string changeLink = "/m6-/1-/0-";
-    if (excuteR1M7Fail == false) {
-      std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-      if (l != m_neiReachable.end()) {
-        l->second = "false";
-        CheckNeiConnect();
-      };
-      excuteR1M7Fail = true;
-    };
-  }
-  else if(upNode == "/1-" && downNode == "/82-")
-  {
-    std::string changeLink = "/82-/1-/0-";
-    std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-    if (l != m_neiReachable.end()) {
-      l->second = "false";
-      CheckNeiConnect();
-    };
-  }
-  else if(upNode == "/26-" && downNode == "/35-")
-  {
-    std::string changeLink = "/35-/26-/0-";
-    std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-    if (l != m_neiReachable.end()) {
-      l->second = "false";
-      CheckNeiConnect();
-    };
-  }
-  else if(upNode == "/22-" && downNode == "/98-")
-  {
-    std::string changeLink = "/98-/22-/0-";
-    std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-    if (l != m_neiReachable.end()) {
-      l->second = "false";
-      CheckNeiConnect();
-    };
-  };
-};
-
-void 
-WqMapper::RegularCheckLink() 
-{
-  std::string onlyLink = m_neiReachable.begin()->first;
-  uint64_t l = onlyLink.find_last_of("/");
-  std::string treeId = onlyLink.substr(l);
-  std::string checkInterest = m_selectNodeName + "/rejoin-" + m_prefix.toUri() + "/TS" + treeId + "/TE-";
-  std::cout<< m_prefix.toUri() << "  regular-check= " << checkInterest << std::endl;
-};
-
 void
 WqMapper::AddSeqData(std::string seqnum, int seqdata)
 {
@@ -312,6 +245,18 @@ WqMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
   std::string checkNeiLink= m_prefix.toUri() + m_selectNodeName + m_currentTreeTag;
   // std::cout<< m_prefix.toUri() << " checkNeiLink: " << checkNeiLink << std::endl;
   std::string interestName = interest->getName().toUri();
+  // lazy relabel: the upstream label carried by the task tells us if a rejoin above moved us
+  std::string upLabel = WqPathLabel::FromName(interestName);
+  if(!upLabel.empty() && upLabel != WqPathLabel::Parent(m_myPathID))
+  {
+    std::string newId = WqPathLabel::Rebase(m_myPathID, upLabel);
+    if(!newId.empty())
+    {
+      m_prePathID = m_myPathID;
+      m_myPathID = newId;
+      std::cout << m_prefix.toUri() <<" relabel to PathId= " << m_myPathID << std::endl;
+    }
+  }
   uint64_t u1 = interestName.find("(");
   uint64_t u2 = interestName.find(")");
   std::string seqNum = interestName.substr(u1+1, u2-u1-1);
@@ -319,7 +264,7 @@ WqMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
   std::map<std::string, std::string>::iterator linkIter = m_neiReachable.find(checkNeiLink);
   if(linkIter != m_neiReachable.end())
   {
-    int rawNum = std::rand() % 100 + 10;
+    int rawNum = m_valueRand->GetInteger(10, 109);
     std::string rawData = std::to_string(rawNum);
     rawData = seqNum + "-" + rawData;
     // std::string s = "Seq" + seqNum;
@@ -342,37 +287,7 @@ WqMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
       AddSeqData(seqNum, rawNum);
       if (reJoinAsk == false) 
       {
-        //to make sure the node has other possible up-neis
-        if(m_neiReachable.size() != 1)
-        {
-          std::map<std::string, std::string>::iterator findLink;
-          for(findLink=m_neiReachable.begin(); findLink != m_neiReachable.end(); ++findLink) 
-          {
-            if(findLink->first != checkNeiLink) {
-              uint64_t t = findLink->first.find_last_of("/");
-              std::string treeId= findLink->first.substr(t);
-              if(treeId == m_currentTreeTag) {
-                // std::cout<< m_prefix.toUri() << " potential nei to current user: " << findLink->first << std::endl;
-                uint64_t s1 = findLink->first.find("-");
-                uint64_t s2 = findLink->first.find_last_of("/");
-                std::string rejoinUpNeiName = findLink->first.substr(s1+1, s2-s1-1);
-                std::string changeNeiInterest = rejoinUpNeiName + "/rejoin-" + m_prefix.toUri() + "/TS" + m_currentTreeTag + "/TE-";
-                std::cout<< m_prefix.toUri() << " changeUpNeiInterest: " << changeNeiInterest << std::endl;
-                SendInterest(changeNeiInterest);
-                reJoinAsk = true;
-                m_sendRejoinNum++;
-                m_possibleRejoinNeis.insert(std::pair<std::string, std::string>(rejoinUpNeiName,"0"));
-              };
-            };
-          };
-        }
-        else {
-          std::cout<< m_prefix.toUri() << " has NO other routes... " << std::endl;
-          // if(seqNum == "Seq45") {
-          //   RegularCheckLink();
-          // };
-          // Simulator::Schedule(Seconds(0.2), &WqMapper::RegularCheckLink, this);
-        };  
+        RejoinOtherUpstream();
       }
       else if (reJoinAsk == true) 
       {
@@ -387,6 +302,118 @@ WqMapper::ProcessNormalInterest(shared_ptr<const Interest> interest)
   };
 };
 
+void
+WqMapper::RejoinOtherUpstream()
+{
+  //one rejoin to the best backup parent, the next one is only asked if it refuses
+  if(!AskNextBackupParent())
+  {
+    std::cout<< m_prefix.toUri() << " has NO other routes... " << std::endl;
+    reJoinAsk = false;
+  };
+};
+
+bool
+WqMapper::AskNextBackupParent()
+{
+  std::vector<std::string> ranked = m_backupParents.Get(m_currentTreeTag);
+  for(uint64_t i=0; i<ranked.size(); i++)
+  {
+    // checked lazily: a candidate whose link is down is skipped, not dropped
+    if(ranked[i] == m_selectNodeName || !IsNeighbourUp(ranked[i])) {
+      continue;
+    };
+    std::string changeNeiInterest = ranked[i] + "/rejoin-" + m_prefix.toUri() + "/TS" + m_currentTreeTag + "/TE-";
+    std::cout<< m_prefix.toUri() << " changeUpNeiInterest: " << changeNeiInterest << std::endl;
+    m_rejoinCandidate = ranked[i];
+    reJoinAsk = true;
+    SendInterest(changeNeiInterest);
+    //no answer within the Interest lifetime counts as a refusal
+    Simulator::Cancel(m_rejoinEvent);
+    m_rejoinEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(changeNeiInterest).count()),
+                                        &WqMapper::RejoinCandidateFailed, this);
+    return true;
+  };
+  return false;
+};
+
+void
+WqMapper::RejoinCandidateFailed()
+{
+  std::cout << m_prefix.toUri() <<" rejoin-Fail link= " << m_rejoinCandidate << std::endl;
+  Simulator::Cancel(m_rejoinEvent);
+  m_backupParents.Remove(m_currentTreeTag, m_rejoinCandidate);
+  m_rejoinCandidate = "";
+  RejoinOtherUpstream();
+};
+
+void
+WqMapper::OnNeighbourLinkChange(const std::string& name, bool up)
+{
+  if(!up) {
+    HandleLostNeighbour(name);
+  };
+};
+
+void
+WqMapper::HandleLostNeighbour(const std::string& name)
+{
+  // every link of ours through that neighbour is gone
+  std::string linkPrefix = m_prefix.toUri() + name;
+  std::map<std::string, std::string>::iterator l;
+  for(l=m_neiReachable.begin(); l != m_neiReachable.end(); ++l) {
+    if(l->first.compare(0, linkPrefix.size(), linkPrefix) == 0) {
+      l->second = "false";
+    };
+  };
+  m_heartbeat.Forget(name);
+  CheckNeiConnect();
+  // upstream lost: rejoin now rather than on the next task, which could not arrive anyway
+  if(name == m_selectNodeName && reJoinAsk == false) {
+    m_detectLinkFailure = true;
+    RejoinOtherUpstream();
+  };
+};
+
+void
+WqMapper::HeardFrom(const std::string& peer)
+{
+  std::map<std::string, std::string>::iterator l = m_neiReachable.find(m_prefix.toUri() + peer + m_currentTreeTag);
+  if(m_heartbeatInterval.IsZero() || peer != m_selectNodeName || l == m_neiReachable.end() || l->second != "true") {
+    return;
+  };
+  m_heartbeat.Heard(peer);
+  if(!m_heartbeatEvent.IsRunning()) {
+    m_heartbeat.SetInterval(m_heartbeatInterval);
+    m_heartbeatEvent = Simulator::Schedule(m_heartbeatInterval, &WqMapper::HeartbeatTick, this);
+  };
+};
+
+void
+WqMapper::HeartbeatTick()
+{
+  std::map<std::string, std::string>::iterator l = m_neiReachable.find(m_prefix.toUri() + m_selectNodeName + m_currentTreeTag);
+  std::vector<std::string> peers = m_heartbeat.GetPeers();
+  if(peers.size() == 0 || peers[0] != m_selectNodeName || l == m_neiReachable.end() || l->second != "true") {
+    // upstream changed or lost, the next task from the new one arms the timer again
+    for(uint64_t i=0; i<peers.size(); i++) {
+      m_heartbeat.Forget(peers[i]);
+    };
+    return;
+  };
+  double phi = m_heartbeat.Phi(m_selectNodeName);
+  if(phi > m_phiThreshold) {
+    // link still up but nothing from the app: crashed or hung
+    std::cout << m_prefix.toUri() << " suspect " << m_selectNodeName << " phi= " << phi << std::endl;
+    HandleLostNeighbour(m_selectNodeName);
+    return;
+  };
+  if(m_heartbeat.Silence(m_selectNodeName) >= m_heartbeatInterval) {
+    SendInterest(m_selectNodeName + "/hb-" + m_prefix.toUri());
+  };
+  m_heartbeatEvent = Simulator::Schedule(m_heartbeatInterval, &WqMapper::HeartbeatTick, this);
+};
+
 void 
 WqMapper::ClearHistorySaveData(std::string seqList)
 {
@@ -449,27 +476,41 @@ WqMapper::OnInterest(shared_ptr<const Interest> interest)
     uint64_t sp1 = m_pendingInterestName.toUri().find("rejoin");
     uint64_t p = m_pendingInterestName.toUri().find("pathID");
     uint64_t d = m_pendingInterestName.toUri().find("doubt");
-    uint64_t u = m_pendingInterestName.toUri().find("update");
     uint64_t fClear = m_pendingInterestName.toUri().find("clear");
+    uint64_t warm = m_pendingInterestName.toUri().find("/warm(");
+    uint64_t hb = m_pendingInterestName.toUri().find("/hb-");
   
     //interest for discover tree
     if (sp != std::string::npos) 
     {
-      //std::cout <<m_prefix.toUri() <<"000 m_askPitNum: "<< m_askPitNum <<std::endl;
       std::cout <<m_prefix.toUri() << " got disTree Interest: "<< m_pendingInterestName.toUri()<< std::endl;
-      m_askPitPrefix = "/p-";
-      m_disTreeInterestMap.insert(std::pair<std::string, std::string>(m_pendingInterestName.toUri(),"0"));
-      
       uint64_t t1 = m_pendingInterestName.toUri().find("TS");
       uint64_t t2 = m_pendingInterestName.toUri().find("TE");
       m_currentTreeTag = m_pendingInterestName.toUri().substr(t1+2, t2-t1-3);
       //std::cout <<"tree tag: "<< m_currentTreeTag <<std::endl;
-  
-      std::string tempAskPit = m_askPitPrefix + m_pendingInterestName.toUri();
-      SendInterest(tempAskPit);
-      //std::cout <<"tempAskPit: "<< tempAskPit <<std::endl;
-      m_askPitNum++;
-      //std::cout <<m_prefix.toUri() <<"111 m_askPitNum: "<< m_askPitNum <<std::endl;
+
+      // decided locally instead of "/p-" and "/f-" rounds: only the neighbour on the FIB
+      // next hop towards the tree root is the upstream
+      uint64_t p1 = m_pendingInterestName.toUri().find_first_of("-");
+      uint64_t p2 = m_pendingInterestName.toUri().find("/discover");
+      std::string upstreamNei = m_pendingInterestName.toUri().substr(p1+1, p2-p1-1);
+      std::string taskNei =  m_prefix.toUri() + upstreamNei + m_currentTreeTag;
+      uint64_t parentFace = 0;
+      if (upstreamNei != GetTreeParent(m_currentTreeTag, parentFace))
+      {
+        //current not-selected upstream nei, save as potential neis if current select nei is disconnect
+        m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "false"));
+        m_backupParents.Offer(m_currentTreeTag, upstreamNei, GetRouteCostVia(m_currentTreeTag, upstreamNei));
+        ReplyData("nope", interest);
+      }
+      else
+      {
+        //current selected upstream nei
+        m_selectNodeName = upstreamNei;
+        m_selectNodeFace = std::to_string(parentFace);
+        m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "true"));
+        ReplyData("yes", interest);
+      }
     }
     else if (sp1 != std::string::npos)
     {
@@ -507,17 +548,47 @@ WqMapper::OnInterest(shared_ptr<const Interest> interest)
       std::cout << m_prefix.toUri() << " receive pathID = " << m_myPathID << std::endl;
       std::string ack = "PathID OK";
       ReplyData(ack, interest);
+
+      // keep our place on this tree for the next job on the same topology
+      m_treeCache.SetPath(m_treeCacheDir, m_prefix.toUri(), m_currentTreeTag);
+      if(m_treeCache.IsEnabled())
+      {
+        m_treeCache.Clear();
+        m_treeCache.Set("parent", m_selectNodeName);
+        m_treeCache.Set("face", m_selectNodeFace);
+        m_treeCache.Set("pathId", m_myPathID);
+        m_treeCache.Save(GetTopologyFingerprint(m_currentTreeTag));
+      }
     }
-    // update path-id from upstream
-    else if(u != std::string::npos)
+    // sink confirms the cached tree instead of discovering it again
+    else if (warm != std::string::npos)
     {
-      m_prePathID = m_myPathID;
-      uint64_t s1 = m_pendingInterestName.toUri().find("(");
-      uint64_t s2 = m_pendingInterestName.toUri().find(")");
-      m_myPathID = m_pendingInterestName.toUri().substr(s1+1, s2-s1-1);
-      std::cout << m_prefix.toUri() <<" receive update-PathId= " << m_myPathID << std::endl;
-      std::string ack = "Update-PathID OK";
-      ReplyData(ack, interest);
+      std::string warmName = m_pendingInterestName.toUri();
+      uint64_t t1 = warmName.find("TS");
+      uint64_t t2 = warmName.find("TE");
+      std::string treeId = warmName.substr(t1+2, t2-t1-3);
+      uint64_t s1 = warmName.find("/warm(");
+      uint64_t s2 = warmName.find(")", s1);
+      uint64_t f1 = warmName.find("/from<");
+      uint64_t f2 = warmName.find(">", f1);
+      std::string pathId = warmName.substr(s1+6, s2-s1-6);
+      std::string from = warmName.substr(f1+6, f2-f1-6);
+      m_treeCache.SetPath(m_treeCacheDir, m_prefix.toUri(), treeId);
+      if (m_treeCache.Load(GetTopologyFingerprint(treeId)) && m_treeCache.Get("parent") == from
+          && m_treeCache.Get("pathId") == pathId)
+      {
+        m_currentTreeTag = treeId;
+        m_selectNodeName = from;
+        m_selectNodeFace = m_treeCache.Get("face");
+        m_myPathID = pathId;
+        m_neiReachable[m_prefix.toUri() + from + treeId] = "true";
+        ReplyData("yes", interest);
+      }
+      else
+      {
+        std::cout << m_prefix.toUri() << " refuse warm start: " << warmName << std::endl;
+        ReplyData("nope", interest);
+      }
     }
     else if (d != std::string::npos)
     {
@@ -534,26 +605,23 @@ WqMapper::OnInterest(shared_ptr<const Interest> interest)
       ClearHistorySaveData(seqs);
       ReplyData("Clear-Done", interest);
     }
+    // beacon of a downstream neighbour, mappers have none on the tree but answer anyway
+    else if (hb != std::string::npos)
+    {
+      ReplyData("alive", interest);
+    }
     // normal interst
     else 
     {
-      // Simulator::Schedule(Seconds(12), &WqMapper::LinkBroken, this, "/8-", "/m3-");
-      // Simulator::Schedule(Seconds(62), &WqMapper::LinkBroken, this, "/9-", "/m4-");
-      // Simulator::Schedule(Seconds(82), &WqMapper::LinkBroken, this, "/7-", "/m2-");
-      // Simulator::Schedule(Seconds(32), &WqMapper::LinkBroken, this, "/2-", "/m3-");
-      // Simulator::Schedule(Seconds(62), &WqMapper::LinkBroken, this, "/3-", "/m4-");
-      // Simulator::Schedule(Seconds(82), &WqMapper::LinkBroken, this, "/1-", "/m2-");
-      // Simulator::Schedule(Seconds(32), &WqMapper::LinkBroken, this, "/6-", "/m3-");
-      // Simulator::Schedule(Seconds(82), &WqMapper::LinkBroken, this, "/1-", "/m6-");
-      // Simulator::Schedule(Seconds(9), &WqMapper::LinkBroken, this, "/1-", "/82-");
-      // Simulator::Schedule(Seconds(29), &WqMapper::LinkBroken, this, "/26-", "/35-");
-      // Simulator::Schedule(Seconds(69), &WqMapper::LinkBroken, this, "/22-", "/98-");
-      // m_sendEvent = Simulator::Schedule(Seconds(2), &WqMapper::LinkBroken, this);
-      // Simulator::Remove(m_sendEvent);
       std::cout << m_prefix.toUri() <<" get normal Interest: " << m_pendingInterestName.toUri() <<std::endl;
+      HeardFrom(m_selectNodeName);
       m_normalInterest = interest;
-      std::string requestPit = "/p-" + m_pendingInterestName.toUri();
-      SendInterest(requestPit);
+      // only process Interest from selected Up-nei Face, ignore same Interest from other neis
+      std::vector<uint64_t> inFaces = GetPitInFaces(std::vector<shared_ptr<const Interest>>(1, interest));
+      if (std::to_string(inFaces[0]) == m_selectNodeFace)
+      {
+        ProcessNormalInterest(m_normalInterest);
+      }
     }
 }
 
@@ -576,7 +644,8 @@ WqMapper::OnData(shared_ptr<const Data> data)
     uint64_t r = gotDataName.find("rejoin");
     uint64_t d = gotDataName.find("doubt");
     uint64_t rs = gotDataName.find("resend");
-    
+    // any Data the upstream answers with is a heartbeat from it
+    HeardFrom(gotDataName.substr(0, gotDataName.find_first_of("-")+1));
 
     //data for rejoin-tree Interest
     if((r != std::string::npos) & (gotDataName[1] != 'f')) 
@@ -585,90 +654,42 @@ WqMapper::OnData(shared_ptr<const Data> data)
       std::string uriData = data->getName().toUri();
       uint64_t fu = uriData.find_first_of("-");
       std::string rejoinNeiNode = uriData.substr(0,fu+1);
-      m_gotRejoinNum++;
-      std::map<std::string, std::string>::iterator rejoinIter;
-      for(rejoinIter =m_possibleRejoinNeis.begin(); rejoinIter!=m_possibleRejoinNeis.end(); ++rejoinIter)
+      if(rejoinNeiNode != m_rejoinCandidate)
       {
-        //std::cout << m_prefix.toUri() << "iterator first " << disDownIt->first << std::endl;
-        if(rejoinIter->first == rejoinNeiNode)
-        {
-          rejoinIter->second = receivedData;
-        }
-      };
-
-      if(m_gotRejoinNum == m_sendRejoinNum)
+        //late answer of a candidate we gave up on, do not leave it holding a place for us
+        std::cout << m_prefix.toUri() <<" stale rejoin reply from " << rejoinNeiNode << std::endl;
+        if(receivedData.find("Join-Success") != std::string::npos) {
+          std::string cancelReply = rejoinNeiNode + "/CancelJoin(" + m_prefix.toUri() + ")-";
+          SendInterest(cancelReply);
+        };
+      }
+      else if(receivedData.find("Join-Success") == std::string::npos)
+      {
+        RejoinCandidateFailed();
+      }
+      else
       {
+        Simulator::Cancel(m_rejoinEvent);
+        m_rejoinCandidate = "";
         reJoinAsk = false;
-        std::vector<std::string> possibleRejoinNeis;
-        for(rejoinIter =m_possibleRejoinNeis.begin(); rejoinIter!=m_possibleRejoinNeis.end(); ++rejoinIter)
-        {
-          uint64_t j = rejoinIter->second.find("Join-Success");
-          if(j != std::string::npos) 
-          {
-            std::cout << m_prefix.toUri() <<" rejoin-Success link= " << rejoinIter->first << std::endl;
-            possibleRejoinNeis.push_back(rejoinIter->first);
-          }
-          else
-          {
-            std::cout << m_prefix.toUri() <<" rejoin-Fail " << std::endl;
-          };
+        std::string rejoinLink = m_prefix.toUri() + rejoinNeiNode + m_currentTreeTag;
+        std::cout << m_prefix.toUri() <<" FIND rejoin link= " << rejoinLink << std::endl;
+        m_neiReachable[rejoinLink] = "true";
+        //the new upstream is no longer a backup of ours
+        m_backupParents.Remove(m_currentTreeTag, rejoinNeiNode);
+
+        m_prePathID = m_myPathID;
+        m_preUpNeiName = m_selectNodeName;
+        m_selectNodeName = rejoinNeiNode;
+        uint64_t p1 = receivedData.find("(");
+        uint64_t p2 = receivedData.find(")");
+        m_myPathID = receivedData.substr(p1+1, p2-p1-1);
+        std::cout << m_prefix.toUri() <<" ----- REJOIN Id----  " << m_myPathID << std::endl;
+
+        m_selectNodeFace = std::to_string(GetFibFace(m_selectNodeName));
+        if (m_detectFailureSeqData.size() != 0) {
+          CheckFailSeq();
         };
-        
-        if(possibleRejoinNeis.size() != 0) 
-        {
-          //if multiple neis available to rejoin current tree, choose only one and save others for future use
-          std::string rejoinLink = m_prefix.toUri() + possibleRejoinNeis[0] + m_currentTreeTag;
-          std::cout << m_prefix.toUri() <<" FIND rejoin link= " << rejoinLink << std::endl;
-          std::map<std::string, std::string>::iterator findLink;
-          findLink = m_neiReachable.find(rejoinLink);
-          if(findLink != m_neiReachable.end()) 
-          {
-            findLink->second = "true";
-          }
-          else {
-            m_neiReachable.insert(std::pair<std::string, std::string>(rejoinLink, "true"));
-          };
-
-          m_prePathID = m_myPathID;
-          m_preUpNeiName = m_selectNodeName;
-          m_selectNodeName = possibleRejoinNeis[0];
-          uint64_t p1 = m_possibleRejoinNeis[m_selectNodeName].find("(");
-          uint64_t p2 = m_possibleRejoinNeis[m_selectNodeName].find(")");
-          m_myPathID = m_possibleRejoinNeis[m_selectNodeName].substr(p1+1, p2-p1-1);
-          std::cout << m_prefix.toUri() <<" ----- REJOIN Id----  " << m_myPathID << std::endl;
-
-          if (possibleRejoinNeis.size() > 1) 
-          {
-            for (uint64_t i=1; i<possibleRejoinNeis.size(); i++) 
-            {
-              std::string secondRejoinLink = m_prefix.toUri() + possibleRejoinNeis[i] + m_currentTreeTag;
-              findLink = m_neiReachable.find(secondRejoinLink);
-              if(findLink != m_neiReachable.end()) 
-              {
-                findLink->second = "false";
-              }
-              else {
-                m_neiReachable.insert(std::pair<std::string, std::string>(rejoinLink, "false"));
-              };
-
-              //except the select_up_nei, reply to other join-success neighbours to ignore
-              std::string cancelReply = possibleRejoinNeis[i] + "/CancelJoin(" + m_prefix.toUri() + ")-";
-              SendInterest(cancelReply);
-              std::cout << m_prefix.toUri() << " notify-Nei " << cancelReply << std::endl;
-            };
-          };
-
-          std::string upNeiFace = "/f-" + m_selectNodeName + "/rejoin-";
-          SendInterest(upNeiFace);
-          if (m_detectFailureSeqData.size() != 0) {
-            CheckFailSeq();
-          };
-        }
-        else {
-          std::cout << m_prefix.toUri() <<" re-join tree fail, need a new rejoin round" << std::endl;
-        };
-        m_gotRejoinNum = m_sendRejoinNum = 0;
-        m_possibleRejoinNeis.clear();
       };
     }
     // data for seq-check Interest
@@ -708,140 +729,6 @@ WqMapper::OnData(shared_ptr<const Data> data)
     {
       std::cout << m_prefix.toUri() <<" get resend-ACK = " << receivedData << std::endl;
     }
-    else 
-    {
-      switch(gotDataName[1])
-      {
-        case 'p':
-        {
-          uint64_t discoverFace = gotDataName.find("discover");
-          if (discoverFace != std::string::npos)
-          {
-            //std::cout << m_prefix.toUri() <<" get pit Data: " << receivedData << std::endl;
-            uint64_t tp = gotDataName.find_first_of("-");
-            std::string tempInName = gotDataName.substr(tp+1);
-            std::map<std::string, std::string>::iterator it = m_disTreeInterestMap.find(tempInName);
-            //std::cout<<"tempInName " << tempInName << std::endl;
-            if(it != m_disTreeInterestMap.end())
-            {
-              m_disTreeInterestMap[tempInName] = receivedData;
-              m_gotPitNum++;
-              //std::cout <<m_prefix.toUri() <<" m_gotPitNum: "<< m_gotPitNum <<std::endl;
-            };
-            if(m_gotPitNum == m_askPitNum)
-            {
-              //send Interest to ask FIB nexthop face
-              m_askFibPrefix = "/f-";
-              //m_askFibPrefix = "/r1-";
-              std::string tempAskFib = m_askFibPrefix + m_currentTreeTag;
-              SendInterest(tempAskFib);
-              //std::cout <<m_prefix.toUri() <<" tempAskFib: "<< tempAskFib <<std::endl;
-              //std::cout<< "go for fib round" <<std::endl;
-              m_askPitNum = 0;
-              m_gotPitNum = 0;
-            };
-          }
-          else
-          {
-            // only process Interest from selected Up-nei Face, ignore same Interest from other neis
-            // std::cout << m_prefix.toUri() <<" current Interest from Face= " << receivedData << std::endl;
-            if (receivedData == m_selectNodeFace)
-            {
-              ProcessNormalInterest(m_normalInterest);
-            }
-          };
-          break;
-        };
-        case 'f':
-        {
-          // std::cout << m_prefix.toUri() <<" get fib Data: " << receivedData << std::endl;
-          uint64_t rejoinFace = gotDataName.find("rejoin");
-          if (rejoinFace == std::string::npos) 
-          {
-            for(std::map<std::string, std::string>::iterator it=m_disTreeInterestMap.begin(); it!=m_disTreeInterestMap.end(); ++it)
-            {
-              std::cout << m_prefix.toUri() <<" reply InterestName= " << it->first << std::endl;
-              //add this node to check-nei-table as potential nei if select-nei link is broken
-              uint64_t p1 = it->first.find_first_of("-");
-              uint64_t p2 = it->first.find("/discover");
-              std::string upstreamNei = it->first.substr(p1+1, p2-p1-1);
-              std::string taskNei =  m_prefix.toUri() + upstreamNei + m_currentTreeTag;
-
-              std::string replyDisName = it->first;
-              Name replyDisDataName(replyDisName);
-              auto replyDisData = make_shared<Data>();
-              replyDisData->setName(replyDisName);
-              replyDisData->setFreshnessPeriod(::ndn::time::milliseconds(m_freshness.GetMilliSeconds()));
-            
-              SignatureInfo signatureInfo(static_cast< ::ndn::tlv::SignatureTypeValue>(255));
-              if (m_keyLocator.size() > 0) {
-                signatureInfo.setKeyLocator(m_keyLocator);
-              }
-              replyDisData->setSignatureInfo(signatureInfo);
-              ::ndn::EncodingEstimator estimator;
-              ::ndn::EncodingBuffer encoder(estimator.appendVarNumber(m_signature), 0);
-              encoder.appendVarNumber(m_signature);
-              replyDisData->setSignatureValue(encoder.getBuffer());
-      
-              if (it->second != receivedData)
-              {
-                //current not-selected upstream nei, save as potential neis if current select nei is disconnect
-                m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "false"));
-                // std::cout<<m_prefix.toUri() << " potential Nei: " << taskNei <<std::endl;
-
-                std::string rawData("nope");
-                const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-                auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
-                replyDisData->setContent(buffer);
-                // to create real wire encoding
-                replyDisData->wireEncode();
-                m_transmittedDatas(replyDisData, this, m_face);
-                m_appLink->onReceiveData(*replyDisData);
-                std::cout << m_prefix.toUri() << " reply Nack for disTree: " << rawData << std::endl;
-              }
-              // map size = 1 && the face = FIBface, got the selected upstream, not reply immediately, continue explore downstreams
-              else 
-              {
-                //current selected upstream nei
-                m_selectNodeName = upstreamNei;
-                // std::cout<<m_prefix.toUri() << " select Nei: " << taskNei <<std::endl;
-                m_selectNodeFace = it->second;
-                std::string rawData;
-                // if(m_prefix.toUri() == "/m5-"){
-                //   //to simulate node join after the job tree has running for a while
-                //   m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "false"));
-                //   rawData = "nope";
-                // }
-                // else {
-                //   m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "true"));
-                //   rawData = "yes";
-                // };
-
-                m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "true"));
-                rawData = "yes";
-                const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-                auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
-                replyDisData->setContent(buffer);
-                
-                // to create real wire encoding
-                replyDisData->wireEncode();
-                m_transmittedDatas(replyDisData, this, m_face);
-                m_appLink->onReceiveData(*replyDisData);
-                std::cout << m_prefix.toUri() << " reply Yes for disTree: " << rawData << std::endl;
-              }
-            }
-            m_disTreeInterestMap.clear();
-          }
-          else 
-          {
-            //get FaceId of rejoin up-nei 
-            m_selectNodeFace = receivedData;
-            // std::cout << m_prefix.toUri() <<" select upNei Face= " << receivedData << std::endl; 
-          };
-          break;
-        };
-      };
-    }
 }
 
 
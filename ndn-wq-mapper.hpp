@@ -23,6 +23,10 @@
 #include "ns3/ndnSIM/model/ndn-common.hpp"
 
 #include "ndn-app.hpp"
+#include "ndn-wq-tree-cache.hpp"
+#include "ndn-wq-path-label.hpp"
+#include "ndn-wq-heartbeat.hpp"
+#include "ndn-wq-backup-parents.hpp"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include <deque>
@@ -51,20 +55,27 @@ public:
   // inherited from NdnApp
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
+
+  virtual int64_t
+  AssignStreams(int64_t stream);
   
   virtual void
   OnData(shared_ptr<const Data> contentObject);
 
 public:
   void CheckNeiConnect();
-  void LinkBroken(std::string upNode, std::string downNode);
   void SendInterest(std::string sendName);
   void AddSeqData(std::string seqnum, int seqdata);
   void AddSeqUpNei(std::string seqnum, std::string neiname);
   void CheckFailSeq();
   void ReplyData(std::string replyContent, shared_ptr<const Interest> interest);
   void ProcessNormalInterest(shared_ptr<const Interest> interest);
-  void RegularCheckLink();
+  void RejoinOtherUpstream();
+  bool AskNextBackupParent();
+  void RejoinCandidateFailed();
+  void HandleLostNeighbour(const std::string& name);
+  void HeardFrom(const std::string& peer);
+  void HeartbeatTick();
   void ClearHistorySaveData(std::string seqList);
 
 
@@ -76,8 +87,12 @@ protected:
   virtual void
   StopApplication(); // Called at time specified by Stop
 
+  virtual void
+  OnNeighbourLinkChange(const std::string& name, bool up);
+
 private:
   Ptr<UniformRandomVariable> m_rand;
+  Ptr<UniformRandomVariable> m_valueRand; ///< @brief map results, apart from the nonces so they do not shift with traffic
   Name m_prefix;
   Name m_postfix;
   uint32_t m_virtualPayloadSize;
@@ -87,21 +102,13 @@ private:
   
   Name m_interestName;
   Name m_pendingInterestName;
-  std::string m_askPitPrefix;
-  std::map<std::string, std::string> m_disTreeInterestMap;
   std::string m_currentTreeTag = "000";
-  int m_askPitNum =0;
-  int m_gotPitNum =0;
-  std::string m_askFibPrefix;
   std::map<std::string, std::string> m_neiReachable;
   std::string m_selectNodeName;
   std::string m_selectNodeFace;
   bool reJoinAsk = false;
   std::string m_rejoinUpNeiName = "";
   EventId m_sendEvent;
-  bool excuteR2M3Fail = false;
-  bool excuteR2M6Fail = false;
-  bool excuteR1M7Fail = false;
   std::map<std::string, int> m_sentSeqData;
   std::map<std::string, std::string> m_sentSeqToNei;
   std::map<std::string, int> m_detectFailureSeqData;
@@ -110,9 +117,12 @@ private:
   std::string m_preUpNeiName;
   std::string m_myPathID;
   std::string m_prePathID;
-  std::map<std::string, std::string> m_possibleRejoinNeis; //(one-hop-nei-name, reply-content)
-  int m_sendRejoinNum =0;
-  int m_gotRejoinNum =0;
+  WqTreeCache m_treeCache;
+  WqHeartbeatDetector m_heartbeat; // the upstream only
+  EventId m_heartbeatEvent;
+  WqBackupParents m_backupParents;
+  std::string m_rejoinCandidate = ""; // the one backup parent asked, replies from others are stale
+  EventId m_rejoinEvent;
 };
 
 } // namespace ndn
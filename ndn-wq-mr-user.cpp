@@ -52,6 +52,15 @@ WqMrUser::GetTypeId(void)
 
       .AddAttribute("Frequency", "Frequency of interest packets", StringValue("1.0"),
                     MakeDoubleAccessor(&WqMrUser::m_frequency), MakeDoubleChecker<double>())
+      .AddAttribute("IssueMode", "How new seqs are issued: rate (default, Frequency) or window (AIMD on outstanding seqs)",
+                    StringValue("rate"), MakeStringAccessor(&WqMrUser::m_issueMode),
+                    MakeStringChecker())
+      .AddAttribute("InitialWindow", "Outstanding seqs allowed at start in window mode", StringValue("2"),
+                    MakeDoubleAccessor(&WqMrUser::m_initWindow), MakeDoubleChecker<double>(1))
+      .AddAttribute("MinWindow", "Lower bound of the issue window", StringValue("1"),
+                    MakeDoubleAccessor(&WqMrUser::m_minWindow), MakeDoubleChecker<double>(1))
+      .AddAttribute("MaxWindow", "Upper bound of the issue window", StringValue("64"),
+                    MakeDoubleAccessor(&WqMrUser::m_maxWindow), MakeDoubleChecker<double>(1))
 
       .AddAttribute("Randomize",
                     "Type of send time randomization: none (default), uniform, exponential",
@@ -176,6 +185,17 @@ WqMrUser::CheckRetxTimeout()
   m_retxEvent = Simulator::Schedule(m_retxTimer, &WqMrUser::CheckRetxTimeout, this);
 }
 
+int64_t
+WqMrUser::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  if (m_random != 0) {
+    m_random->SetStream(stream + 1);
+    return 2;
+  }
+  return 1;
+}
+
 void
 WqMrUser::StartApplication()
 {
@@ -183,6 +203,8 @@ WqMrUser::StartApplication()
   App::StartApplication();
 
   FibHelper::AddRoute(GetNode(), m_prefix, m_face, 0);
+  m_issueWindow.SetRttEstimator(m_rtt);
+  m_issueWindow.SetLimits(m_initWindow, m_minWindow, m_maxWindow);
 
   SendPacket();
 }
@@ -194,6 +216,8 @@ WqMrUser::StopApplication()
 
   // cancel periodic packet generation
   Simulator::Cancel(m_sendEvent);
+  Simulator::Cancel(m_windowEvent);
+  Simulator::Cancel(m_warmEvent);
 
   // cleanup base stuff
   App::StopApplication();
@@ -233,6 +257,10 @@ WqMrUser::SendPacket()
       AssignJobs();
     };
   } 
+  else if (m_oneHopNeighbours.size() != 0 && !m_warmTried && TryWarmStart())
+  {
+    // cached tree being confirmed, discovery only if a node refuses it
+  }
   else if (m_oneHopNeighbours.size() != 0)
   {
     //start build task-tree
@@ -256,27 +284,12 @@ WqMrUser::SendPacket()
   }
   else
   {
-    //start discovery neighbours
-    m_sendDisNeiNum = 0;
-    for(uint8_t i=0; i < m_allNodeName.size(); i++)
+    //start discovery neighbours, one local forwarder query instead of a "/nei-" probe per node
+    m_oneHopNeighbours = GetOneHopNeighbours();
+    std::cout << "next-hop neighbour number: " << m_oneHopNeighbours.size() <<std::endl;
+    if(m_oneHopNeighbours.size() != 0)
     {
-      // std::cout << " m_allNode " << m_allNodeName[i] << std::endl;
-      if(m_allNodeName[i] != m_ownPrefix)
-      {
-        m_checkNeibMap.insert(std::pair<std::string, std::string>(m_allNodeName[i],"0"));
-        // written as: /nei-/user-
-        std::string tempDisNei = m_disNeiPrefix + m_allNodeName[i];
-        shared_ptr<Name> disNeiName = make_shared<Name>(tempDisNei);
-        //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-        shared_ptr<Interest> disNeiInterest = make_shared<Interest>();
-        disNeiInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-        disNeiInterest->setName(*disNeiName);
-        disNeiInterest->setInterestLifetime(time::milliseconds(m_interestLifeTime.GetMilliSeconds()));
-        std::cout << " User disNeiInterest " << disNeiInterest->getName().toUri() << std::endl;
-        m_transmittedInterests(disNeiInterest, this, m_face);
-        m_appLink->onReceiveInterest(*disNeiInterest);
-        m_sendDisNeiNum +=1;
-      }
+      Simulator::Schedule(Seconds(0.0), &WqMrUser::SendPacket, this);
     };
   };
 }
@@ -291,6 +304,16 @@ WqMrUser::ScheduleNextPacket()
     m_sendEvent = Simulator::Schedule(Seconds(0.0), &WqMrUser::SendPacket, this);
     m_firstTime = false;
   }
+  else if (m_issueMode == "window") {
+    if (m_sendEvent.IsRunning())
+      return;
+    m_issueWindow.ExpireTimeouts();
+    // open window: next seq after one pacing gap, closed: a completion or the timeout reopens it
+    if (m_issueWindow.CanIssue())
+      m_sendEvent = Simulator::Schedule(m_issueWindow.GetPacing(), &WqMrUser::SendPacket, this);
+    else if (!m_windowEvent.IsRunning())
+      m_windowEvent = Simulator::Schedule(m_rtt->RetransmitTimeout(), &WqMrUser::ScheduleNextPacket, this);
+  }
   else if (!m_sendEvent.IsRunning())
     m_sendEvent = Simulator::Schedule((m_random == 0) ? Seconds(1.0 / m_frequency)
                                                       : Seconds(m_random->GetValue()),
@@ -330,7 +353,7 @@ WqMrUser::AssignNodeIdByPath()
   int i = 0;
   for(uint64_t j=0; j<m_sendJobNeis.size(); j++)
   {
-    std::string assignId = std::to_string(i);
+    std::string assignId = WqPathLabel::Child(WqPathLabel::Root(), i);
     // std::cout << m_prefix.toUri() << " assign node_path_ID = " << assignId << std::endl;
     std::map<std::string, std::string>::iterator checkId = m_nodePathId.find(assignId);
     if(checkId == m_nodePathId.end()) {
@@ -345,6 +368,18 @@ WqMrUser::AssignNodeIdByPath()
   //   std::cout << m_prefix.toUri() << " nodeName= " << x.first << " pathID= "<< x.second << std::endl;
   // };
 
+  // keep the tree for the next job on this topology
+  m_treeCache.SetPath(m_treeCacheDir, m_ownPrefix, m_ownPrefix);
+  if(m_treeCache.IsEnabled())
+  {
+    m_treeCache.Set("children", WqTreeCache::JoinNames(m_sendJobNeis));
+    for(uint64_t j=0; j<m_sendJobNeis.size(); j++)
+    {
+      m_treeCache.Set("id" + m_sendJobNeis[j], m_nodePathId[m_sendJobNeis[j]]);
+    };
+    m_treeCache.Save(GetTopologyFingerprint(m_ownPrefix));
+  };
+
   //tell assined ID to each job_nei
   for(uint64_t j=0; j<m_sendJobNeis.size(); j++)
   {
@@ -370,10 +405,79 @@ WqMrUser::AssignNodeIdByPath()
   }
 }
 
+bool
+WqMrUser::TryWarmStart()
+{
+  m_warmTried = true;
+  m_treeCache.SetPath(m_treeCacheDir, m_ownPrefix, m_ownPrefix);
+  if(!m_treeCache.Load(GetTopologyFingerprint(m_ownPrefix)))
+  {
+    return false;
+  };
+  m_warmChildren = WqTreeCache::SplitNames(m_treeCache.Get("children"));
+  if(m_warmChildren.size() == 0)
+  {
+    return false;
+  };
+  // one round down the cached tree: each node checks its own cache and its children
+  m_warmOk = true;
+  m_warmPending = m_warmChildren.size();
+  for(uint64_t j=0; j<m_warmChildren.size(); j++)
+  {
+    std::string warm = m_warmChildren[j] + m_disDownStream3 + m_ownPrefix + m_disDownStream2 + "/warm("
+                       + m_treeCache.Get("id" + m_warmChildren[j]) + ")-/from<" + m_ownPrefix + ">-";
+    std::cout << "User warm start: " << warm << std::endl;
+    SendOutInterest(warm);
+    Simulator::Cancel(m_warmEvent);
+    m_warmEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(warm).count()),
+                                      &WqMrUser::WarmStartTimeout, this);
+  };
+  return true;
+}
+
+void
+WqMrUser::FinishWarmStart()
+{
+  Simulator::Cancel(m_warmEvent);
+  m_warmPending = 0;
+  if(m_warmOk)
+  {
+    // same tree and path ids as last time, skip discovery and path-id assignment
+    m_sendJobNeis = m_warmChildren;
+    for(uint64_t j=0; j<m_sendJobNeis.size(); j++)
+    {
+      m_nodePathId[m_sendJobNeis[j]] = m_treeCache.Get("id" + m_sendJobNeis[j]);
+    }
+    std::cout << "User warm start, job Ref Neighbours: " << m_sendJobNeis.size() << std::endl;
+    AssignJobs();
+  }
+  else
+  {
+    std::cout << "User warm start refused, full discovery" << std::endl;
+    SendPacket();
+  }
+}
+
+void
+WqMrUser::WarmStartTimeout()
+{
+  if(m_warmPending == 0)
+  {
+    return;
+  }
+  std::cout << "User warm start timed out, " << m_warmPending << " children silent" << std::endl;
+  m_warmOk = false;
+  FinishWarmStart();
+}
+
 void
 WqMrUser::AssignJobs()
 {
   m_seqNum += 1;
+  // only window mode completes and expires issued seqs
+  if(m_issueMode == "window") {
+    m_issueWindow.OnIssue(m_seqNum);
+  };
   std::string seqStr = std::to_string(m_seqNum);
   std::string seqFlag = "Seq" + seqStr;
   std::map<std::string, int>::iterator checkJobSeq = m_assignJobSeq.find(seqFlag);
@@ -440,7 +544,7 @@ WqMrUser::SendOutInterest(std::string newInterest)
   shared_ptr<Interest> sendInterest = make_shared<Interest>();
   sendInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   sendInterest->setName(*sendName);
-  sendInterest->setInterestLifetime(ndn::time::seconds(1));
+  sendInterest->setInterestLifetime(GetClassLifetime(newInterest));
   m_transmittedInterests(sendInterest, this, m_face);
   m_appLink->onReceiveInterest(*sendInterest);
 }
@@ -486,6 +590,7 @@ WqMrUser::OnData(shared_ptr<const Data> data)
     uint64_t checkD= gotData.find("/discover");
     uint64_t d = gotData.find("doubt");
     uint64_t p = gotData.find("pathID");
+    uint64_t warm = gotData.find("/warm(");
     uint64_t process = gotData.find("process");
     uint64_t clear = gotData.find("clear");
 
@@ -552,6 +657,23 @@ WqMrUser::OnData(shared_ptr<const Data> data)
         m_gotDisDownNeiNum = m_sendDisDownNeiNum =0;
       }
     }
+    // confirmation of the cached tree, a reply after the timeout is already counted as a refusal
+    else if(warm != std::string::npos)
+    {
+      if(m_warmPending == 0)
+      {
+        return;
+      }
+      m_warmPending--;
+      if(receivedData != "yes")
+      {
+        m_warmOk = false;
+      }
+      if(m_warmPending == 0)
+      {
+        FinishWarmStart();
+      }
+    }
     // reducer reply for seq-check
     else if (d != std::string::npos)
     {
@@ -642,6 +764,11 @@ WqMrUser::OnData(shared_ptr<const Data> data)
           //   std::cout << "User AllReceiveSeq= " << x.first << " Data= " << x.second << std::endl;
           // };
           m_seqOkList.push_back(gotSeq);
+          if(m_issueMode == "window" && m_issueWindow.OnComplete(std::stoul(gotSeq.substr(3)))) {
+            std::cout << "Issue window= " << m_issueWindow.GetWindow() << " outstanding= " << m_issueWindow.GetOutstanding() << std::endl;
+            Simulator::Cancel(m_windowEvent);
+            ScheduleNextPacket();
+          };
           std::ofstream recording;
           recording.open("computeStateRecord.txt", std::ios_base::app);
           recording << Simulator::Now().GetSeconds() << '\t' << m_prefix.toUri() << '\t' << m_seqOkList.size() << std::endl;
@@ -689,6 +816,7 @@ WqMrUser::OnInterest(shared_ptr<const Interest> interest)
   uint64_t r = interest->getName().toUri().find("/resend");
   uint64_t leave = interest->getName().toUri().find("leave");
   uint64_t b = interest->getName().toUri().find("backTree");
+  uint64_t hb = interest->getName().toUri().find("/hb-");
 
   // node check fail seq&data
   if(d != std::string::npos)
@@ -700,12 +828,16 @@ WqMrUser::OnInterest(shared_ptr<const Interest> interest)
     uint64_t p2 = interest->getName().toUri().find(")");
     std::string doubtSeq = interest->getName().toUri().substr(s1, s2-s1-1);
     std::string d_nodePathId = interest->getName().toUri().substr(p1+1, p2-p1-1);
-    std::string directNeiId = d_nodePathId.substr(0,1);
+    int directNeiId = WqPathLabel::IndexAt(d_nodePathId, 0);
+    // a node lost data of the job, issue slower until the tree recovers
+    if(m_issueMode == "window") {
+      m_issueWindow.OnCongestion();
+    };
     // std::cout << " User receive doubt seq= " << doubtSeq << " neiID= " << directNeiId << std::endl;
     std::map<std::string, std::string>::iterator findId;
     for(findId=m_nodePathId.begin(); findId!=m_nodePathId.end(); findId++)
     {
-      if(findId->second == directNeiId)
+      if(WqPathLabel::IndexAt(findId->second, 0) == directNeiId)
       {
         std::string directNeiName = findId->first;
         // std::cout << " path nei name= " << directNeiName << std::endl;
@@ -773,6 +905,11 @@ WqMrUser::OnInterest(shared_ptr<const Interest> interest)
     // std::cout << " rejoin-node= " << rejoinNode <<std::endl;
     m_sendJobNeis.push_back(rejoinNode);
     ReplyData("Rejoin-Ok", interest->getName().toUri());
+  }
+  // beacon of a tree child that has not had a task from us for a while
+  else if(hb != std::string::npos)
+  {
+    ReplyData("alive", interest->getName().toUri());
   };
 }
 
@@ -23,6 +23,9 @@
 #include "ns3/ndnSIM/model/ndn-common.hpp"
 #include "ns3/random-variable-stream.h"
 #include "ndn-app.hpp"
+#include "ndn-wq-issue-window.hpp"
+#include "ndn-wq-tree-cache.hpp"
+#include "ndn-wq-path-label.hpp"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include <deque>
@@ -53,6 +56,9 @@ public:
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
 
+  virtual int64_t
+  AssignStreams(int64_t stream);
+
   /**
    * @brief Timeout event
    * @param sequenceNumber time outed sequence number
@@ -119,9 +125,18 @@ public:
   void AssignNodeIdByPath();
   void ResentDataCheck(std::string resentSeq);
   void AssignJobs();
+  bool TryWarmStart();
+  void FinishWarmStart();
+  void WarmStartTimeout();
 
 protected:
   double m_frequency; // Frequency of interest packets (in hertz)
+  std::string m_issueMode; // "rate": one seq per 1/Frequency, "window": AIMD window of outstanding seqs
+  double m_initWindow;
+  double m_minWindow;
+  double m_maxWindow;
+  WqIssueWindow m_issueWindow;
+  EventId m_windowEvent; ///< @brief re-check of a closed issue window
   bool m_firstTime;
   Ptr<RandomVariableStream> m_random;
   std::string m_randomType;
@@ -171,6 +186,12 @@ private:
   std::vector<std::string> m_seqOkList;
   std::map<std::string, std::string> m_doubtCheckInterest;
   std::map<std::string, std::string> m_nodePathId;
+  WqTreeCache m_treeCache;
+  bool m_warmTried = false;
+  bool m_warmOk = true;
+  int m_warmPending = 0;
+  std::vector<std::string> m_warmChildren; // cached job neis being confirmed
+  EventId m_warmEvent; // a child silent for an Interest lifetime refuses the warm start
   int m_countOkSeq = 0;
   std::vector<std::string> m_askClearSeqs;
 
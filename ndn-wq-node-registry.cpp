@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ndn-wq-node-registry.hpp"
+
+#include "ns3/node-list.h"
+#include "model/ndn-l3-protocol.hpp"
+#include "NFD/daemon/fw/forwarder.hpp"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+WqNodeRegistry&
+WqNodeRegistry::Get()
+{
+  static WqNodeRegistry registry;
+  return registry;
+}
+
+void
+WqNodeRegistry::Add(const std::string& name, const std::string& role, uint32_t nodeId)
+{
+  if (m_roles.find(name) == m_roles.end()) {
+    m_names.push_back(name);
+  }
+  m_roles[name] = role;
+  m_nodeIds[name] = nodeId;
+}
+
+void
+WqNodeRegistry::Clear()
+{
+  m_names.clear();
+  m_roles.clear();
+  m_nodeIds.clear();
+}
+
+const std::vector<std::string>&
+WqNodeRegistry::GetNames() const
+{
+  return m_names;
+}
+
+std::string
+WqNodeRegistry::GetRole(const std::string& name) const
+{
+  std::map<std::string, std::string>::const_iterator it = m_roles.find(name);
+  return it == m_roles.end() ? "" : it->second;
+}
+
+std::vector<std::string>
+WqNodeRegistry::GetByRole(const std::string& role) const
+{
+  std::vector<std::string> names;
+  for (uint64_t i = 0; i < m_names.size(); i++) {
+    if (m_roles.find(m_names[i])->second == role) {
+      names.push_back(m_names[i]);
+    }
+  }
+  return names;
+}
+
+std::vector<std::string>
+WqNodeRegistry::GetByRole(const std::string& role, const std::string& from, uint64_t maxDistance) const
+{
+  std::vector<std::pair<uint64_t, std::string>> near;
+  std::vector<std::string> names = GetByRole(role);
+  for (uint64_t i = 0; i < names.size(); i++) {
+    uint64_t distance = GetDistance(from, names[i]);
+    if (distance <= maxDistance) {
+      near.push_back(std::make_pair(distance, names[i]));
+    }
+  }
+  // stable, so equal distances keep registration order
+  std::stable_sort(near.begin(), near.end(),
+                   [] (const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b) {
+                     return a.first < b.first;
+                   });
+  names.clear();
+  for (uint64_t i = 0; i < near.size(); i++) {
+    names.push_back(near[i].second);
+  }
+  return names;
+}
+
+uint64_t
+WqNodeRegistry::GetDistance(const std::string& from, const std::string& to) const
+{
+  if (from == to) {
+    return 0;
+  }
+  std::map<std::string, uint32_t>::const_iterator node = m_nodeIds.find(from);
+  if (node == m_nodeIds.end() || m_nodeIds.find(to) == m_nodeIds.end()) {
+    return NO_ROUTE;
+  }
+  Ptr<L3Protocol> l3 = NodeList::GetNode(node->second)->GetObject<L3Protocol>();
+  const nfd::fib::Entry& entry = l3->getForwarder()->getFib().findLongestPrefixMatch(Name(to));
+  if (entry.getPrefix() != Name(to) || entry.getNextHops().empty()) {
+    return NO_ROUTE;
+  }
+  return entry.getNextHops().front().getCost();
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef NDN_WQ_NODE_REGISTRY_H
+#define NDN_WQ_NODE_REGISTRY_H
+
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Names and roles of the WQ nodes of a scenario
+ *
+ * The scenario registers every app prefix next to its AddOrigins call, with a
+ * role tag ("mapper", "reducer", "sink"). One registry is shared read-only by
+ * all apps. Distance is the FIB cost on the node of the first name, so it is
+ * only meaningful after the routes are calculated.
+ */
+class WqNodeRegistry {
+public:
+  static WqNodeRegistry&
+  Get();
+
+  void
+  Add(const std::string& name, const std::string& role, uint32_t nodeId);
+
+  void
+  Clear();
+
+  /**
+   * @brief All registered names, in registration order
+   */
+  const std::vector<std::string>&
+  GetNames() const;
+
+  std::string
+  GetRole(const std::string& name) const;
+
+  std::vector<std::string>
+  GetByRole(const std::string& role) const;
+
+  /**
+   * @brief Names of @p role within @p maxDistance of @p from, nearest first
+   */
+  std::vector<std::string>
+  GetByRole(const std::string& role, const std::string& from, uint64_t maxDistance) const;
+
+  /**
+   * @brief FIB cost from @p from to @p to, NO_ROUTE when either is unknown or unrouted
+   */
+  uint64_t
+  GetDistance(const std::string& from, const std::string& to) const;
+
+  static const uint64_t NO_ROUTE = std::numeric_limits<uint64_t>::max();
+
+private:
+  std::vector<std::string> m_names;
+  std::map<std::string, std::string> m_roles; // name -- role
+  std::map<std::string, uint32_t> m_nodeIds;  // name -- ns-3 node id
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
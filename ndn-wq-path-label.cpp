@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-path-label.hpp"
+
+#include <cstdio>
+
+namespace ns3 {
+namespace ndn {
+
+static const uint32_t LEVEL_BITS = 5;
+static const uint32_t DEPTH_SHIFT = 60;
+
+bool
+WqPathLabel::Decode(const std::string& label, uint64_t& value)
+{
+  if (label.size() != 16) {
+    return false;
+  }
+  value = 0;
+  for (uint64_t i = 0; i < label.size(); i++) {
+    char c = label[i];
+    uint64_t digit = 0;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    }
+    else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    }
+    else {
+      return false;
+    }
+    value = (value << 4) | digit;
+  }
+  return (value >> DEPTH_SHIFT) <= MAX_DEPTH;
+}
+
+std::string
+WqPathLabel::Encode(uint64_t value)
+{
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)value);
+  return std::string(buf);
+}
+
+std::string
+WqPathLabel::Root()
+{
+  return Encode(0);
+}
+
+std::string
+WqPathLabel::Child(const std::string& parent, uint32_t index)
+{
+  uint64_t value = 0;
+  if (!Decode(parent, value) || index >= MAX_CHILDREN) {
+    return "";
+  }
+  uint64_t depth = value >> DEPTH_SHIFT;
+  if (depth >= MAX_DEPTH) {
+    return "";
+  }
+  uint64_t shift = DEPTH_SHIFT - (depth + 1) * LEVEL_BITS;
+  value &= ~((uint64_t)0xF << DEPTH_SHIFT);
+  value |= (uint64_t)index << shift;
+  value |= (depth + 1) << DEPTH_SHIFT;
+  return Encode(value);
+}
+
+std::string
+WqPathLabel::Parent(const std::string& label)
+{
+  uint64_t value = 0;
+  if (!Decode(label, value) || (value >> DEPTH_SHIFT) == 0) {
+    return "";
+  }
+  uint64_t depth = value >> DEPTH_SHIFT;
+  uint64_t shift = DEPTH_SHIFT - depth * LEVEL_BITS;
+  value &= ~((uint64_t)0xF << DEPTH_SHIFT);
+  value &= ~((uint64_t)(MAX_CHILDREN - 1) << shift);
+  value |= (depth - 1) << DEPTH_SHIFT;
+  return Encode(value);
+}
+
+uint32_t
+WqPathLabel::Depth(const std::string& label)
+{
+  uint64_t value = 0;
+  if (!Decode(label, value)) {
+    return 0;
+  }
+  return value >> DEPTH_SHIFT;
+}
+
+int
+WqPathLabel::IndexAt(const std::string& label, uint32_t level)
+{
+  uint64_t value = 0;
+  if (!Decode(label, value) || level >= (value >> DEPTH_SHIFT)) {
+    return -1;
+  }
+  uint64_t shift = DEPTH_SHIFT - (level + 1) * LEVEL_BITS;
+  return (value >> shift) & (MAX_CHILDREN - 1);
+}
+
+std::string
+WqPathLabel::Rebase(const std::string& label, const std::string& parent)
+{
+  uint32_t depth = Depth(label);
+  if (depth == 0) {
+    return "";
+  }
+  return Child(parent, IndexAt(label, depth - 1));
+}
+
+bool
+WqPathLabel::IsWithin(const std::string& label, const std::string& root)
+{
+  uint64_t value = 0;
+  uint64_t rootValue = 0;
+  if (!Decode(label, value) || !Decode(root, rootValue)) {
+    return false;
+  }
+  uint64_t depth = value >> DEPTH_SHIFT;
+  uint64_t rootDepth = rootValue >> DEPTH_SHIFT;
+  if (depth < rootDepth) {
+    return false;
+  }
+  // same indices on every level of the root
+  uint64_t levels = ((uint64_t)1 << DEPTH_SHIFT) - ((uint64_t)1 << (DEPTH_SHIFT - rootDepth * LEVEL_BITS));
+  return (value & levels) == (rootValue & levels);
+}
+
+std::string
+WqPathLabel::Tag(const std::string& label)
+{
+  return "/lbl<" + label + ">";
+}
+
+std::string
+WqPathLabel::FromName(const std::string& name)
+{
+  uint64_t l1 = name.find("/lbl<");
+  if (l1 == std::string::npos) {
+    return "";
+  }
+  uint64_t l2 = name.find(">", l1);
+  if (l2 == std::string::npos) {
+    return "";
+  }
+  return name.substr(l1 + 5, l2 - l1 - 5);
+}
+
+std::string
+WqPathLabel::SubtreeTag(const std::string& label)
+{
+  return "/sub<" + label + ">";
+}
+
+std::string
+WqPathLabel::SubtreeFromName(const std::string& name)
+{
+  uint64_t s1 = name.find("/sub<");
+  if (s1 == std::string::npos) {
+    return "";
+  }
+  uint64_t s2 = name.find(">", s1);
+  if (s2 == std::string::npos) {
+    return "";
+  }
+  return name.substr(s1 + 5, s2 - s1 - 5);
+}
+
+} // namespace ndn
+} // namespace ns3
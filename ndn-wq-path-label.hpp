@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_PATH_LABEL_H
+#define NDN_WQ_PATH_LABEL_H
+
+#include <string>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Fixed-width path labels of the old-flow job tree
+ *
+ * A label packs the child index taken at every level below the sink into one 64-bit
+ * word: the depth in the top 4 bits, then 5 bits per level, level 0 (child of the sink)
+ * highest. It is written as 16 hex digits, so names keep the same length at any depth.
+ * Up to 12 levels and 32 children per node.
+ */
+class WqPathLabel {
+public:
+  static const uint32_t MAX_DEPTH = 12;
+  static const uint32_t MAX_CHILDREN = 32;
+
+  /**
+   * @brief Label of the sink, depth 0
+   */
+  static std::string
+  Root();
+
+  /**
+   * @brief Label of child @p index of @p parent, empty when the parent is not a label or a limit is hit
+   */
+  static std::string
+  Child(const std::string& parent, uint32_t index);
+
+  /**
+   * @brief Label one level up, empty for the sink or a malformed label
+   */
+  static std::string
+  Parent(const std::string& label);
+
+  static uint32_t
+  Depth(const std::string& label);
+
+  /**
+   * @brief Child index taken at @p level, -1 when the label is not that deep
+   */
+  static int
+  IndexAt(const std::string& label, uint32_t level);
+
+  /**
+   * @brief Same last index as @p label, under @p parent. Empty when @p label is the sink or malformed
+   */
+  static std::string
+  Rebase(const std::string& label, const std::string& parent);
+
+  /**
+   * @brief True when @p label is @p root or lies below it, false if either is malformed
+   */
+  static bool
+  IsWithin(const std::string& label, const std::string& root);
+
+  /**
+   * @brief Name component carrying the label of the sender on task Interests
+   */
+  static std::string
+  Tag(const std::string& label);
+
+  /**
+   * @brief Label carried by Tag() in @p name, empty when there is none
+   */
+  static std::string
+  FromName(const std::string& name);
+
+  /**
+   * @brief Name component summarising the subtree under @p label on rejoin and graft Interests:
+   *        every node of that subtree carries @p label as a prefix of its own
+   */
+  static std::string
+  SubtreeTag(const std::string& label);
+
+  /**
+   * @brief Label carried by SubtreeTag() in @p name, empty when there is none
+   */
+  static std::string
+  SubtreeFromName(const std::string& name);
+
+private:
+  static bool
+  Decode(const std::string& label, uint64_t& value);
+
+  static std::string
+  Encode(uint64_t value);
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-placement.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+namespace ndn {
+
+WqPlacement::WqPlacement(double hopWeight, double sinkWeight, double balanceWeight)
+  : m_hopWeight(hopWeight)
+  , m_sinkWeight(sinkWeight)
+  , m_balanceWeight(balanceWeight)
+  , m_objective(0)
+  , m_hops(0)
+  , m_sinkHops(0)
+{
+}
+
+double
+WqPlacement::Evaluate(const std::vector<uint32_t>& open, std::vector<uint32_t>& assign) const
+{
+  const std::vector<std::vector<uint32_t>>& hops = *m_hops;
+  uint64_t mapperNum = hops[0].size();
+  double avgLoad = std::max(1.0, (double)mapperNum / open.size());
+  std::vector<uint32_t> load(open.size(), 0);
+  assign.assign(mapperNum, 0);
+
+  double objective = 0;
+  for (uint64_t o = 0; o < open.size(); o++) {
+    objective += m_sinkWeight * (*m_sinkHops)[open[o]];
+  }
+  for (uint64_t m = 0; m < mapperNum; m++) {
+    // marginal cost: hops, plus the growth of load^2/avg when one more mapper joins
+    double best = std::numeric_limits<double>::max();
+    uint64_t bestO = 0;
+    for (uint64_t o = 0; o < open.size(); o++) {
+      double cost = m_hopWeight * hops[open[o]][m] + m_balanceWeight * (2.0 * load[o] + 1) / avgLoad;
+      if (cost < best) {
+        best = cost;
+        bestO = o;
+      }
+    }
+    load[bestO]++;
+    assign[m] = open[bestO];
+    objective += best;
+  }
+  return objective;
+}
+
+std::vector<uint32_t>
+WqPlacement::Solve(const std::vector<std::vector<uint32_t>>& hops, const std::vector<uint32_t>& sinkHops,
+                   uint32_t k, std::vector<uint32_t>& assign)
+{
+  m_hops = &hops;
+  m_sinkHops = &sinkHops;
+  std::vector<uint32_t> open;
+  k = std::min<uint32_t>(k, hops.size());
+  if (k == 0 || hops[0].size() == 0) {
+    assign.clear();
+    m_objective = 0;
+    return open;
+  }
+
+  // greedy: open the reducer that lowers the objective most, until k are open
+  std::vector<bool> isOpen(hops.size(), false);
+  std::vector<uint32_t> tryAssign;
+  while (open.size() < k) {
+    double best = std::numeric_limits<double>::max();
+    uint32_t bestR = 0;
+    for (uint32_t r = 0; r < hops.size(); r++) {
+      if (isOpen[r]) {
+        continue;
+      }
+      open.push_back(r);
+      double objective = Evaluate(open, tryAssign);
+      open.pop_back();
+      if (objective < best) {
+        best = objective;
+        bestR = r;
+      }
+    }
+    open.push_back(bestR);
+    isOpen[bestR] = true;
+    m_objective = best;
+  }
+
+  // swap: one pass replacing an opened reducer by a closed one whenever that helps
+  for (uint64_t o = 0; o < open.size(); o++) {
+    for (uint32_t r = 0; r < hops.size(); r++) {
+      if (isOpen[r]) {
+        continue;
+      }
+      uint32_t pre = open[o];
+      open[o] = r;
+      double objective = Evaluate(open, tryAssign);
+      if (objective < m_objective) {
+        m_objective = objective;
+        isOpen[pre] = false;
+        isOpen[r] = true;
+      }
+      else {
+        open[o] = pre;
+      }
+    }
+  }
+
+  m_objective = Evaluate(open, assign);
+  return open;
+}
+
+double
+WqPlacement::GetObjective() const
+{
+  return m_objective;
+}
+
+} // namespace ndn
+} // namespace ns3
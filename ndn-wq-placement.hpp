@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_PLACEMENT_H
+#define NDN_WQ_PLACEMENT_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Picks the reducers of a job and the mappers of each reducer from hop costs
+ *
+ * Minimises   HopWeight * sum(hops mapper -> its reducer)
+ *           + SinkWeight * sum(hops reducer -> sink)
+ *           + BalanceWeight * sum(load^2) / average load
+ *
+ * Reducers are opened greedily (k-median style), then improved by swapping an opened
+ * reducer with a closed one in one pass. Mappers go to the reducer with the lowest
+ * marginal cost.
+ * Cost is O(k * R * M * k) for R candidates and M mappers.
+ */
+class WqPlacement {
+public:
+  WqPlacement(double hopWeight, double sinkWeight, double balanceWeight);
+
+  /**
+   * @param hops hops[r][m], candidate reducer r to mapper m
+   * @param sinkHops hops of candidate reducer r to the sink
+   * @param k number of reducers to open
+   * @param assign on return, index of the reducer of each mapper
+   * @returns indexes of the opened reducers
+   */
+  std::vector<uint32_t>
+  Solve(const std::vector<std::vector<uint32_t>>& hops, const std::vector<uint32_t>& sinkHops, uint32_t k,
+        std::vector<uint32_t>& assign);
+
+  double
+  GetObjective() const;
+
+private:
+  double
+  Evaluate(const std::vector<uint32_t>& open, std::vector<uint32_t>& assign) const;
+
+private:
+  double m_hopWeight;
+  double m_sinkWeight;
+  double m_balanceWeight;
+  double m_objective;
+  const std::vector<std::vector<uint32_t>>* m_hops;
+  const std::vector<uint32_t>* m_sinkHops;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
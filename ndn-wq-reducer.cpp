@@ -19,6 +19,7 @@
 
 // #include "/usr/include/python3.8/Python.h"
 #include "ndn-wq-reducer.hpp"
+#include "ndn-wq-node-registry.hpp"
 #include "ns3/log.h"
 #include "ns3/string.h"
 #include "ns3/uinteger.h"
@@ -84,6 +85,13 @@ WqReducer::WqReducer()
   NS_LOG_FUNCTION_NOARGS();
 }
 
+int64_t
+WqReducer::AssignStreams(int64_t stream)
+{
+  m_rand->SetStream(stream);
+  return 1;
+}
+
 // inherited from Application base class.
 void
 WqReducer::StartApplication()
@@ -99,6 +107,9 @@ WqReducer::StopApplication()
 {
   NS_LOG_FUNCTION_NOARGS();
 
+  Simulator::Cancel(m_heartbeatEvent);
+  Simulator::Cancel(m_rejoinEvent);
+  Simulator::Cancel(m_warmEvent);
   App::StopApplication();
 }
 
@@ -106,26 +117,14 @@ WqReducer::StopApplication()
 void
 WqReducer::FindNeighbours()
 {
-  //std::cout << "find neighbours: " << m_pendingInterestName.toUri() << std::endl;
-  m_disNeiPrefix = "/nei-";
-  for(uint8_t i=0; i < m_allNodeName.size(); i++)
+  // one local forwarder query instead of a "/nei-" probe per cluster node
+  m_oneHopNeighbours = GetOneHopNeighbours();
+  std::cout << m_prefix.toUri() << " next-hop neighbour number: " << m_oneHopNeighbours.size() << std::endl;
+  if(m_oneHopNeighbours.size() == 0)
   {
-    if(m_allNodeName[i] != m_prefix.toUri())
-    {
-      m_checkNeibMap.insert(std::pair<std::string, std::string>(m_allNodeName[i],"0"));
-      // written as: /nei-/user-
-      std::string tempDisNei = m_disNeiPrefix + m_allNodeName[i];
-      shared_ptr<Name> disNeiName = make_shared<Name>(tempDisNei);
-      //originalInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-      shared_ptr<Interest> disNeiInterest = make_shared<Interest>();
-      disNeiInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-      disNeiInterest->setName(*disNeiName);
-      disNeiInterest->setInterestLifetime(ndn::time::seconds(1));
-      m_transmittedInterests(disNeiInterest, this, m_face);
-      m_appLink->onReceiveInterest(*disNeiInterest);
-      m_sendDisNeiNum +=1;
-    }
+    return;
   };
+  Simulator::Schedule(Seconds(0.0), &WqReducer::DiscoverDownstreams, this);
 };
 
 void
@@ -196,24 +195,34 @@ WqReducer::DiscoverDownstreams()
 };
 
 void
-WqReducer::QueryPit()
+WqReducer::ReplayDeferredTasks()
 {
-  //std::cout << m_prefix.toUri() <<" map size " <<m_buildTreeInterestMap.size() << std::endl;
-  for(std::map<std::string, std::string>::iterator it=m_buildTreeInterestMap.begin(); it!=m_buildTreeInterestMap.end(); ++it)
+  std::vector<shared_ptr<const Interest>> tasks;
+  tasks.swap(m_deferredTasks);
+  for(uint64_t k=0; k<tasks.size(); k++)
   {
-    m_askPitPrefix = "/p-";
-    std::string tempAskPit = m_askPitPrefix + it->first;
-    //std::cout << m_prefix.toUri() <<"tempAskPit: "<< tempAskPit <<std::endl;
-    shared_ptr<Name> askPitName = make_shared<Name>(tempAskPit);
-    //subBtInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-    shared_ptr<Interest> askPitInterest = make_shared<Interest>();
-    askPitInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-    askPitInterest->setName(*askPitName);
-    askPitInterest->setInterestLifetime(ndn::time::seconds(1));
-    m_transmittedInterests(askPitInterest, this, m_face);
-    m_appLink->onReceiveInterest(*askPitInterest);
-    m_askPitNum++;
-  }  
+    std::cout << m_prefix.toUri() <<" replay held task: " << tasks[k]->getName().toUri() <<std::endl;
+  };
+  ServeTasks(tasks);
+};
+
+void
+WqReducer::ServeTasks(const std::vector<shared_ptr<const Interest>>& tasks)
+{
+  // PIT face of every task in one local query, only the selected upstream face is served
+  std::vector<uint64_t> inFaces = GetPitInFaces(tasks);
+  for(uint64_t k=0; k<tasks.size(); k++)
+  {
+    m_pendingInterestName = tasks[k]->getName();
+    m_normalInterest = tasks[k];
+    if(std::to_string(inFaces[k]) == m_selectNodeFace)
+    {
+      ProcessNormalInterest(tasks[k]);
+    }
+    else {
+      ReplyData("Ignore", tasks[k]->getName().toUri());
+    };
+  };
 };
 
 void
@@ -227,7 +236,7 @@ WqReducer::SendOutInterest(std::string newInterest)
   shared_ptr<Interest> sendInterest = make_shared<Interest>();
   sendInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
   sendInterest->setName(*sendName);
-  sendInterest->setInterestLifetime(ndn::time::seconds(1));
+  sendInterest->setInterestLifetime(GetClassLifetime(newInterest));
   m_transmittedInterests(sendInterest, this, m_face);
   m_appLink->onReceiveInterest(*sendInterest);
   // std::cout <<m_prefix.toUri() << " Send-Interest: " << newInterest << std::endl;
@@ -289,14 +298,14 @@ WqReducer::NewJoinAssignId(std::string joinNode)
     {
       if(m_neiLocalId.size() == 0) {
         m_neiLocalId.insert(std::pair<std::string, std::string>(joinNode, "0"));
-        m_joinNeiPathId = m_myPathID + "-" + "0";
+        m_joinNeiPathId = WqPathLabel::Child(m_myPathID, 0);
       }
       else {
         --checkNei;
         std::string existMaxId = checkNei->second;
         std::string assignId = std::to_string(std::stoi(existMaxId) + 1);
         m_neiLocalId.insert(std::pair<std::string, std::string>(joinNode, assignId));
-        m_joinNeiPathId = m_myPathID + "-" + assignId;
+        m_joinNeiPathId = WqPathLabel::Child(m_myPathID, std::stoul(assignId));
       }
       m_nodePathId.insert(std::pair<std::string, std::string>(joinNode, m_joinNeiPathId));
       // std::cout  << " m_joinNeiPathId = " << m_joinNeiPathId << std::endl;
@@ -307,7 +316,7 @@ WqReducer::NewJoinAssignId(std::string joinNode)
       std::map<std::string, std::string>::iterator checkId = m_nodePathId.find(joinNode);
       if(checkId == m_nodePathId.end())
       {
-        m_joinNeiPathId = m_myPathID + "-" + checkNei->second;
+        m_joinNeiPathId = WqPathLabel::Child(m_myPathID, std::stoul(checkNei->second));
         m_nodePathId.insert(std::pair<std::string, std::string>(joinNode, m_joinNeiPathId));
       }
       else {
@@ -323,14 +332,14 @@ WqReducer::NewJoinAssignId(std::string joinNode)
     {
       std::string reuseId = m_lostNeiIdRecords.begin()->second;
       m_neiLocalId.insert(std::pair<std::string, std::string>(joinNode, reuseId));
-      m_joinNeiPathId = m_myPathID + "-" + reuseId;
+      m_joinNeiPathId = WqPathLabel::Child(m_myPathID, std::stoul(reuseId));
       m_nodePathId.insert(std::pair<std::string, std::string>(joinNode, m_joinNeiPathId));
     }
     else
     {
       std::string preId = searchNode->second;
       m_neiLocalId.insert(std::pair<std::string, std::string>(joinNode, preId));
-      m_joinNeiPathId = m_myPathID + "-" + preId;
+      m_joinNeiPathId = WqPathLabel::Child(m_myPathID, std::stoul(preId));
       m_nodePathId.insert(std::pair<std::string, std::string>(joinNode, m_joinNeiPathId));
     };
     std::map<std::string, std::string>::iterator d = m_lostNeiIdRecords.begin();
@@ -414,48 +423,155 @@ WqReducer::RejoinTreeNeighbour(std::string requestNeiName)
 };
 
 void
-WqReducer::RejoinTreeDueToUpNeiFail (std::string preChooseLink)
+WqReducer::RejoinTreeDueToUpNeiFail()
 {
-  //to make sure the node has other possible up-neis
-  if(m_neiReachable.size() > 1)
+  //one rejoin to the best backup parent, the next one is only asked if it refuses
+  if(AskNextBackupParent()) {
+    return;
+  };
+  if(!m_graftInterest.empty())
   {
-    std::map<std::string, std::string>::iterator findLink;
-    for(findLink=m_neiReachable.begin(); findLink != m_neiReachable.end(); ++findLink) 
-    {
-      if(findLink->first != preChooseLink) {
-        uint64_t t = findLink->first.find_last_of("/");
-        std::string treeId= findLink->first.substr(t);
-        if(treeId == m_currentTreeFlag) 
-        {
-          std::cout<< m_prefix.toUri() << " potential nei to current user: " << findLink->first << std::endl;
-          uint64_t s1 = findLink->first.find("-");
-          uint64_t s2 = findLink->first.find_last_of("/");
-          std::string upNeiName = findLink->first.substr(s1+1, s2-s1-1);
-
-          std::string changeNeiInterest = upNeiName + "/rejoin-" + m_prefix.toUri() + "/TS" + m_currentTreeFlag + "/TE-";
-          std::cout<< m_prefix.toUri() << " changeUpNeiInterest: " << changeNeiInterest << std::endl;
-          SendOutInterest(changeNeiInterest);
-          reJoinAsk = true;
-          m_sendRejoinNum++;
-          m_possibleRejoinNeis.insert(std::pair<std::string, std::string>(upNeiName,"0"));
-
-          if(m_sendRejoinNum == 0) 
-          {
-            std::cout<< m_prefix.toUri() << " has no up-nei to rejoin" << std::endl;
-            for(uint64_t i=0; i<m_nodeList4Task.size(); i++) {
-              std::string tellDownNei = m_nodeList4Task[i] + "/Upfail-" + "/TS" + m_currentTreeFlag + "/TE-";
-              SendOutInterest(tellDownNei);
-              reJoinAsk = true;
-            };
-          };
-        };
-      };
+    //our upstream asked us to carry its subtree, we have no way out either
+    ReplyData("No-route", m_graftInterest);
+    m_graftInterest = "";
+    reJoinAsk = false;
+    return;
+  };
+  //keep the subtree together: a child with an outside parent takes us along as its child
+  if(AskNextGraftChild()) {
+    return;
+  };
+  std::cout<< m_prefix.toUri() << " has NO other routes... " << std::endl;
+  m_graftAsked.clear();
+  for(uint64_t i=0; i<m_nodeList4Task.size(); i++) {
+    std::string tellDownNei = m_nodeList4Task[i] + "/Upfail-" + "/TS" + m_currentTreeFlag + "/TE-";
+    SendOutInterest(tellDownNei);
+  };
+  reJoinAsk = true;
+};
+
+bool
+WqReducer::AskNextBackupParent()
+{
+  std::vector<std::string> ranked = m_backupParents.Get(m_currentTreeFlag);
+  for(uint64_t i=0; i<ranked.size(); i++)
+  {
+    // checked lazily: a candidate whose link is down or that rejoined below us is skipped, not dropped
+    if(ranked[i] == m_selectNodeName || !IsNeighbourUp(ranked[i]) ||
+       std::find(m_nodeList4Task.begin(), m_nodeList4Task.end(), ranked[i]) != m_nodeList4Task.end()) {
+      std::cout<< m_prefix.toUri() << " skip backup parent " << ranked[i] << std::endl;
+      continue;
     };
-  }
-  else {
-    std::cout<< m_prefix.toUri() << " has NO other routes... " << std::endl;
-  }; 
-  
+    //the subtree moving with us, so the candidate can refuse if it sits inside it
+    std::string summary = m_graftInterest.empty() ? m_myPathID : WqPathLabel::SubtreeFromName(m_graftInterest);
+    std::string changeNeiInterest = ranked[i] + "/rejoin-" + m_prefix.toUri() + "/TS" + m_currentTreeFlag + "/TE-"
+                                    + WqPathLabel::SubtreeTag(summary) + "-";
+    std::cout<< m_prefix.toUri() << " changeUpNeiInterest: " << changeNeiInterest << std::endl;
+    m_rejoinCandidate = ranked[i];
+    reJoinAsk = true;
+    SendOutInterest(changeNeiInterest);
+    //no answer within the Interest lifetime counts as a refusal
+    Simulator::Cancel(m_rejoinEvent);
+    m_rejoinEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(changeNeiInterest).count()),
+                                        &WqReducer::RejoinCandidateFailed, this);
+    return true;
+  };
+  return false;
+};
+
+void
+WqReducer::RejoinCandidateFailed()
+{
+  std::cout << m_prefix.toUri() <<" rejoin-Fail link= " << m_rejoinCandidate << std::endl;
+  Simulator::Cancel(m_rejoinEvent);
+  m_backupParents.Remove(m_currentTreeFlag, m_rejoinCandidate);
+  m_rejoinCandidate = "";
+  RejoinTreeDueToUpNeiFail();
+};
+
+bool
+WqReducer::AskNextGraftChild()
+{
+  for(uint64_t i=0; i<m_nodeList4Task.size(); i++)
+  {
+    std::string child = m_nodeList4Task[i];
+    std::map<std::string, std::string>::iterator l = m_neiReachable.find(m_prefix.toUri() + child + m_currentTreeFlag);
+    //mappers cannot hold children, and each child is asked once per repair
+    if(WqNodeRegistry::Get().GetRole(child) != "reducer" || l == m_neiReachable.end() || l->second != "true" ||
+       std::find(m_graftAsked.begin(), m_graftAsked.end(), child) != m_graftAsked.end()) {
+      continue;
+    };
+    std::string graft = child + "/graft-" + m_prefix.toUri() + "/TS" + m_currentTreeFlag + "/TE-"
+                        + WqPathLabel::SubtreeTag(m_myPathID) + "-";
+    std::cout<< m_prefix.toUri() << " ask child to graft: " << graft << std::endl;
+    m_graftAsked.push_back(child);
+    m_graftCandidate = child;
+    reJoinAsk = true;
+    SendOutInterest(graft);
+    Simulator::Cancel(m_rejoinEvent);
+    m_rejoinEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(graft).count()),
+                                        &WqReducer::GraftChildFailed, this);
+    return true;
+  };
+  return false;
+};
+
+void
+WqReducer::GraftChildFailed()
+{
+  std::cout << m_prefix.toUri() <<" graft-Fail child= " << m_graftCandidate << std::endl;
+  Simulator::Cancel(m_rejoinEvent);
+  m_graftCandidate = "";
+  RejoinTreeDueToUpNeiFail();
+};
+
+void
+WqReducer::ProcessGraftInterest(std::string graftName)
+{
+  uint64_t g = graftName.find("/graft-");
+  uint64_t a1 = graftName.find("TS");
+  std::string asker = graftName.substr(g+7, a1-g-8);
+  if(asker != m_selectNodeName || reJoinAsk || !m_graftInterest.empty())
+  {
+    ReplyData("No-route", graftName);
+    return;
+  };
+  //rejoin on behalf of the whole subtree of our upstream, which then hangs below us
+  m_graftInterest = graftName;
+  m_sendRejoinNode = m_prefix.toUri();
+  RejoinTreeDueToUpNeiFail();
+};
+
+void
+WqReducer::AdoptUpstream(std::string upstream, std::string joinAnswer)
+{
+  std::string rejoinLink = m_prefix.toUri() + upstream + m_currentTreeFlag;
+  std::cout << m_prefix.toUri() <<" FIND rejoin link= " << rejoinLink << std::endl;
+  m_neiReachable[rejoinLink] = "true";
+  //the new upstream is no longer a backup of ours
+  m_backupParents.Remove(m_currentTreeFlag, upstream);
+  m_selectNodeName = upstream;
+  uint64_t p1 = joinAnswer.find("(");
+  uint64_t p2 = joinAnswer.find(")");
+  m_prePathID = m_myPathID;
+  m_myPathID = joinAnswer.substr(p1+1, p2-p1-1);
+  std::cout << m_prefix.toUri() <<" ----- REJOIN Id----  " << m_myPathID << std::endl;
+  reJoinAsk = false;
+  m_graftAsked.clear();
+
+  m_selectNodeFace = std::to_string(GetFibFace(m_selectNodeName));
+
+  RelabelChildren();
+  if(m_detectFailureSeqData.size() != 0) {
+    CheckFailSeq();
+  };
+
+  //reply to previous upstream nei
+  if(m_upNodeFail) {
+    ReplyData("Change-OK", m_interestOfUpfail);
+    m_interestOfUpfail="";
+    m_upNodeFail=false;
+  };
 };
 
 void
@@ -469,7 +585,14 @@ WqReducer::ProcessRejoinInterest()
   m_askRejoinNeiName = m_pendingInterestName.toUri().substr(u3+7, u1-u3-8);
   // std::cout << m_prefix.toUri() <<" receive tree Id= " << treeId <<std::endl;
   std::map<std::string, std::string>::iterator t = m_jobRefMap.find(treeId);
-  if(t != m_jobRefMap.end()) 
+  std::string summary = WqPathLabel::SubtreeFromName(m_pendingInterestName.toUri());
+  if(t != m_jobRefMap.end() && !summary.empty() && WqPathLabel::IsWithin(m_myPathID, summary))
+  {
+    //we hang below the subtree that asks, taking it would close a loop
+    std::cout << m_prefix.toUri() << " inside the rejoining subtree " << summary << std::endl;
+    ReplyRejoinInterest("none");
+  }
+  else if(t != m_jobRefMap.end()) 
   {
     //downstream job neis=0, meaning this node leave job tree before, it needs to re-connect before rely to rejoin-node
     if(t->second == "0")
@@ -671,50 +794,7 @@ WqReducer::ProcessDataBySeq(std::string startProcessId)
             AddSeqData(rxSeq, rawData);
             if (reJoinAsk == false) 
             {
-              //to make sure the node has other possible up-neis
-              if(m_neiReachable.size() > 1)
-              {
-                std::map<std::string, std::string>::iterator findLink;
-                for(findLink=m_neiReachable.begin(); findLink != m_neiReachable.end(); ++findLink) 
-                {
-                  if(findLink->first != checkNeiLink) {
-                    uint64_t t = findLink->first.find_last_of("/");
-                    std::string treeId= findLink->first.substr(t);
-                    if(treeId == m_currentTreeFlag) 
-                    {
-                      std::cout<< m_prefix.toUri() << " potential nei to current user: " << findLink->first << std::endl;
-                      uint64_t s1 = findLink->first.find("-");
-                      uint64_t s2 = findLink->first.find_last_of("/");
-                      std::string upNeiName = findLink->first.substr(s1+1, s2-s1-1);
-
-                      // if the nei is a direct child-node, do not send rejoin-request
-                      if(std::find(m_nodeList4Task.begin(), m_nodeList4Task.end(), upNeiName) != m_nodeList4Task.end()) {
-                        std::cout<< m_prefix.toUri() << " Potential nei is a child-node, not qualified == " << upNeiName << std::endl;
-                      }
-                      else {
-                        std::string changeNeiInterest = upNeiName + "/rejoin-" + m_prefix.toUri() + "/TS" + m_currentTreeFlag + "/TE-";
-                        std::cout<< m_prefix.toUri() << " changeUpNeiInterest: " << changeNeiInterest << std::endl;
-                        SendOutInterest(changeNeiInterest);
-                        reJoinAsk = true;
-                        m_sendRejoinNum++;
-                        m_possibleRejoinNeis.insert(std::pair<std::string, std::string>(upNeiName,"0"));
-                      };
-                      if(m_sendRejoinNum == 0) {
-                        std::cout<< m_prefix.toUri() << " has no up-nei to rejoin" << std::endl;
-                        for(uint64_t i=0; i<m_nodeList4Task.size(); i++) {
-                          std::string tellDownNei = m_nodeList4Task[i] + "/Upfail-" + "/TS" + m_currentTreeFlag + "/TE-";
-                          SendOutInterest(tellDownNei);
-                          reJoinAsk = true;
-                        }
-                        
-                      };
-                    };
-                  };
-                };
-              }
-              else {
-                std::cout<< m_prefix.toUri() << " has NO other routes... " << std::endl;
-              };  
+              RejoinTreeDueToUpNeiFail();
             }
             else if (reJoinAsk == true) 
             {
@@ -761,7 +841,10 @@ WqReducer::AssignNodeIdByPath(std::string receiveIds, std::string treeId)
     };
     std::map<std::string, std::string>::iterator checkId = m_nodePathId.find(assignId);
     if(checkId == m_nodePathId.end()) {
-      assignId = receiveIds + "-" + assignId;
+      assignId = WqPathLabel::Child(receiveIds, i);
+      if(assignId.empty()) {
+        std::cout << m_prefix.toUri() << " path label limit reached for " << m_nodeList4Task[j] << std::endl;
+      };
       m_nodePathId.insert(std::pair<std::string, std::string>(m_nodeList4Task[j], assignId));
     }
     else {
@@ -785,6 +868,134 @@ WqReducer::AssignNodeIdByPath(std::string receiveIds, std::string treeId)
       std::cout << m_prefix.toUri() << " assign pathID: " << assignPathId << std::endl;
     };
   };
+
+  // keep our place on this tree for the next job on the same topology
+  m_treeCache.SetPath(m_treeCacheDir, m_prefix.toUri(), treeId);
+  if(m_treeCache.IsEnabled())
+  {
+    m_treeCache.Clear();
+    m_treeCache.Set("parent", m_selectNodeName);
+    m_treeCache.Set("face", m_selectNodeFace);
+    m_treeCache.Set("pathId", receiveIds);
+    m_treeCache.Set("children", WqTreeCache::JoinNames(m_nodeList4Task));
+    for(uint64_t l=0; l<m_nodeList4Task.size(); l++)
+    {
+      m_treeCache.Set("id" + m_nodeList4Task[l], m_nodePathId[m_nodeList4Task[l]]);
+      m_treeCache.Set("local" + m_nodeList4Task[l], m_neiLocalId[m_nodeList4Task[l]]);
+    };
+    m_treeCache.Save(GetTopologyFingerprint(treeId));
+  };
+};
+
+void
+WqReducer::ProcessWarmInterest(std::string warmName)
+{
+  uint64_t s1 = warmName.find("/warm(");
+  uint64_t s2 = warmName.find(")", s1);
+  uint64_t f1 = warmName.find("/from<");
+  uint64_t f2 = warmName.find(">", f1);
+  std::string pathId = warmName.substr(s1+6, s2-s1-6);
+  std::string from = warmName.substr(f1+6, f2-f1-6);
+
+  // the cached place only holds if the topology, the parent and our path id are all unchanged
+  bool busy = (m_currentTreeFlag != "000" && m_currentTreeFlag != m_treeTag) || m_warmPending != 0;
+  m_treeCache.SetPath(m_treeCacheDir, m_prefix.toUri(), m_treeTag);
+  std::vector<std::string> children;
+  if(!busy && m_jobRefMap.find(m_treeTag) == m_jobRefMap.end()
+     && m_treeCache.Load(GetTopologyFingerprint(m_treeTag)))
+  {
+    children = WqTreeCache::SplitNames(m_treeCache.Get("children"));
+  };
+  if(children.size() == 0 || m_treeCache.Get("parent") != from || m_treeCache.Get("pathId") != pathId)
+  {
+    std::cout << m_prefix.toUri() << " refuse warm start: " << warmName << std::endl;
+    ReplyData("nope", warmName);
+    return;
+  };
+
+  m_currentTreeFlag = m_treeTag;
+  m_selectNodeName = from;
+  m_selectNodeFace = m_treeCache.Get("face");
+  m_myPathID = pathId;
+  m_neiReachable[m_prefix.toUri() + from + m_treeTag] = "true";
+  m_jobRefNei = "0";
+  m_nodeList4Task.clear();
+  jobNeiChangeFlag = true;
+  for(uint64_t j=0; j<children.size(); j++)
+  {
+    m_neiReachable[m_prefix.toUri() + children[j] + m_treeTag] = "true";
+    m_neiLocalId[children[j]] = m_treeCache.Get("local" + children[j]);
+    m_nodePathId[children[j]] = m_treeCache.Get("id" + children[j]);
+    m_jobRefNei += children[j];
+  };
+  m_jobRefMap[m_treeTag] = m_jobRefNei;
+  m_warmTree = m_treeTag;
+
+  m_warmInterest = warmName;
+  m_warmOk = true;
+  m_warmPending = children.size();
+  for(uint64_t j=0; j<children.size(); j++)
+  {
+    std::string warm = children[j] + "/TS" + m_treeTag + "/TE-" + "/warm(" + m_nodePathId[children[j]]
+                       + ")-/from<" + m_prefix.toUri() + ">-";
+    std::cout << m_prefix.toUri() << " forward warm start: " << warm << std::endl;
+    SendOutInterest(warm);
+    Simulator::Cancel(m_warmEvent);
+    m_warmEvent = Simulator::Schedule(MilliSeconds(GetClassLifetime(warm).count()),
+                                      &WqReducer::WarmRoundTimeout, this);
+  };
+};
+
+void
+WqReducer::FinishWarmRound()
+{
+  Simulator::Cancel(m_warmEvent);
+  m_warmPending = 0;
+  if(!m_warmOk)
+  {
+    DropWarmState(m_treeTag);
+  }
+  ReplyData(m_warmOk ? "yes" : "nope", m_warmInterest);
+  m_warmInterest = "";
+};
+
+void
+WqReducer::WarmRoundTimeout()
+{
+  if(m_warmPending == 0)
+  {
+    return;
+  };
+  std::cout << m_prefix.toUri() << " warm start timed out, " << m_warmPending << " children silent" << std::endl;
+  m_warmOk = false;
+  FinishWarmRound();
+};
+
+void
+WqReducer::DropWarmState(std::string treeId)
+{
+  std::cout << m_prefix.toUri() << " drop warm state of tree " << treeId << std::endl;
+  std::vector<std::string> children;
+  std::map<std::string, std::string>::iterator fUser = m_jobRefMap.find(treeId);
+  if(fUser != m_jobRefMap.end())
+  {
+    children = WqTreeCache::SplitNames(fUser->second);
+  };
+  for(uint64_t j=0; j<children.size(); j++)
+  {
+    m_neiReachable.erase(m_prefix.toUri() + children[j] + treeId);
+  };
+  m_neiReachable.erase(m_prefix.toUri() + m_selectNodeName + treeId);
+  m_backupParents.Clear(treeId);
+  m_jobRefMap.erase(treeId);
+  m_jobRefNei = "0";
+  m_nodeList4Task.clear();
+  for(uint64_t j=0; j<children.size(); j++)
+  {
+    m_neiLocalId.erase(children[j]);
+    m_nodePathId.erase(children[j]);
+  };
+  m_warmTree = "";
 };
 
 void 
@@ -828,46 +1039,78 @@ WqReducer::AddLostNeiId(std::string lostNodeName)
 };
 
 void 
-WqReducer::LinkBroken(std::string upNode, std::string downNode)
+WqReducer::OnNeighbourLinkChange(const std::string& name, bool up)
 {
-  if(upNode == "/2-" && downNode == "/4-")
-  {
-    std::string changeLink = "/4-/2-/0-";
-    if (excute1Fail == false) {
-      std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-      if (l != m_neiReachable.end()) {
-        l->second = "false";
-      };
-      excute1Fail = true;
+  if(!up) {
+    HandleLostNeighbour(name);
+  };
+};
+
+void 
+WqReducer::HandleLostNeighbour(const std::string& name)
+{
+  // every link of ours through that neighbour is gone
+  std::string linkPrefix = m_prefix.toUri() + name;
+  std::map<std::string, std::string>::iterator l;
+  for(l=m_neiReachable.begin(); l != m_neiReachable.end(); ++l) {
+    if(l->first.compare(0, linkPrefix.size(), linkPrefix) == 0) {
+      l->second = "false";
     };
-  }
-  else if(upNode == "/4-" && downNode == "/7-")
+  };
+  m_heartbeat.Forget(name);
+  //drop the neighbour from the job lists before the next task goes out
+  CheckNeiConnect();
+  //upstream lost: look for another one now instead of waiting for an Upfail notice
+  if(name == m_selectNodeName && m_jobRefMap.find(m_currentTreeFlag) != m_jobRefMap.end() && reJoinAsk == false) {
+    m_sendRejoinNode = m_prefix.toUri();
+    RejoinTreeDueToUpNeiFail();
+  };
+};
+
+void 
+WqReducer::HeardFrom(const std::string& peer)
+{
+  // only selected tree links are watched, traffic from other neighbours proves nothing we need
+  std::map<std::string, std::string>::iterator l = m_neiReachable.find(m_prefix.toUri() + peer + m_currentTreeFlag);
+  if(m_heartbeatInterval.IsZero() || l == m_neiReachable.end() || l->second != "true") {
+    return;
+  };
+  m_heartbeat.Heard(peer);
+  if(!m_heartbeatEvent.IsRunning()) {
+    m_heartbeat.SetInterval(m_heartbeatInterval);
+    m_heartbeatEvent = Simulator::Schedule(m_heartbeatInterval, &WqReducer::HeartbeatTick, this);
+  };
+};
+
+void 
+WqReducer::HeartbeatTick()
+{
+  bool watching = false;
+  std::vector<std::string> peers = m_heartbeat.GetPeers();
+  for(uint64_t i=0; i<peers.size(); i++)
   {
-    std::string changeLink = "/7-/4-/0-";
-    if (excute2Fail == false) {
-      std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-      if (l != m_neiReachable.end()) {
-        l->second = "false";
-      };
-      excute2Fail = true;
+    std::map<std::string, std::string>::iterator l = m_neiReachable.find(m_prefix.toUri() + peers[i] + m_currentTreeFlag);
+    if(l == m_neiReachable.end() || l->second != "true") {
+      m_heartbeat.Forget(peers[i]);
+      continue;
     };
-  }
-  else if(upNode == "/20-" && downNode == "/16-")
-  {
-    std::string changeLink = "/16-/20-/0-";
-    std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-    if (l != m_neiReachable.end()) {
-      l->second = "false";
+    double phi = m_heartbeat.Phi(peers[i]);
+    if(phi > m_phiThreshold) {
+      // links still up but nothing from the app: crashed or hung
+      std::cout << m_prefix.toUri() << " suspect " << peers[i] << " phi= " << phi << std::endl;
+      HandleLostNeighbour(peers[i]);
+      continue;
     };
-  }
-  else if(upNode == "/5-" && downNode == "/13-")
-  {
-    std::string changeLink = "/13-/5-/0-";
-    std::map<std::string, std::string>::iterator l = m_neiReachable.find(changeLink);
-    if (l != m_neiReachable.end()) {
-      l->second = "false";
+    watching = true;
+    if(m_heartbeat.Silence(peers[i]) >= m_heartbeatInterval) {
+      // no task or data from it for a whole interval, ask explicitly
+      SendOutInterest(peers[i] + "/hb-" + m_prefix.toUri());
     };
-  }
+  };
+  // nothing left to watch: stay idle until tree traffic arms the timer again
+  if(watching) {
+    m_heartbeatEvent = Simulator::Schedule(m_heartbeatInterval, &WqReducer::HeartbeatTick, this);
+  };
 };
 
 void
@@ -910,28 +1153,20 @@ WqReducer::CheckFailSeq()
 };
 
 void
-WqReducer::NotifyPathIdChange()
+WqReducer::RelabelChildren()
 {
-  for(uint64_t j=0; j<m_nodeList4Task.size(); j++)
+  // no Interest here, each child reads our label on the next task it gets from us
+  std::map<std::string, std::string>::iterator update;
+  for(update=m_nodePathId.begin(); update!=m_nodePathId.end(); update++)
   {
-    std::map<std::string, std::string>::iterator local = m_neiLocalId.find(m_nodeList4Task[j]);
+    std::map<std::string, std::string>::iterator local = m_neiLocalId.find(update->first);
     if(local != m_neiLocalId.end()) 
     {
-      std::map<std::string, std::string>::iterator update = m_nodePathId.find(m_nodeList4Task[j]);
-      if(update != m_nodePathId.end()) {
-        update->second = m_myPathID + "-" + local->second;
-        // std::cout << m_prefix.toUri() << " update: " << m_nodeList4Task[j] << " with NEW-id= " << update->second << std::endl;
-        std::string updatePathId = m_nodeList4Task[j] + "/TS" + m_currentTreeFlag + "/TE-" + "/updateId("
-                          + update->second + ")-";
-        SendOutInterest(updatePathId);
-        std::cout << m_prefix.toUri() << " send UPDATE pathID: " << updatePathId << std::endl;
-      }
-      else {
-        std::cout << m_prefix.toUri() << " CANNOT find PreviousPathId of: " << m_nodeList4Task[j] << std::endl;
-      };
+      update->second = WqPathLabel::Child(m_myPathID, std::stoul(local->second));
+      std::cout << m_prefix.toUri() << " relabel: " << update->first << " with NEW-id= " << update->second << std::endl;
     }
     else {
-      std::cout << m_prefix.toUri() << " CANNOT find LocalId of: " << m_nodeList4Task[j] << std::endl;
+      std::cout << m_prefix.toUri() << " CANNOT find LocalId of: " << update->first << std::endl;
     };
   }
 };
@@ -1018,6 +1253,18 @@ WqReducer::ProcessNormalInterest(shared_ptr<const Interest> taskInterest)
 {
   m_pendingInterestName = taskInterest->getName();
   // m_taskInterestName = m_pendingInterestName.toUri();
+  // lazy relabel: the upstream label carried by the task tells us if a rejoin above moved us
+  std::string upLabel = WqPathLabel::FromName(m_pendingInterestName.toUri());
+  if(!upLabel.empty() && upLabel != WqPathLabel::Parent(m_myPathID))
+  {
+    std::string newId = WqPathLabel::Rebase(m_myPathID, upLabel);
+    if(!newId.empty())
+    {
+      std::cout << m_prefix.toUri() << " relabel from " << m_myPathID << " to " << newId << std::endl;
+      m_myPathID = newId;
+      RelabelChildren();
+    }
+  }
   uint64_t s1 = m_pendingInterestName.toUri().find("(");
   uint64_t s2 = m_pendingInterestName.toUri().find(")");
   std::string seqNum = m_pendingInterestName.toUri().substr(s1+1, s2-s1-1);
@@ -1081,7 +1328,7 @@ WqReducer::ProcessNormalInterest(shared_ptr<const Interest> taskInterest)
               m_receiveNodeandData.insert(std::pair<std::string, std::string>(m_nodeList4Task[s], ""));
             };
 
-            std::string creatTask = m_nodeList4Task[s] + m_assignTask + "-";
+            std::string creatTask = m_nodeList4Task[s] + m_assignTask + WqPathLabel::Tag(m_myPathID) + "-";
             std::cout << m_prefix.toUri() << " creat: " << creatTask << std::endl; 
             shared_ptr<Name> mapTaskName = make_shared<Name>(creatTask);
             mapTaskName->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
@@ -1136,6 +1383,9 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
   uint64_t clear = m_pendingInterestName.toUri().find("clear");
   uint64_t backTree = m_pendingInterestName.toUri().find("backTree");
   uint64_t upNeiFail = m_pendingInterestName.toUri().find("Upfail");
+  uint64_t warm = m_pendingInterestName.toUri().find("/warm(");
+  uint64_t hb = m_pendingInterestName.toUri().find("/hb-");
+  uint64_t graft = m_pendingInterestName.toUri().find("/graft-");
   
   //get current userId
   uint64_t t1 = m_pendingInterestName.toUri().find("TS");
@@ -1151,10 +1401,17 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
   {
     //check if discovery procedure already done for current userId
     std::map<std::string, std::string>::iterator userIdIter = m_jobRefMap.find(m_treeTag);
+    if(userIdIter != m_jobRefMap.end() && m_warmTree == m_treeTag)
+    {
+      //the sink fell back to discovery, our warm-restored place is rebuilt as well
+      DropWarmState(m_treeTag);
+      userIdIter = m_jobRefMap.end();
+    }
     if(userIdIter != m_jobRefMap.end())
     {
-      //discovery done
+      //discovery done, answer at once so the sender does not wait for us
       std::cout <<"Report discovery done"<<std::endl;
+      ReplyData("nope", m_pendingInterestName.toUri());
     }
     else 
     {
@@ -1165,42 +1422,39 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
 
       if (m_currentTreeFlag == m_treeTag) 
       {
-        //check if get upstream node from fib
-        std::map<std::string, std::string>::iterator fibIter = m_fibResult.find(m_treeTag);
-        //not found
-        if(fibIter == m_fibResult.end())
+        // decided locally instead of "/f-" and "/p-" rounds: the sender is the upstream
+        // only if it is the neighbour on our FIB next hop towards the tree root
+        std::string disName = m_pendingInterestName.toUri();
+        uint64_t p1 = disName.find_first_of("-");
+        uint64_t p2 = disName.find("/discover");
+        std::string sender = disName.substr(p1+1, p2-p1-1);
+        uint64_t parentFace = 0;
+        if (sender != GetTreeParent(m_treeTag, parentFace))
         {
-          m_fibResult.insert(std::pair<std::string, std::string>(m_treeTag,"0"));
-          m_buildTreeInterestMap.insert(std::pair<std::string, std::string>(m_pendingInterestName.toUri(),"0"));
-          //send Interest to ask FIB nexthop face
-          m_askFibPrefix = "/f-";
-          std::string tempAskFib = m_askFibPrefix + m_treeTag;
-          // std::cout << "Reducer " << m_prefix.toUri() << " tempAskFib: "<< tempAskFib <<std::endl;
-          shared_ptr<Name> askFibName = make_shared<Name>(tempAskFib);
-          shared_ptr<Interest> askFibInterest = make_shared<Interest>();
-          askFibInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-          askFibInterest->setName(*askFibName);
-          askFibInterest->setInterestLifetime(ndn::time::seconds(1));
-          m_transmittedInterests(askFibInterest, this, m_face);
-          m_appLink->onReceiveInterest(*askFibInterest);
-          //std::cout<< "go for fib round" <<std::endl;
+          //add this node to check-nei-table as potential nei if select-nei link is broken
+          std::string taskNei = m_prefix.toUri() + sender + m_treeTag;
+          m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "false"));
+          m_backupParents.Offer(m_treeTag, sender, GetRouteCostVia(m_treeTag, sender));
+          ReplyData("nope", disName);
         }
-        //get fib info already
         else
         {
-          m_askPitPrefix = "/p-";
-          m_buildTreeInterestMap.insert(std::pair<std::string, std::string>(m_pendingInterestName.toUri(),"0"));
-          std::string tempAskPit = m_askPitPrefix + m_pendingInterestName.toUri();
-          //std::cout << m_prefix.toUri() <<"tempAskPit: "<< tempAskPit <<std::endl;
-          shared_ptr<Name> askPitName = make_shared<Name>(tempAskPit);
-          //subBtInterest->appendSequenceNumber(m_rand->GetValue(0, std::numeric_limits<uint16_t>::max()));
-          shared_ptr<Interest> askPitInterest = make_shared<Interest>();
-          askPitInterest->setNonce(m_rand->GetValue(0, std::numeric_limits<uint32_t>::max()));
-          askPitInterest->setName(*askPitName);
-          askPitInterest->setInterestLifetime(ndn::time::seconds(1));
-          m_transmittedInterests(askPitInterest, this, m_face);
-          m_appLink->onReceiveInterest(*askPitInterest);
-          m_askPitNum++;
+          m_selectUpstream = disName;
+          m_selectNodeFace = std::to_string(parentFace);
+          m_selectNodeName = sender;
+          //add selecet-upstream to check-nei-table
+          std::string taskNei = m_prefix.toUri() + m_selectNodeName + m_treeTag;
+          std::cout << m_prefix.toUri() << " taskNei: " << taskNei << std::endl;
+          m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "true"));
+          m_repliedUpstream = false;
+          if (m_oneHopNeighbours.size() != 0)
+          {
+            DiscoverDownstreams();
+          }
+          else
+          {
+            FindNeighbours();
+          }
         }
       }
       else
@@ -1372,14 +1626,7 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
       int control = std::stoi(hopNum) + 1;
       // int control = 4;
       std::string myhopNum = std::to_string(control);
-      std::string subId = doubtNodeId;
-      for(int j=1; j<control; j++)
-      {
-        uint64_t c = subId.find_first_of("-");
-        subId = subId.substr(c+1);
-        // std::cout <<  "j= " << j << " /// sub_id " << subId << std::endl;
-      };
-      std::string neiId = subId.substr(0,1);
+      std::string neiId = std::to_string(WqPathLabel::IndexAt(doubtNodeId, control-1));
       bool search = false;
       std::map<std::string, std::string>::iterator searchid;
       for(searchid=m_neiLocalId.begin(); searchid!=m_neiLocalId.end(); searchid++)
@@ -1544,14 +1791,7 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
       std::string hopNum = interest->getName().toUri().substr(h1+3, h2-h1-3);
       int control = std::stoi(hopNum) + 1;
       std::string myhopNum = std::to_string(control);
-      std::string subId = ignoreNodeId;
-      for(int j=1; j<control; j++)
-      {
-        uint64_t c = subId.find_first_of("-");
-        subId = subId.substr(c+1);
-        // std::cout <<  "j= " << j << " /// sub_id " << subId << std::endl;
-      };
-      std::string neiId = subId.substr(0,1);
+      std::string neiId = std::to_string(WqPathLabel::IndexAt(ignoreNodeId, control-1));
       bool search = false;
       std::map<std::string, std::string>::iterator searchid;
       for(searchid=m_neiLocalId.begin(); searchid!=m_neiLocalId.end(); searchid++)
@@ -1665,19 +1905,40 @@ WqReducer::OnInterest(shared_ptr<const Interest> interest)
     std::cout << m_prefix.toUri() << " pre-link=  " << cancelUpLink << std::endl;
     m_sendRejoinNode = m_prefix.toUri();
     m_upNodeFail=true;
-    RejoinTreeDueToUpNeiFail(cancelUpLink);
+    RejoinTreeDueToUpNeiFail();
+  }
+  // upstream lost its way to the tree and asks us to carry its subtree
+  else if(graft != std::string::npos)
+  {
+    std::cout << m_prefix.toUri() << " receive  " << m_pendingInterestName.toUri() << std::endl;
+    ProcessGraftInterest(m_pendingInterestName.toUri());
+  }
+  // sink confirms the cached tree instead of discovering it again
+  else if(warm != std::string::npos)
+  {
+    ProcessWarmInterest(m_pendingInterestName.toUri());
+  }
+  // beacon of a tree neighbour that has not heard from us for a while
+  else if(hb != std::string::npos)
+  {
+    std::string hbName = m_pendingInterestName.toUri();
+    uint64_t e = hbName.find("-", hb+4);
+    HeardFrom(hbName.substr(hb+4, e-hb-3));
+    ReplyData("alive", hbName);
   }
   //normal Interest
   else 
-  { 
-    // Simulator::Schedule(Seconds(63), &WqReducer::LinkBroken, this, "/2-", "/4-");
-      // Simulator::Schedule(Seconds(62), &WqReducer::LinkBroken, this, "/4-", "/7-");
-    // Simulator::Schedule(Seconds(49), &WqReducer::LinkBroken, this, "/20-", "/16-");
-    // Simulator::Schedule(Seconds(69), &WqReducer::LinkBroken, this, "/5-", "/13-");
+  {
     std::cout << m_prefix.toUri() <<" get normal Interest: " << m_pendingInterestName.toUri() <<std::endl;
-    m_normalInterest = interest;
-    std::string requestPit = "/p-" + m_pendingInterestName.toUri();
-    SendOutInterest(requestPit);
+    m_warmTree = "";
+    HeardFrom(m_selectNodeName);
+    if(m_sendDisDownNeiNum != 0)
+    {
+      // already on the tree but children still answering, hold the task until the list is complete
+      m_deferredTasks.push_back(interest);
+      return;
+    }
+    ServeTasks(std::vector<shared_ptr<const Interest>>(1, interest));
   }
 };
 
@@ -1703,15 +1964,78 @@ WqReducer::OnData(shared_ptr<const Data> data)
     uint64_t findRejoin = gotData.find("rejoin");
     uint64_t findCancel = gotData.find("Cancel");
     uint64_t p = gotData.find("pathID");
-    uint64_t u = gotData.find("update");
     uint64_t doubt = gotData.find("doubt");
     uint64_t process = gotData.find("process");
     uint64_t resend = gotData.find("resend");
     uint64_t leave = gotData.find("leave");
     uint64_t reconnect = gotData.find("backTree");
     uint64_t upNeiFail = gotData.find("Upfail");
+    uint64_t warm = gotData.find("/warm(");
+    uint64_t hb = gotData.find("/hb-");
+    uint64_t graft = gotData.find("/graft-");
+
+    // any Data a tree neighbour answers with is a heartbeat from it
+    std::string replier = gotData.substr(0, gotData.find_first_of("-")+1);
+    if(std::find(m_allNodeName.begin(), m_allNodeName.end(), replier) != m_allNodeName.end())
+    {
+      HeardFrom(replier);
+    }
 
-    if(findDis != std::string::npos && gotData[1] != 'p')
+    if(hb != std::string::npos)
+    {
+      // beacon answered, already counted above
+    }
+    else if(graft != std::string::npos)
+    {
+      std::cout << m_prefix.toUri() <<" get Data: " << receivedData << " from " << gotData << std::endl;
+      if(replier != m_graftCandidate)
+      {
+        std::cout << m_prefix.toUri() <<" stale graft reply from " << replier << std::endl;
+        if(receivedData.find("Join-Success") != std::string::npos) {
+          SendOutInterest(replier + "/CancelJoin(" + m_prefix.toUri() + ")-");
+        };
+      }
+      else if(receivedData.find("Join-Success") == std::string::npos)
+      {
+        GraftChildFailed();
+      }
+      else
+      {
+        //the child is our upstream now, our other children keep us as theirs
+        Simulator::Cancel(m_rejoinEvent);
+        m_graftCandidate = "";
+        std::map<std::string, std::string>::iterator t = m_jobRefMap.find(m_currentTreeFlag);
+        if(t != m_jobRefMap.end())
+        {
+          std::string::size_type dn = t->second.find(replier);
+          if(dn != std::string::npos) {
+            t->second.erase(dn, replier.length());
+          };
+        };
+        jobNeiChangeFlag = true;
+        m_neiLocalId.erase(replier);
+        m_nodePathId.erase(replier);
+        AdoptUpstream(replier, receivedData);
+      };
+    }
+    // a reply after the round timed out is already counted as a refusal
+    else if(warm != std::string::npos)
+    {
+      if(m_warmPending == 0)
+      {
+        return;
+      }
+      m_warmPending--;
+      if(receivedData != "yes")
+      {
+        m_warmOk = false;
+      }
+      if(m_warmPending == 0)
+      {
+        FinishWarmRound();
+      }
+    }
+    else if(findDis != std::string::npos && gotData[1] != 'p')
     {
       m_gotDisDownNeiNum++;
       std::cout << m_prefix.toUri() <<" get Data: " << receivedData << " from " << data->getName().toUri() << std::endl;
@@ -1729,66 +2053,34 @@ WqReducer::OnData(shared_ptr<const Data> data)
           disDownIt->second = receivedData;
         }
       };
-      if(m_gotDisDownNeiNum == m_sendDisDownNeiNum)
+      // echo: the first child on the tree settles our membership, reply to upstream right away,
+      // children answering later only extend the local job list
+      if(receivedData == "yes")
       {
-        for(disDownIt =m_disDownNodeMap.begin(); disDownIt!=m_disDownNodeMap.end(); ++disDownIt)
-        {
-          if(disDownIt->second == "yes")
-          {
-            std::string downNei = m_prefix.toUri() + disDownIt->first + m_treeTag;
-            m_neiReachable.insert(std::pair<std::string, std::string>(downNei, "true"));
-            m_jobRefNei += disDownIt->first;
-            std::cout << m_prefix.toUri() <<" jobRef nei " << m_jobRefNei << std::endl;
-          }
-        };
-        //reply for upstream node
-        Name replyYesDataName(m_selectUpstream);
-        auto replyYesData = make_shared<Data>();
-        replyYesData->setName(replyYesDataName);
-        replyYesData->setFreshnessPeriod(::ndn::time::milliseconds(m_freshness.GetMilliSeconds()));
-        std::string rawData;
-
-        SignatureInfo signatureInfo(static_cast< ::ndn::tlv::SignatureTypeValue>(255));
-        if (m_keyLocator.size() > 0) {
-          signatureInfo.setKeyLocator(m_keyLocator);
-        }
-        replyYesData->setSignatureInfo(signatureInfo);
-        ::ndn::EncodingEstimator estimator;
-        ::ndn::EncodingBuffer encoder(estimator.appendVarNumber(m_signature), 0);
-        encoder.appendVarNumber(m_signature);
-        replyYesData->setSignatureValue(encoder.getBuffer());
-        NS_LOG_INFO("node(" << GetNode()->GetId() << ") responding with Data: " << replyYesData->getName());
-        
-        if(m_jobRefNei != "0")
+        std::string downNei = m_prefix.toUri() + receDownNode + m_currentTreeFlag;
+        m_neiReachable.insert(std::pair<std::string, std::string>(downNei, "true"));
+        m_jobRefNei += receDownNode;
+        m_jobRefMap[m_currentTreeFlag] = m_jobRefNei;
+        std::cout << m_prefix.toUri() <<" jobRef nei " << m_jobRefNei << std::endl;
+        if(!m_repliedUpstream)
         {
-          // store the downstrem nodes for current task
-          m_jobRefMap.insert(std::pair<std::string, std::string>(m_currentTreeFlag,m_jobRefNei));
-          
-          rawData ="yes";
-          const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-          auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
-          replyYesData->setContent(buffer);
-          replyYesData->wireEncode();
-          m_transmittedDatas(replyYesData, this, m_face);
-          m_appLink->onReceiveData(*replyYesData);
-          std::cout << m_prefix.toUri() << " reply " << rawData << " for " << m_selectUpstream << std::endl;
+          ReplyData("yes", m_selectUpstream);
+          m_repliedUpstream = true;
         }
-        else 
+      }
+      if(m_gotDisDownNeiNum == m_sendDisDownNeiNum)
+      {
+        if(!m_repliedUpstream)
         {
-          rawData = "nope";
-          const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-          auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
-          replyYesData->setContent(buffer);
-          replyYesData->wireEncode();
-          m_transmittedDatas(replyYesData, this, m_face);
-          m_appLink->onReceiveData(*replyYesData);
-          std::cout << m_prefix.toUri() << " reply NOPE for discover Interest: " << rawData << std::endl;
+          // no child on the tree
+          ReplyData("nope", m_selectUpstream);
         }
-
+        m_repliedUpstream = false;
         m_gotDisDownNeiNum = m_sendDisDownNeiNum =0;
         // m_currentTreeFlag = "";
         m_treeTag = "none";
         m_disDownNodeMap.clear();
+        ReplayDeferredTasks();
       }
     }
     //data for rejoin tree request
@@ -1803,99 +2095,42 @@ WqReducer::OnData(shared_ptr<const Data> data)
 
       if(m_prefix.toUri() == m_sendRejoinNode)
       {
-        m_gotRejoinNum++;
-        std::map<std::string, std::string>::iterator rejoinIter;
-        for(rejoinIter =m_possibleRejoinNeis.begin(); rejoinIter!=m_possibleRejoinNeis.end(); ++rejoinIter)
+        if(rejoinNeiNode != m_rejoinCandidate)
         {
-          // std::cout << m_prefix.toUri() << "iterator first " << rejoinIter->first << std::endl;
-          if(rejoinIter->first == rejoinNeiNode)
-          {
-            rejoinIter->second = receivedData;
-          }
-        };
-
-        if(m_gotRejoinNum == m_sendRejoinNum)
-        {
-          // for (auto& x: m_possibleRejoinNeis) {
-          //   std::cout << m_prefix.toUri() << " key= " << x.first << " value= " << x.second << '\n';
-          // };
-          std::vector<std::string> possibleRejoinNeis;
-          for(rejoinIter =m_possibleRejoinNeis.begin(); rejoinIter!=m_possibleRejoinNeis.end(); ++rejoinIter)
-          {
-            uint64_t j = rejoinIter->second.find("Join-Success");
-            if(j != std::string::npos)
-            {
-              std::cout << m_prefix.toUri() <<" rejoin-Success link= " << rejoinIter->first << std::endl;
-              possibleRejoinNeis.push_back(rejoinIter->first);
-            }
-            else
-            {
-              std::cout << m_prefix.toUri() <<" rejoin-Fail " << std::endl;
-            };
+          //late answer of a candidate we gave up on, do not leave it holding a place for us
+          std::cout << m_prefix.toUri() <<" stale rejoin reply from " << rejoinNeiNode << std::endl;
+          if(receivedData.find("Join-Success") != std::string::npos) {
+            std::string cancelReply = rejoinNeiNode + "/CancelJoin(" + m_prefix.toUri() + ")-";
+            SendOutInterest(cancelReply);
           };
-
-          if(possibleRejoinNeis.size() != 0) 
+        }
+        else if(receivedData.find("Join-Success") == std::string::npos)
+        {
+          RejoinCandidateFailed();
+        }
+        else
+        {
+          Simulator::Cancel(m_rejoinEvent);
+          m_rejoinCandidate = "";
+          std::string oldUpstream = m_selectNodeName;
+          AdoptUpstream(rejoinNeiNode, receivedData);
+          if(!m_graftInterest.empty())
           {
-            //if multiple neis available to rejoin current tree, choose only one and save others for future use
-            std::string rejoinLink = m_prefix.toUri() + possibleRejoinNeis[0] + m_currentTreeFlag;
-            std::cout << m_prefix.toUri() <<" FIND rejoin link= " << rejoinLink << std::endl;
-            std::map<std::string, std::string>::iterator findLink;
-            findLink = m_neiReachable.find(rejoinLink);
-            if(findLink != m_neiReachable.end()) 
-            {
-              findLink->second = "true";
+            //grafted: the old upstream and the rest of its subtree hang below us, untouched
+            std::map<std::string, std::string>::iterator t = m_jobRefMap.find(m_currentTreeFlag);
+            if(t == m_jobRefMap.end()) {
+              m_jobRefMap[m_currentTreeFlag] = "0" + oldUpstream;
             }
-            else {
-              m_neiReachable.insert(std::pair<std::string, std::string>(rejoinLink, "true"));
-            };
-            m_selectNodeName = possibleRejoinNeis[0];
-            uint64_t p1 = m_possibleRejoinNeis[m_selectNodeName].find("(");
-            uint64_t p2 = m_possibleRejoinNeis[m_selectNodeName].find(")");
-            m_prePathID = m_myPathID;
-            m_myPathID = m_possibleRejoinNeis[m_selectNodeName].substr(p1+1, p2-p1-1);
-            std::cout << m_prefix.toUri() <<" ----- REJOIN Id----  " << m_myPathID << std::endl;
-
-            std::string upNeiFace = "/f-" + m_selectNodeName + "/rejoin-";
-            SendOutInterest(upNeiFace);
-
-            NotifyPathIdChange();
-            if(m_detectFailureSeqData.size() != 0) {
-              CheckFailSeq();
-            };
-
-            //reply to previous upstream nei
-            if(m_upNodeFail) {
-              ReplyData("Change-OK", m_interestOfUpfail);
-              m_interestOfUpfail="";
-              m_upNodeFail=false;
-            };
-
-            if (possibleRejoinNeis.size() > 1) 
-            {
-              for (uint64_t i=1; i<possibleRejoinNeis.size(); i++) 
-              {
-                std::string secondRejoinLink = m_prefix.toUri() + possibleRejoinNeis[i] + m_currentTreeFlag;
-                findLink = m_neiReachable.find(secondRejoinLink);
-                if(findLink != m_neiReachable.end()) 
-                {
-                  findLink->second = "false";
-                }
-                else {
-                  m_neiReachable.insert(std::pair<std::string, std::string>(rejoinLink, "false"));
-                };
-
-                //except the select_up_nei, reply to other join-success neighbours to ignore
-                std::string cancelReply = possibleRejoinNeis[i] + "/CancelJoin(" + m_prefix.toUri() + ")-";
-                SendOutInterest(cancelReply);
-                std::cout << m_prefix.toUri() << " notify-Nei " << cancelReply << std::endl;
-              };
+            else if(t->second.find(oldUpstream) == std::string::npos) {
+              t->second += oldUpstream;
             };
-          }
-          else {
-            std::cout << m_prefix.toUri() <<" re-join tree fail, need a new rejoin round" << std::endl;
+            jobNeiChangeFlag = true;
+            m_neiReachable[m_prefix.toUri() + oldUpstream + m_currentTreeFlag] = "true";
+            NewJoinAssignId(oldUpstream);
+            ReplyData("Join-Success-/pathId(" + m_joinNeiPathId + ")", m_graftInterest);
+            m_joinNeiPathId = "";
+            m_graftInterest = "";
           };
-          m_gotRejoinNum = m_sendRejoinNum = 0;
-          m_possibleRejoinNeis.clear();
         };
       }
       else {
@@ -1953,7 +2188,7 @@ WqReducer::OnData(shared_ptr<const Data> data)
             else {
               m_neiReachable.insert(std::pair<std::string, std::string>(askRejoinLink, "true"));
             };
-            std::string pId = m_myPathID + "-" + "0";
+            std::string pId = WqPathLabel::Child(m_myPathID, 0);
             ReplyRejoinInterest(pId);
           }
           else {
@@ -1983,6 +2218,7 @@ WqReducer::OnData(shared_ptr<const Data> data)
           };
           m_gotDisDownNeiNum = m_sendDisDownNeiNum = 0;
           m_disDownNodeMap.clear();
+          ReplayDeferredTasks();
         };
       };
     }
@@ -2121,7 +2357,7 @@ WqReducer::OnData(shared_ptr<const Data> data)
       };
     }
     // reply from path-based ID
-    else if(p != std::string::npos || u != std::string::npos)
+    else if(p != std::string::npos)
     {
       m_countPathIdReply++;
       std::cout << m_prefix.toUri() << " got ACK: " << receivedData << std::endl;
@@ -2323,134 +2559,6 @@ WqReducer::OnData(shared_ptr<const Data> data)
     {
       switch(gotData[1])
       {
-        case 'p':
-        {
-          uint64_t discoverFace = gotData.find("discover");
-          if (discoverFace != std::string::npos) 
-          {
-            uint64_t tp = gotData.find_first_of("-");
-            std::string tempInName = gotData.substr(tp+1);
-            std::map<std::string, std::string>::iterator it = m_buildTreeInterestMap.find(tempInName);
-            //std::cout<<"tempInName " << tempInName << std::endl;
-            if(it != m_buildTreeInterestMap.end())
-            {
-              m_buildTreeInterestMap[tempInName] = receivedData;
-              m_gotPitNum++;
-            }
-            
-            if(m_askPitNum == m_gotPitNum)
-            {
-              std::map<std::string, std::string>::iterator fibIt = m_fibResult.find(m_treeTag);
-              std::string fibContent = fibIt->second; 
-              for(std::map<std::string, std::string>::iterator it=m_buildTreeInterestMap.begin(); it!=m_buildTreeInterestMap.end(); ++it)
-              {
-                // std::cout << m_prefix.toUri() << " 111 " << it->first << std::endl;
-                // std::cout << m_prefix.toUri() << " 222 " << it->second << std::endl;
-                if (it->second != fibContent)
-                {
-                  //add this node to check-nei-table as potential nei if select-nei link is broken
-                  uint64_t p1 = it->first.find_first_of("-");
-                  uint64_t p2 = it->first.find("/discover");
-                  std::string potentialNei = it->first.substr(p1+1, p2-p1-1);
-                  std::string taskNei =  m_prefix.toUri() + potentialNei + m_treeTag;
-                  // std::cout<<m_prefix.toUri() << " potential Nei: " << taskNei <<std::endl;
-                  m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "false"));
-
-                  // std::cout << m_prefix.toUri() << " 222 " << it->first << std::endl;
-                  std::string replyNackName = it->first;
-                  Name replyNackDataName(replyNackName);
-                  auto replyNackData = make_shared<Data>();
-                  replyNackData->setName(replyNackDataName);
-                  replyNackData->setFreshnessPeriod(::ndn::time::milliseconds(m_freshness.GetMilliSeconds()));
-                  std::string rawData("nope");
-                  const uint8_t* p = reinterpret_cast<const uint8_t*>(rawData.c_str());
-                  auto buffer = make_shared< ::ndn::Buffer>(p, rawData.size());
-                  replyNackData->setContent(buffer);
-              
-                  SignatureInfo signatureInfo(static_cast< ::ndn::tlv::SignatureTypeValue>(255));
-                  if (m_keyLocator.size() > 0) {
-                    signatureInfo.setKeyLocator(m_keyLocator);
-                  }
-                  replyNackData->setSignatureInfo(signatureInfo);
-                  ::ndn::EncodingEstimator estimator;
-                  ::ndn::EncodingBuffer encoder(estimator.appendVarNumber(m_signature), 0);
-                  encoder.appendVarNumber(m_signature);
-                  replyNackData->setSignatureValue(encoder.getBuffer());
-                  NS_LOG_INFO("node(" << GetNode()->GetId() << ") responding with Data: " << replyNackData->getName());
-
-                  // to create real wire encoding
-                  replyNackData->wireEncode();
-                  m_transmittedDatas(replyNackData, this, m_face);
-                  m_appLink->onReceiveData(*replyNackData);
-                  std::cout << m_prefix.toUri() << "R reply: " << rawData << " for: " << replyNackName << std::endl;
-                }
-                else 
-                {
-                  // map size = 1 && the face = FIBface, got the selected upstream, not reply immediately, continue explore downstreams
-                  m_selectUpstream = it->first;
-                  // std::cout<< "selected: " << m_selectUpstream <<std::endl;
-                  m_selectNodeFace = it->second;
-          
-                  //upstream node name
-                  uint64_t p1 = m_selectUpstream.find_first_of("-");
-                  uint64_t p2 = m_selectUpstream.find("/discover");
-                  m_selectNodeName = m_selectUpstream.substr(p1+1, p2-p1-1);
-                  // std::cout<<m_prefix.toUri() << " selected: " << m_selectNodeName <<std::endl;
-
-                  //add selecet-upstream to check-nei-table
-                  std::string taskNei =  m_prefix.toUri() + m_selectNodeName + m_treeTag;
-                  std::cout<<m_prefix.toUri() << " taskNei: " << taskNei <<std::endl;
-                  m_neiReachable.insert(std::pair<std::string, std::string>(taskNei, "true"));
-                  
-                  //initiate new round to ask one-hop neighbour
-                  if (m_oneHopNeighbours.size() != 0)
-                  {
-                    //send interests to one-hop to discover tree
-                    DiscoverDownstreams(); 
-                  }
-                  else 
-                  {
-                    FindNeighbours();
-                  }
-                  
-                }
-              }
-            }
-            m_buildTreeInterestMap.clear();
-          }
-          else {
-            // std::cout << m_prefix.toUri() <<" select upNei Face= " << receivedData << std::endl; 
-            if (receivedData == m_selectNodeFace)
-            {
-              ProcessNormalInterest(m_normalInterest);
-            }
-            else {
-              ReplyData("Ignore", m_normalInterest->getName().toUri());
-            };
-          };
-          break;
-        }
-        
-        case 'f':
-        {
-          uint64_t rejoinFace = gotData.find("rejoin");
-          if (rejoinFace == std::string::npos) {
-            //std::cout <<m_prefix.toUri() << "fib data: " << receivedData <<std::endl;
-            std::map<std::string, std::string>::iterator fibIter1 = m_fibResult.find(m_treeTag);
-            if(fibIter1 != m_fibResult.end())
-            {
-              fibIter1->second = receivedData;
-              QueryPit();
-            };
-          }
-          else {
-            //get FaceId of rejoin up-nei 
-            m_selectNodeFace = receivedData;
-            
-          };
-          break;
-        }
-        
         case 'n':
         {
           uint64_t d1 = gotData.find("-");
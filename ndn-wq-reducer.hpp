@@ -23,6 +23,10 @@
 #include "ns3/ndnSIM/model/ndn-common.hpp"
 #include "ns3/random-variable-stream.h"
 #include "ndn-app.hpp"
+#include "ndn-wq-tree-cache.hpp"
+#include "ndn-wq-path-label.hpp"
+#include "ndn-wq-heartbeat.hpp"
+#include "ndn-wq-backup-parents.hpp"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include <deque>
@@ -50,6 +54,9 @@ public:
   // inherited from NdnApp
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
+
+  virtual int64_t
+  AssignStreams(int64_t stream);
   // From App
   virtual void
   OnData(shared_ptr<const Data> contentObject);
@@ -57,7 +64,11 @@ public:
 public:
   void FindNeighbours();
   void DiscoverDownstreams();
-  void QueryPit();
+  void ReplayDeferredTasks();
+  void ProcessWarmInterest(std::string warmName);
+  void DropWarmState(std::string treeId);
+  void FinishWarmRound();
+  void WarmRoundTimeout();
   void CheckNeiConnect();
   void ReplyRejoinInterest(std::string pathId);
   void ProcessRejoinInterest();
@@ -72,15 +83,24 @@ public:
   void ProcessTaskNeis(std::string neiString);
   void AddLostNeiId(std::string lostNodeName);
   void NewJoinAssignId(std::string joinNode);
-  void LinkBroken(std::string upNode, std::string downNode);
   void AddSeqData(std::string seqnum, std::string seqdata);
   void CheckFailSeq();
-  void NotifyPathIdChange();
+  void RelabelChildren();
   void LeaveJobTree();
   void ClearHistorySaveData(std::string seqList);
   void ForwardClearDataSignal(std::string clearMessage);
   void ProcessNormalInterest(shared_ptr<const Interest> taskInterest);
-  void RejoinTreeDueToUpNeiFail(std::string preChooseLink);
+  void ServeTasks(const std::vector<shared_ptr<const Interest>>& tasks);
+  void RejoinTreeDueToUpNeiFail();
+  bool AskNextBackupParent();
+  void RejoinCandidateFailed();
+  bool AskNextGraftChild();
+  void GraftChildFailed();
+  void ProcessGraftInterest(std::string graftName);
+  void AdoptUpstream(std::string upstream, std::string joinAnswer);
+  void HandleLostNeighbour(const std::string& name);
+  void HeardFrom(const std::string& peer);
+  void HeartbeatTick();
 
 
 protected:
@@ -90,6 +110,9 @@ protected:
   virtual void
   StopApplication(); // Called at time specified by Stop
 
+  virtual void
+  OnNeighbourLinkChange(const std::string& name, bool up);
+
 
 private:
   Ptr<UniformRandomVariable> m_rand;
@@ -104,11 +127,6 @@ private:
 
   std::string m_taskInterestName;
   Name m_pendingInterestName;
-  std::map<std::string, std::string> m_buildTreeInterestMap;
-  std::string m_askPitPrefix;
-  std::string m_askFibPrefix;
-  int m_askPitNum=0;
-  int m_gotPitNum=0;
   std::string m_selectUpstream;
   std::vector<std::string> m_oneHopNeighbours;
   int m_sendDisNeiNum=0;
@@ -130,7 +148,6 @@ private:
   std::string m_assignTask;
   std::string m_reduceFunc;
   std::vector<std::string> m_upDisNodes;
-  std::map<std::string, std::string> m_fibResult;
   std::map<std::string, std::string> m_neiReachable;
   std::string m_selectNodeName = "";
   std::string m_selectNodeFace;
@@ -153,21 +170,32 @@ private:
   std::string m_joinNeiPathId;
   std::map<std::string, std::string> m_neiLocalId; //(nodeName, id)
   std::map<std::string, std::string> m_lostNeiIdRecords; //(nodeName, id)
-  bool excute1Fail = false;
-  bool excute2Fail = false;
   bool reJoinAsk = false;
   bool m_detectLinkFailure = false;
   std::map<std::string, std::string> m_detectFailureSeqData;
-  std::map<std::string, std::string> m_possibleRejoinNeis; //(one-hop-nei-name, reply-content)
-  int m_sendRejoinNum =0;
-  int m_gotRejoinNum =0;
+  WqBackupParents m_backupParents;
+  std::string m_rejoinCandidate = ""; // the one backup parent asked, replies from others are stale
+  EventId m_rejoinEvent;
+  std::string m_graftInterest = "";  // graft asked by our upstream, answered once our rejoin settles
+  std::string m_graftCandidate = ""; // child asked to carry our subtree
+  std::vector<std::string> m_graftAsked; // children tried in the current repair
   std::string m_sendRejoinNode;
   std::string m_prePathID;
   std::string m_forwardDoubtCheck= "";
   std::string m_forwardSeqProcess= "";
   bool m_sendDoubtNode = false;
   shared_ptr<const Interest> m_normalInterest;
+  bool m_repliedUpstream = false; // echo for the tree being built already sent to the upstream
+  std::vector<shared_ptr<const Interest>> m_deferredTasks; // tasks that came before all children answered
   std::string m_pathIdInterest = "";
+  WqTreeCache m_treeCache;
+  std::string m_warmInterest = ""; // warm confirmation waiting for the children
+  std::string m_warmTree = "";     // tree restored from cache, not yet used by a task
+  int m_warmPending = 0;
+  bool m_warmOk = true;
+  EventId m_warmEvent; // a child silent for an Interest lifetime refuses the warm start
+  WqHeartbeatDetector m_heartbeat; // tree neighbours only
+  EventId m_heartbeatEvent;
   uint64_t m_countPathIdReply = 0;
   std::map<std::string, std::string> m_processedSeqData;
   bool m_upNodeFail = false;
@@ -77,10 +77,18 @@ WqSensor::GetTypeId(void)
 }
 
 WqSensor::WqSensor()
+  : m_valueRand(CreateObject<UniformRandomVariable>())
 {
   NS_LOG_FUNCTION_NOARGS();
 }
 
+int64_t
+WqSensor::AssignStreams(int64_t stream)
+{
+  m_valueRand->SetStream(stream);
+  return 1;
+}
+
 // inherited from Application base class.
 void
 WqSensor::StartApplication()
@@ -115,7 +123,7 @@ WqSensor::OnInterest(shared_ptr<const Interest> interest)
   data->setName(dataName);
   data->setFreshnessPeriod(::ndn::time::milliseconds(m_freshness.GetMilliSeconds()));
 
-  int ranNum = rand()%100 +1;
+  int ranNum = m_valueRand->GetInteger(1, 100);
 	std::string rawData = std::to_string(ranNum);  
 	//std::cout<< "Raw data: "<< rawData << std::endl;
 	uint8_t* p = (uint8_t*) &(*rawData.begin());
@@ -52,6 +52,9 @@ public:
   virtual void
   OnInterest(shared_ptr<const Interest> interest);
 
+  virtual int64_t
+  AssignStreams(int64_t stream);
+
 
 protected:
   // inherited from Application base class.
@@ -62,6 +65,7 @@ protected:
   StopApplication(); // Called at time specified by Stop
 
 private:
+  Ptr<UniformRandomVariable> m_valueRand; ///< @brief sensor readings
   Name m_prefix;
   Name m_postfix;
   uint32_t m_virtualPayloadSize;
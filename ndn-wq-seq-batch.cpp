@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#include "ndn-wq-seq-batch.hpp"
+
+#include <cstdlib>
+
+namespace ns3 {
+namespace ndn {
+
+bool
+WqSeqBatch::ParseRange(const std::string& seqFlag, uint32_t& first, uint32_t& last)
+{
+  uint64_t s = seqFlag.find("Seq");
+  if (s == std::string::npos || s + 3 >= seqFlag.size()) {
+    return false;
+  }
+  char* end = 0;
+  first = std::strtoul(seqFlag.c_str() + s + 3, &end, 10);
+  last = first;
+  if (*end == '~') {
+    last = std::strtoul(end + 1, &end, 10);
+  }
+  return last >= first;
+}
+
+std::string
+WqSeqBatch::RangeFlag(uint32_t first, uint32_t last)
+{
+  if (first == last) {
+    return "Seq" + std::to_string(first);
+  }
+  return "Seq" + std::to_string(first) + "~" + std::to_string(last);
+}
+
+std::vector<std::string>
+WqSeqBatch::Split(const std::string& data)
+{
+  std::vector<std::string> out;
+  uint64_t dash = data.find("-");
+  uint64_t tilde = data.find("~");
+  uint32_t first = 0;
+  uint32_t last = 0;
+  if (dash == std::string::npos || tilde == std::string::npos || tilde > dash
+      || !ParseRange(data.substr(0, dash), first, last)) {
+    out.push_back(data);
+    return out;
+  }
+
+  std::string values = data.substr(dash + 1);
+  uint32_t seq = first;
+  uint64_t pos = 0;
+  while (seq <= last) {
+    uint64_t bar = values.find("|", pos);
+    out.push_back("Seq" + std::to_string(seq) + "-" + values.substr(pos, bar - pos));
+    if (bar == std::string::npos) {
+      break;
+    }
+    pos = bar + 1;
+    seq++;
+  }
+  return out;
+}
+
+std::string
+WqSeqBatch::Join(uint32_t first, uint32_t last, const std::vector<std::string>& values)
+{
+  std::string out = RangeFlag(first, last) + "-";
+  for (uint64_t i = 0; i < values.size(); i++) {
+    if (i != 0) {
+      out += "|";
+    }
+    out += values[i];
+  }
+  return out;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+
+#ifndef NDN_WQ_SEQ_BATCH_H
+#define NDN_WQ_SEQ_BATCH_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Names and payloads of task batches
+ *
+ * A task Interest carries "(SeqA)" for one seq or "(SeqA~B)" for the range [A,B].
+ * The reply to a range is "SeqA~B-vA|vA+1|...|vB", one value per seq in order,
+ * so every hop can split it back into the single-seq form "SeqK-vK".
+ */
+class WqSeqBatch {
+public:
+  /**
+   * @param seqFlag "SeqA" or "SeqA~B"
+   */
+  static bool
+  ParseRange(const std::string& seqFlag, uint32_t& first, uint32_t& last);
+
+  static std::string
+  RangeFlag(uint32_t first, uint32_t last);
+
+  /**
+   * @brief "SeqA~B-..." -> "SeqA-vA", ..., anything else is returned as is
+   */
+  static std::vector<std::string>
+  Split(const std::string& data);
+
+  static std::string
+  Join(uint32_t first, uint32_t last, const std::vector<std::string>& values);
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
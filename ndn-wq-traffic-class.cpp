@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ndn-wq-traffic-class.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+bool
+WqTrafficClass::IsControlComponent(const std::string& component)
+{
+  // the keywords the apps dispatch on, each one starts the component of its message
+  static const char* controlKeys[] = {"rejoin", "Upfail", "downfail", "doubt", "resend", "recover", "st<",
+                                      "rollback", "promote", "standby", "replica", "newUp", "Cancel", "hb-",
+                                      "graft", "plan<", "tree-", "release", "adopt", "undo-", "cpLead",
+                                      "fill-", "warm("};
+  for (const char* key : controlKeys) {
+    if (component.compare(0, std::char_traits<char>::length(key), key) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+WqTrafficClass::Class
+WqTrafficClass::Classify(const std::string& name)
+{
+  uint64_t start = 0;
+  while (start < name.size()) {
+    uint64_t end = name.find("/", start + 1);
+    uint64_t from = (name[start] == '/') ? start + 1 : start;
+    if (IsControlComponent(name.substr(from, end == std::string::npos ? std::string::npos : end - from))) {
+      return CONTROL;
+    }
+    start = (end == std::string::npos) ? name.size() : end;
+  }
+  return DATA;
+}
+
+} // namespace ndn
+} // namespace ns3
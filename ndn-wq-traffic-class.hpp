@@ -0,0 +1,59 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef NDN_WQ_TRAFFIC_CLASS_H
+#define NDN_WQ_TRAFFIC_CLASS_H
+
+#include <string>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Priority class of WQ messages, a utility shared by the apps and the forwarder
+ *
+ * Recovery, tree and checkpoint messages (rejoin, fail notices, doubt/resend,
+ * recover, rollback, promote, new upstream, graft, standby, replica, plan,
+ * release, adopt, fill, warm, checkpoint lead) are CONTROL, everything else
+ * is DATA. The class is
+ * derived from the name only, so every hop classifies a packet the same way
+ * and a Data gets the class of the Interest it answers.
+ */
+class WqTrafficClass {
+public:
+  enum Class {
+    CONTROL = 0,
+    DATA = 1
+  };
+
+  /**
+   * @brief True if @p component (one name component, without the "/") starts with a
+   *        control keyword
+   */
+  static bool
+  IsControlComponent(const std::string& component);
+
+  static Class
+  Classify(const std::string& name);
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
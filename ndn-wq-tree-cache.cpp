@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ndn-wq-tree-cache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+void
+WqTreeCache::SetPath(const std::string& dir, const std::string& node, const std::string& sink)
+{
+  m_entries.clear();
+  if (dir.empty()) {
+    m_path = "";
+    return;
+  }
+  // names are "/x-", keep them readable in a file name
+  std::string file = "wq-tree" + node + sink + ".cache";
+  for (uint64_t i = 0; i < file.size(); i++) {
+    if (file[i] == '/') {
+      file[i] = '_';
+    }
+  }
+  m_path = dir + "/" + file;
+}
+
+bool
+WqTreeCache::IsEnabled() const
+{
+  return !m_path.empty();
+}
+
+bool
+WqTreeCache::Load(const std::string& fingerprint)
+{
+  m_entries.clear();
+  if (m_path.empty()) {
+    return false;
+  }
+  std::ifstream in(m_path.c_str());
+  std::string line;
+  if (!std::getline(in, line) || line != "fingerprint " + fingerprint) {
+    return false;
+  }
+  while (std::getline(in, line)) {
+    uint64_t sp = line.find(" ");
+    if (sp != std::string::npos) {
+      m_entries[line.substr(0, sp)] = line.substr(sp + 1);
+    }
+  }
+  return true;
+}
+
+void
+WqTreeCache::Save(const std::string& fingerprint) const
+{
+  if (m_path.empty()) {
+    return;
+  }
+  std::ofstream out(m_path.c_str(), std::ios_base::trunc);
+  out << "fingerprint " << fingerprint << std::endl;
+  for (std::map<std::string, std::string>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+    out << it->first << " " << it->second << std::endl;
+  }
+}
+
+std::string
+WqTreeCache::Get(const std::string& key) const
+{
+  std::map<std::string, std::string>::const_iterator it = m_entries.find(key);
+  return it == m_entries.end() ? "" : it->second;
+}
+
+void
+WqTreeCache::Set(const std::string& key, const std::string& value)
+{
+  m_entries[key] = value;
+}
+
+void
+WqTreeCache::Clear()
+{
+  m_entries.clear();
+}
+
+std::string
+WqTreeCache::JoinNames(const std::vector<std::string>& names)
+{
+  std::string joined;
+  for (uint64_t i = 0; i < names.size(); i++) {
+    joined += names[i];
+  }
+  return joined;
+}
+
+std::vector<std::string>
+WqTreeCache::SplitNames(const std::string& joined)
+{
+  // every name starts with "/" and ends with "-"
+  std::vector<std::string> names;
+  uint64_t start = joined.find("/");
+  while (start != std::string::npos) {
+    uint64_t end = joined.find("-", start);
+    if (end == std::string::npos) {
+      break;
+    }
+    names.push_back(joined.substr(start, end - start + 1));
+    start = joined.find("/", end);
+  }
+  return names;
+}
+
+std::string
+WqTreeCache::Fingerprint(const std::vector<std::string>& parts)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint64_t i = 0; i < parts.size(); i++) {
+    for (uint64_t k = 0; k <= parts[i].size(); k++) {
+      // the terminating 0 separates parts, so ("ab", "c") and ("a", "bc") differ
+      hash ^= (k < parts[i].size()) ? (uint8_t)parts[i][k] : 0;
+      hash *= 1099511628211ULL;
+    }
+  }
+  std::ostringstream hex;
+  hex << std::hex << hash;
+  return hex.str();
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2011-2015  Regents of the University of California.
+ *
+ * This file is part of ndnSIM. See AUTHORS for complete list of ndnSIM authors and
+ * contributors.
+ *
+ * ndnSIM is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ndnSIM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * ndnSIM, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef NDN_WQ_TREE_CACHE_H
+#define NDN_WQ_TREE_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Small on-disk cache of the tree state of one node for one sink
+ *
+ * One text file per (node, sink) in the cache directory: a fingerprint line,
+ * then "key value" lines. A warm start only trusts the entries when the stored
+ * fingerprint equals the one of the current topology, the protocol still
+ * confirms them with the neighbours before use.
+ */
+class WqTreeCache {
+public:
+  void
+  SetPath(const std::string& dir, const std::string& node, const std::string& sink);
+
+  bool
+  IsEnabled() const;
+
+  /**
+   * @brief Read the file, false when it is missing or was written for another fingerprint
+   */
+  bool
+  Load(const std::string& fingerprint);
+
+  void
+  Save(const std::string& fingerprint) const;
+
+  std::string
+  Get(const std::string& key) const;
+
+  void
+  Set(const std::string& key, const std::string& value);
+
+  void
+  Clear();
+
+  /**
+   * @brief Names joined without separator, the way job neighbour lists are written ("/a-/b-")
+   */
+  static std::string
+  JoinNames(const std::vector<std::string>& names);
+
+  static std::vector<std::string>
+  SplitNames(const std::string& joined);
+
+  /**
+   * @brief FNV-1a hash of the parts, as hex
+   */
+  static std::string
+  Fingerprint(const std::vector<std::string>& parts);
+
+private:
+  std::string m_path;
+  std::map<std::string, std::string> m_entries;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif
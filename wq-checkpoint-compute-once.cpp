@@ -21,6 +21,7 @@
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/ndnSIM-module.h"
+#include "ns3/ndnSIM/apps/ndn-wq-node-registry.hpp"
 #include "ns3/ndnSIM/helper/ndn-link-control-helper.hpp"
 
 namespace ns3 {
@@ -48,8 +49,18 @@ namespace ns3 {
 int
 main(int argc, char* argv[])
 {
+  // data-class packets per second per face, recovery traffic overtakes them (0: no priority egress)
+  double dataEgressRate = 0;
+  // benchmark runs: same seed and run give the same picks, readings and nonces
+  uint32_t seed = 1;
+  uint32_t run = 1;
   CommandLine cmd;
+  cmd.AddValue("seed", "Global random seed", seed);
+  cmd.AddValue("run", "Run number, independent replications of one seed", run);
+  cmd.AddValue("dataEgressRate", "Paced data-class packets/s per face under priority egress", dataEgressRate);
   cmd.Parse(argc, argv);
+  RngSeedManager::SetSeed(seed);
+  RngSeedManager::SetRun(run);
 
   AnnotatedTopologyReader topologyReader("", 25);
   topologyReader.SetFileName("src/ndnSIM/examples/topologies/wq-compute-once-topo2.txt");
@@ -59,6 +70,9 @@ main(int argc, char* argv[])
   ndn::StackHelper ndnHelper;
   ndnHelper.SetDefaultRoutes(true);
   ndnHelper.InstallAll();
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); node++) {
+    (*node)->GetObject<ndn::L3Protocol>()->getForwarder()->setDataEgressRate(dataEgressRate);
+  }
 
 	// Installing global routing interface on all nodes
   ndn::GlobalRoutingHelper ndnGlobalRoutingHelper;
@@ -97,6 +111,7 @@ main(int argc, char* argv[])
     producerHelper.SetPrefix(prefix);
     ApplicationContainer mapperNodes = producerHelper.Install(mappers[i]);
     ndnGlobalRoutingHelper.AddOrigins(prefix, mappers[i]);
+    ndn::WqNodeRegistry::Get().Add(prefix, "mapper", mappers[i]->GetId());
   }
 
   for (int j=0; j<9; j++) 
@@ -109,6 +124,7 @@ main(int argc, char* argv[])
     computeNodeHelper.SetPrefix(prefix);
     ApplicationContainer reducerNodes = computeNodeHelper.Install(reducers[j]);
     ndnGlobalRoutingHelper.AddOrigins(prefix, reducers[j]);
+    ndn::WqNodeRegistry::Get().Add(prefix, "reducer", reducers[j]->GetId());
   } 
 
   ndn::AppHelper consumerHelper("ns3::ndn::WqCheckpointSink");
@@ -117,10 +133,22 @@ main(int argc, char* argv[])
   consumerHelper.SetPrefix("/0-");
   consumerHelper.Install(consumer);
   ndnGlobalRoutingHelper.AddOrigins("/0-", consumer);  
+  ndn::WqNodeRegistry::Get().Add("/0-", "sink", consumer->GetId());
 
   // Calculate and install FIBs
   ndn::GlobalRoutingHelper::CalculateRoutes();
 
+  // each app draws from its own streams, numbered by node and app order
+  int64_t stream = 0;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); node++) {
+    for (uint32_t a = 0; a < (*node)->GetNApplications(); a++) {
+      Ptr<ndn::App> app = DynamicCast<ndn::App>((*node)->GetApplication(a));
+      if (app != 0) {
+        stream += app->AssignStreams(stream);
+      }
+    }
+  }
+
   // Simulator::Schedule(Seconds(2), ndn::LinkControlHelper::FailLinkByName, "/2-", "/m3-");
   // Simulator::Schedule(Seconds(3), ndn::LinkControlHelper::UpLinkByName, "/2-", "/m3-");
 
@@ -20,6 +20,7 @@
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/ndnSIM-module.h"
+#include "ns3/ndnSIM/apps/ndn-wq-node-registry.hpp"
 #include "ns3/ndnSIM/helper/ndn-link-control-helper.hpp"
 
 namespace ns3 {
@@ -59,8 +60,15 @@ namespace ns3 {
 int
 main(int argc, char* argv[])
 {
+  // benchmark runs: same seed and run give the same picks, readings and nonces
+  uint32_t seed = 1;
+  uint32_t run = 1;
   CommandLine cmd;
+  cmd.AddValue("seed", "Global random seed", seed);
+  cmd.AddValue("run", "Run number, independent replications of one seed", run);
   cmd.Parse(argc, argv);
+  RngSeedManager::SetSeed(seed);
+  RngSeedManager::SetRun(run);
 
   AnnotatedTopologyReader topologyReader("", 1);
   topologyReader.SetFileName("src/ndnSIM/examples/topologies/wq-compute-once-britetopo.txt");
@@ -119,6 +127,7 @@ main(int argc, char* argv[])
     producerHelper.SetPrefix(prefix);
     ApplicationContainer mapperNodes = producerHelper.Install(mappers[i]);
     ndnGlobalRoutingHelper.AddOrigins(prefix, mappers[i]);
+    ndn::WqNodeRegistry::Get().Add(prefix, "mapper", mappers[i]->GetId());
   
   }
   
@@ -131,6 +140,7 @@ main(int argc, char* argv[])
     computeNodeHelper.SetPrefix(prefix);
     ApplicationContainer reducerNodes = computeNodeHelper.Install(reducers[m]);
     ndnGlobalRoutingHelper.AddOrigins(prefix, reducers[m]);   
+    ndn::WqNodeRegistry::Get().Add(prefix, "reducer", reducers[m]->GetId());
   }
   
 
@@ -141,11 +151,23 @@ main(int argc, char* argv[])
   consumerHelper.SetPrefix("/0-");
   consumerHelper.Install(consumer);
   ndnGlobalRoutingHelper.AddOrigins("/0-", consumer);  
+  ndn::WqNodeRegistry::Get().Add("/0-", "sink", consumer->GetId());
 
  
   // Calculate and install FIBs
   ndn::GlobalRoutingHelper::CalculateRoutes();
 
+  // each app draws from its own streams, numbered by node and app order
+  int64_t stream = 0;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); node++) {
+    for (uint32_t a = 0; a < (*node)->GetNApplications(); a++) {
+      Ptr<ndn::App> app = DynamicCast<ndn::App>((*node)->GetApplication(a));
+      if (app != 0) {
+        stream += app->AssignStreams(stream);
+      }
+    }
+  }
+
   // Schedule simulation time and run the simulation
   Simulator::Stop(Seconds(20.0));
   ndn::L3RateTracer::InstallAll("wq-trace.txt", Seconds(1));